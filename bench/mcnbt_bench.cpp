@@ -0,0 +1,538 @@
+// The benchmarks of the whole codec: parse, write, SNBT write, gzip, copy, lookup, path and MCStructure construction,
+// over the small (level.dat like), medium (MCStructure of 16^3 blocks) and huge (region like, about 10 MiB) inputs.
+//
+// Usage: mcnbt_bench [options]
+//
+// Each benchmark runs the warm-up iterations first, then the timed repetitions, and reports the min, median,
+// percentiles and max of the repetitions with the throughput of median. Build it in release mode, the results
+// of debug build are marked in the output.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <fstream>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+
+#include <mcnbt/allocation.hpp>
+#include <mcnbt/corpus.hpp>
+#ifdef MCNBT_ENABLE_GZIP
+#include <mcnbt/gzip.hpp>
+#endif // MCNBT_ENABLE_GZIP
+
+#include "perf_counters.hpp"
+
+// Count the allocations of each benchmark. (See mcnbt/allocation.hpp)
+MCNBT_DEFINE_COUNTING_ALLOCATOR
+
+using namespace nbt;
+
+struct Options
+{
+    size_t warmups      = 2;
+    size_t repetitions  = 15;
+    String filter;      ///< Only run the benchmarks which full name (`<name>/<input>/<encoding>`) contains it.
+    bool isJson         = false;
+    bool isPerf         = false;    ///< Read the performance counters in an extra pass of the repetitions.
+    String output;      ///< The file to write the results, the stdout if empty.
+};
+
+struct Result
+{
+    String name;
+    String input;
+    String encoding;    ///< `big`, `little` or `-` if the benchmark is not related to the encoding.
+    size_t bytes;       ///< The bytes processed per iteration, 0 if not measured by bytes.
+    size_t items;       ///< The items processed per iteration (the tags of the input for the codec, the lookups,
+                        // the blocks and so on), 0 if not measured by items.
+    Vec<double> ns;     ///< The sorted time of the repetitions in nanoseconds.
+    AllocationStats allocs; ///< The allocations of an iteration.
+    bool hasCounters = false;
+    double counters[PC_COUNT];  ///< The mean counts per iteration, negative if the counter is unavailable.
+
+    double percentile(double p) const
+    {
+        // The nearest rank.
+        size_t rank = static_cast<size_t>(std::ceil(p / 100.0 * ns.size()));
+        return ns[rank == 0 ? 0 : rank - 1];
+    }
+
+    double median() const
+    {
+        size_t n = ns.size();
+        return n % 2 == 1 ? ns[n / 2] : (ns[n / 2 - 1] + ns[n / 2]) / 2;
+    }
+
+    double mean() const
+    {
+        double sum = 0;
+        for (double var : ns)
+            sum += var;
+        return sum / ns.size();
+    }
+
+    double bytesPerSecond() const   { return bytes * 1e9 / median(); }
+
+    double itemsPerSecond() const   { return items * 1e9 / median(); }
+
+    bool hasCounter(PerfCounter counter) const { return hasCounters && counters[counter] >= 0; }
+};
+
+// Keep the results of benchmarks from being optimized out.
+static volatile size_t g_sink = 0;
+
+class Harness
+{
+public:
+    explicit Harness(const Options& options) : options_(options)
+    {
+        if (!options.isPerf)
+            return;
+
+        perf_.reset(new PerfCounters());
+        if (!perf_->isAnyAvailable())
+        {
+            std::cerr << "The performance counters are unavailable (" << perf_->error() << "), ";
+            std::cerr << "only the time is measured." << std::endl;
+            perf_.reset();
+        }
+        else if (!perf_->error().empty())
+        {
+            std::cerr << "Some performance counters are unavailable (" << perf_->error() << ")." << std::endl;
+        }
+    }
+
+    const Vec<Result>& results() const { return results_; }
+
+    template <typename Func>
+    void run(const String& name, const String& input, const String& encoding, size_t bytes, size_t items,
+             Func func)
+    {
+        String fullname = name + "/" + input + "/" + encoding;
+        if (!options_.filter.empty() && fullname.find(options_.filter) == String::npos)
+            return;
+
+        for (size_t i = 0; i < options_.warmups; ++i)
+            func();
+
+        Result rslt;
+        rslt.name = name;
+        rslt.input = input;
+        rslt.encoding = encoding;
+        rslt.bytes = bytes;
+        rslt.items = items;
+        rslt.ns.reserve(options_.repetitions);
+
+        for (size_t i = 0; i < options_.repetitions; ++i)
+        {
+            auto beg = std::chrono::steady_clock::now();
+            func();
+            auto end = std::chrono::steady_clock::now();
+            rslt.ns.push_back(std::chrono::duration<double, std::nano>(end - beg).count());
+        }
+        std::sort(rslt.ns.begin(), rslt.ns.end());
+
+        rslt.allocs = countAllocations(func);
+
+        // Count the repetitions again, so the time is not affected by the counters.
+        if (perf_)
+        {
+            perf_->start();
+            for (size_t i = 0; i < options_.repetitions; ++i)
+                func();
+            perf_->stop(rslt.counters);
+
+            rslt.hasCounters = true;
+            for (int i = 0; i < PC_COUNT; ++i)
+            {
+                if (perf_->isAvailable(static_cast<PerfCounter>(i)))
+                    rslt.counters[i] /= options_.repetitions;
+                else
+                    rslt.counters[i] = -1;
+            }
+        }
+
+        if (!options_.isJson)
+            std::cerr << fullname << ": " << std::fixed << std::setprecision(3) << rslt.median() / 1e6 << " ms\n";
+        results_.push_back(std::move(rslt));
+    }
+
+private:
+    const Options& options_;
+    std::unique_ptr<PerfCounters> perf_;
+    Vec<Result> results_;
+};
+
+// The benchmarks.
+
+static void collectCompounds(const Tag& tag, Vec<const Tag*>& compounds)
+{
+    if (tag.isCompound())
+        compounds.push_back(&tag);
+
+    if (tag.isCompound() || (tag.isList() && (tag.listItemType() == TT_COMPOUND || tag.listItemType() == TT_LIST)))
+    {
+        for (size_t i = 0; i < tag.size(); ++i)
+            collectCompounds(tag.getTag(i), compounds);
+    }
+}
+
+/// @brief Make the compounds of the copy have their own data. (The copy shares the compounds until they are changed)
+static void detach(Tag& tag)
+{
+    if (tag.isCompound())
+        tag.reserve(tag.size());
+
+    if (tag.isCompound() || (tag.isList() && (tag.listItemType() == TT_COMPOUND || tag.listItemType() == TT_LIST)))
+    {
+        for (size_t i = 0; i < tag.size(); ++i)
+            detach(tag.getTag(i));
+    }
+}
+
+static size_t countTags(const Tag& tag)
+{
+    size_t count = 1;
+    if (tag.isCompound() || (tag.isList() && (tag.listItemType() == TT_COMPOUND || tag.listItemType() == TT_LIST)))
+    {
+        for (size_t i = 0; i < tag.size(); ++i)
+            count += countTags(tag.getTag(i));
+    }
+    else if (tag.isList())
+    {
+        count += tag.size();
+    }
+
+    return count;
+}
+
+static void runInput(Harness& harness, const String& input, const Tag& tag, int structureSize, const String& path)
+{
+    static const Encoding encodings[] = { EC_BIG_ENDIAN, EC_LITTLE_ENDIAN };
+    static const char* const encodingNames[] = { "big", "little" };
+    TagPath compiled(path);
+
+    // The size of binary is used as the size of the tag in memory.
+    size_t binSize = 0;
+    size_t tags = countTags(tag);
+    for (size_t e = 0; e < 2; ++e)
+    {
+        Encoding enc = encodings[e];
+        String bin;
+        tag.writeTo(bin, enc);
+        binSize = bin.size();
+
+        harness.run("parse", input, encodingNames[e], bin.size(), tags, [&]() {
+            BufferSource src(bin.data(), bin.size());
+            g_sink += Tag::fromSource(src, enc).size();
+        });
+
+        String out;
+        harness.run("write", input, encodingNames[e], bin.size(), tags, [&]() {
+            out.clear();
+            g_sink += tag.writeTo(out, enc);
+        });
+
+    #ifdef MCNBT_ENABLE_GZIP
+        String compressed = gzip::compress(bin);
+        harness.run("gzip_compress", input, encodingNames[e], bin.size(), 0, [&]() {
+            g_sink += gzip::compress(bin).size();
+        });
+
+        harness.run("gzip_decompress", input, encodingNames[e], bin.size(), 0, [&]() {
+            g_sink += gzip::decompress(compressed).size();
+        });
+    #endif // MCNBT_ENABLE_GZIP
+
+        harness.run("path_binary", input, encodingNames[e], bin.size(), tags, [&]() {
+            g_sink += compiled.selectBinary(bin.data(), bin.size(), enc).size();
+        });
+    }
+
+    // Only the SNBT writing, the SNBT parsing is not implemented yet. (See #Tag::fromSnbt())
+    String snbt = tag.toSnbt(false);
+    harness.run("snbt_write", input, "-", snbt.size(), tags, [&]() {
+        g_sink += tag.toSnbt(false).size();
+    });
+
+    harness.run("copy", input, "-", binSize, tags, [&]() {
+        g_sink += tag.copy().size();
+    });
+
+    harness.run("deep_copy", input, "-", binSize, tags, [&]() {
+        Tag copy = tag.copy();
+        detach(copy);
+        g_sink += copy.size();
+    });
+
+    // Look up each member of each compound by name.
+    Vec<const Tag*> compounds;
+    collectCompounds(tag, compounds);
+    Vec<std::pair<const Tag*, String>> lookups;
+    for (const Tag* var : compounds)
+    {
+        for (size_t i = 0; i < var->size(); ++i)
+            lookups.push_back(std::make_pair(var, var->getTag(i).name()));
+    }
+
+    harness.run("lookup", input, "-", 0, lookups.size(), [&]() {
+        for (const auto& var : lookups)
+            g_sink += static_cast<size_t>(var.first->getTag(var.second).type());
+    });
+
+    harness.run("path", input, "-", binSize, tags, [&]() {
+        g_sink += compiled.select(tag).size();
+    });
+
+    size_t blocks = static_cast<size_t>(structureSize) * structureSize * structureSize;
+    harness.run("mcstructure", input, "-", 0, blocks, [&]() {
+        g_sink += corpus::mcstructure(2, structureSize, structureSize, structureSize).size();
+    });
+}
+
+// The output.
+
+static String jsonString(const String& str)
+{
+    String rslt = "\"";
+    for (char ch : str)
+    {
+        if (ch == '"' || ch == '\\')
+            rslt.push_back('\\');
+        rslt.push_back(ch);
+    }
+    rslt.push_back('"');
+
+    return rslt;
+}
+
+/// @brief Write the available counters per iteration, and the ratios to the bytes and items.
+static void writeJsonCounters(std::ostream& os, const Result& rslt)
+{
+    const char* groups[] = { "counters", "per_byte", "per_item" };
+    size_t divisors[] = { 1, rslt.bytes, rslt.items };
+
+    for (size_t g = 0; g < 3; ++g)
+    {
+        if (divisors[g] == 0)
+            continue;
+
+        os << ", \"" << groups[g] << "\": {";
+        bool isFirst = true;
+        for (int i = 0; i < PC_COUNT; ++i)
+        {
+            PerfCounter counter = static_cast<PerfCounter>(i);
+            if (!rslt.hasCounter(counter))
+                continue;
+
+            os << (isFirst ? "" : ", ") << jsonString(getPerfCounterName(counter)) << ": ";
+            os << std::setprecision(g == 0 ? 1 : 4) << rslt.counters[i] / divisors[g];
+            isFirst = false;
+        }
+        os << "}";
+    }
+
+    if (rslt.hasCounter(PC_CYCLES) && rslt.hasCounter(PC_INSTRUCTIONS) && rslt.counters[PC_CYCLES] > 0)
+        os << ", \"ipc\": " << std::setprecision(3) << rslt.counters[PC_INSTRUCTIONS] / rslt.counters[PC_CYCLES];
+    os << std::setprecision(1);
+}
+
+static void writeJson(std::ostream& os, const Options& options, const Vec<Result>& results)
+{
+#ifdef NDEBUG
+    const char* build = "release";
+#else
+    const char* build = "debug";
+#endif // NDEBUG
+
+    os << std::fixed << std::setprecision(1);
+    os << "{\n";
+    os << "  \"version\": " << jsonString(MCNBT_VERSION) << ",\n";
+    os << "  \"build\": \"" << build << "\",\n";
+    os << "  \"warmups\": " << options.warmups << ",\n";
+    os << "  \"repetitions\": " << options.repetitions << ",\n";
+    os << "  \"results\": [";
+    for (size_t i = 0; i < results.size(); ++i)
+    {
+        const Result& rslt = results[i];
+        os << (i == 0 ? "\n" : ",\n");
+        os << "    {\"name\": " << jsonString(rslt.name) << ", \"input\": " << jsonString(rslt.input);
+        os << ", \"encoding\": " << jsonString(rslt.encoding);
+        os << ", \"bytes\": " << rslt.bytes << ", \"items\": " << rslt.items;
+        os << ", \"min_ns\": " << rslt.ns.front() << ", \"median_ns\": " << rslt.median();
+        os << ", \"mean_ns\": " << rslt.mean() << ", \"p90_ns\": " << rslt.percentile(90);
+        os << ", \"p99_ns\": " << rslt.percentile(99) << ", \"max_ns\": " << rslt.ns.back();
+        os << ", \"allocations\": " << rslt.allocs.allocations;
+        os << ", \"allocated_bytes\": " << rslt.allocs.allocatedBytes;
+        if (rslt.bytes != 0)
+            os << ", \"bytes_per_second\": " << rslt.bytesPerSecond();
+        if (rslt.items != 0)
+            os << ", \"items_per_second\": " << rslt.itemsPerSecond();
+        if (rslt.hasCounters)
+            writeJsonCounters(os, rslt);
+        os << "}";
+    }
+    os << "\n  ]\n}\n";
+}
+
+static void writeTable(std::ostream& os, const Vec<Result>& results)
+{
+#ifndef NDEBUG
+    os << "Warning: the benchmarks are built in debug mode.\n";
+#endif // !NDEBUG
+
+    os << std::left << std::setw(40) << "benchmark" << std::right;
+    os << std::setw(12) << "min(ms)" << std::setw(12) << "median(ms)" << std::setw(12) << "p90(ms)";
+    os << std::setw(12) << "max(ms)" << std::setw(16) << "throughput" << std::setw(12) << "allocs";
+    os << std::setw(14) << "alloc(KiB)" << "\n";
+
+    os << std::fixed << std::setprecision(3);
+    for (const auto& rslt : results)
+    {
+        os << std::left << std::setw(40) << (rslt.name + "/" + rslt.input + "/" + rslt.encoding) << std::right;
+        os << std::setw(12) << rslt.ns.front() / 1e6 << std::setw(12) << rslt.median() / 1e6;
+        os << std::setw(12) << rslt.percentile(90) / 1e6 << std::setw(12) << rslt.ns.back() / 1e6;
+
+        SStream throughput;
+        throughput << std::fixed << std::setprecision(1);
+        if (rslt.bytes != 0)
+            throughput << rslt.bytesPerSecond() / (1024 * 1024) << " MiB/s";
+        else
+            throughput << rslt.itemsPerSecond() / 1e6 << " M/s";
+        os << std::setw(16) << throughput.str() << std::setw(12) << rslt.allocs.allocations;
+        os << std::setw(14) << rslt.allocs.allocatedBytes / 1024.0 << "\n";
+    }
+
+    bool hasCounters = false;
+    for (const auto& rslt : results)
+        hasCounters = hasCounters || rslt.hasCounters;
+    if (!hasCounters)
+        return;
+
+    // The ratios of the counters, `-` if unavailable.
+    static const char* const headers[] = {
+        "IPC", "cycles/B", "instrs/B", "cycles/item", "br-miss/item", "L1D-miss/item", "LLC-miss/item", "faults"
+    };
+
+    os << "\n" << std::left << std::setw(40) << "benchmark" << std::right;
+    for (const char* var : headers)
+        os << std::setw(15) << var;
+    os << "\n";
+
+    for (const auto& rslt : results)
+    {
+        if (!rslt.hasCounters)
+            continue;
+
+        const double* counts = rslt.counters;
+        double values[] = {
+            counts[PC_CYCLES] > 0 ? counts[PC_INSTRUCTIONS] / counts[PC_CYCLES] : -1,
+            rslt.bytes != 0 ? counts[PC_CYCLES] / rslt.bytes : -1,
+            rslt.bytes != 0 ? counts[PC_INSTRUCTIONS] / rslt.bytes : -1,
+            rslt.items != 0 ? counts[PC_CYCLES] / rslt.items : -1,
+            rslt.items != 0 ? counts[PC_BRANCH_MISSES] / rslt.items : -1,
+            rslt.items != 0 ? counts[PC_L1D_MISSES] / rslt.items : -1,
+            rslt.items != 0 ? counts[PC_LLC_MISSES] / rslt.items : -1,
+            counts[PC_PAGE_FAULTS]
+        };
+        PerfCounter sources[] = {
+            PC_INSTRUCTIONS, PC_CYCLES, PC_INSTRUCTIONS, PC_CYCLES,
+            PC_BRANCH_MISSES, PC_L1D_MISSES, PC_LLC_MISSES, PC_PAGE_FAULTS
+        };
+
+        os << std::left << std::setw(40) << (rslt.name + "/" + rslt.input + "/" + rslt.encoding) << std::right;
+        for (size_t i = 0; i < sizeof(values) / sizeof(values[0]); ++i)
+        {
+            bool isAvailable = values[i] >= 0 && rslt.hasCounter(sources[i]) &&
+                               (i != 0 || rslt.hasCounter(PC_CYCLES));
+            if (isAvailable)
+                os << std::setw(15) << values[i];
+            else
+                os << std::setw(15) << "-";
+        }
+        os << "\n";
+    }
+}
+
+static void usage()
+{
+    std::cerr <<
+        "Usage: mcnbt_bench [options]\n"
+        "Options:\n"
+        "  -w, --warmups <count>        The count of warm-up iterations. (default: 2)\n"
+        "  -r, --repetitions <count>    The count of timed repetitions. (default: 15)\n"
+        "  -f, --filter <text>          Only run the benchmarks which name/input/encoding contains the text.\n"
+        "  -j, --json                   Output the results as JSON.\n"
+        "  -p, --perf                   Read the performance counters (Linux only), in an extra pass.\n"
+        "  -o, --output <file>          Write the results to the file instead of the stdout.\n";
+}
+
+static bool parseArgs(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        String arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if ((arg == "-w" || arg == "--warmups") && hasValue)
+            options.warmups = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        else if ((arg == "-r" || arg == "--repetitions") && hasValue)
+            options.repetitions = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        else if ((arg == "-f" || arg == "--filter") && hasValue)
+            options.filter = argv[++i];
+        else if (arg == "-j" || arg == "--json")
+            options.isJson = true;
+        else if (arg == "-p" || arg == "--perf")
+            options.isPerf = true;
+        else if ((arg == "-o" || arg == "--output") && hasValue)
+            options.output = argv[++i];
+        else
+            return false;
+    }
+
+    return options.repetitions != 0;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseArgs(argc, argv, options))
+    {
+        usage();
+        return 2;
+    }
+
+    try
+    {
+        Harness harness(options);
+        // The inputs are generated, same on all platforms. (See mcnbt/corpus.hpp)
+        runInput(harness, "small", corpus::level(1), 4, "Data.Player.Inventory[*][id='minecraft:stone']");
+        runInput(harness, "medium", corpus::mcstructure(2, 16, 16, 16), 16,
+                 "structure.palette.default.block_palette[*].name");
+        runInput(harness, "huge", corpus::region(3, 256), 64, "chunks[*].sections[*].block_states.palette[0].name");
+
+        std::ofstream ofs;
+        if (!options.output.empty())
+        {
+            ofs.open(options.output);
+            if (!ofs.is_open())
+                throw std::runtime_error("Failed to open file: " + options.output);
+        }
+        std::ostream& os = options.output.empty() ? std::cout : ofs;
+
+        if (options.isJson)
+            writeJson(os, options, harness.results());
+        else
+            writeTable(os, harness.results());
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,184 @@
+// The hardware and software performance counters of the calling thread by the Linux perf_event_open(2), without
+// any external tool. The counters which can't be opened (e.g. not supported by the CPU or virtual machine, or
+// not permitted by /proc/sys/kernel/perf_event_paranoid) are unavailable, and all are unavailable on other systems.
+
+#ifndef MCNBT_BENCH_PERF_COUNTERS_HPP
+#define MCNBT_BENCH_PERF_COUNTERS_HPP
+
+#include <cstdint>
+#include <cstring>
+#include <string>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#include <cerrno>
+#endif // __linux__
+
+enum PerfCounter
+{
+    PC_CYCLES,
+    PC_INSTRUCTIONS,
+    PC_BRANCH_MISSES,
+    PC_L1D_MISSES,
+    PC_LLC_MISSES,
+    PC_PAGE_FAULTS,
+    PC_COUNT
+};
+
+inline const char* getPerfCounterName(PerfCounter counter)
+{
+    switch (counter)
+    {
+        case PC_CYCLES:         return "cycles";
+        case PC_INSTRUCTIONS:   return "instructions";
+        case PC_BRANCH_MISSES:  return "branch_misses";
+        case PC_L1D_MISSES:     return "l1d_misses";
+        case PC_LLC_MISSES:     return "llc_misses";
+        case PC_PAGE_FAULTS:    return "page_faults";
+        default:                return "unknown";
+    }
+}
+
+class PerfCounters
+{
+public:
+    /// @brief Open the counters of the calling thread, only the user space is counted.
+    PerfCounters()
+    {
+        for (int i = 0; i < PC_COUNT; ++i)
+            fds_[i] = -1;
+
+    #ifdef __linux__
+        for (int i = 0; i < PC_COUNT; ++i)
+        {
+            perf_event_attr attr;
+            std::memset(&attr, 0, sizeof(attr));
+            attr.size = sizeof(attr);
+            attr.disabled = 1;
+            attr.exclude_kernel = 1;
+            attr.exclude_hv = 1;
+            // Scale the counts if the counters are multiplexed.
+            attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+            getConfig_(static_cast<PerfCounter>(i), attr.type, attr.config);
+
+            fds_[i] = static_cast<int>(::syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+            if (fds_[i] < 0 && error_.empty())
+                error_ = std::string(getPerfCounterName(static_cast<PerfCounter>(i))) + ": " + std::strerror(errno);
+        }
+    #else
+        error_ = "perf_event_open is only available on Linux";
+    #endif // __linux__
+    }
+
+    ~PerfCounters()
+    {
+    #ifdef __linux__
+        for (int i = 0; i < PC_COUNT; ++i)
+        {
+            if (fds_[i] >= 0)
+                ::close(fds_[i]);
+        }
+    #endif // __linux__
+    }
+
+    PerfCounters(const PerfCounters&) = delete;
+    PerfCounters& operator=(const PerfCounters&) = delete;
+
+    bool isAvailable(PerfCounter counter) const { return fds_[counter] >= 0; }
+
+    bool isAnyAvailable() const
+    {
+        for (int i = 0; i < PC_COUNT; ++i)
+        {
+            if (fds_[i] >= 0)
+                return true;
+        }
+
+        return false;
+    }
+
+    /// @brief Get the reason of the first counter can't be opened, empty if all are available.
+    const std::string& error() const { return error_; }
+
+    /// @brief Reset and start the counters.
+    void start()
+    {
+    #ifdef __linux__
+        for (int i = 0; i < PC_COUNT; ++i)
+        {
+            if (fds_[i] < 0)
+                continue;
+
+            ::ioctl(fds_[i], PERF_EVENT_IOC_RESET, 0);
+            ::ioctl(fds_[i], PERF_EVENT_IOC_ENABLE, 0);
+        }
+    #endif // __linux__
+    }
+
+    /// @brief Stop the counters and get the counts since #start(), 0 for the unavailable counters.
+    void stop(double (&counts)[PC_COUNT])
+    {
+        for (int i = 0; i < PC_COUNT; ++i)
+            counts[i] = 0;
+
+    #ifdef __linux__
+        for (int i = 0; i < PC_COUNT; ++i)
+        {
+            if (fds_[i] >= 0)
+                ::ioctl(fds_[i], PERF_EVENT_IOC_DISABLE, 0);
+        }
+
+        for (int i = 0; i < PC_COUNT; ++i)
+        {
+            // The value, time enabled and time running.
+            uint64_t values[3] = { 0, 0, 0 };
+            if (fds_[i] < 0 || ::read(fds_[i], values, sizeof(values)) != static_cast<ssize_t>(sizeof(values)))
+                continue;
+
+            counts[i] = values[2] == 0 ? 0 : values[0] * (static_cast<double>(values[1]) / values[2]);
+        }
+    #endif // __linux__
+    }
+
+private:
+#ifdef __linux__
+    static void getConfig_(PerfCounter counter, __u32& type, __u64& config)
+    {
+        type = PERF_TYPE_HARDWARE;
+        switch (counter)
+        {
+            case PC_CYCLES:
+                config = PERF_COUNT_HW_CPU_CYCLES;
+                break;
+            case PC_INSTRUCTIONS:
+                config = PERF_COUNT_HW_INSTRUCTIONS;
+                break;
+            case PC_BRANCH_MISSES:
+                config = PERF_COUNT_HW_BRANCH_MISSES;
+                break;
+            case PC_L1D_MISSES:
+                type = PERF_TYPE_HW_CACHE;
+                config = PERF_COUNT_HW_CACHE_L1D | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+            case PC_LLC_MISSES:
+                type = PERF_TYPE_HW_CACHE;
+                config = PERF_COUNT_HW_CACHE_LL | (PERF_COUNT_HW_CACHE_OP_READ << 8) |
+                         (PERF_COUNT_HW_CACHE_RESULT_MISS << 16);
+                break;
+            default:
+                type = PERF_TYPE_SOFTWARE;
+                config = PERF_COUNT_SW_PAGE_FAULTS;
+                break;
+        }
+    }
+#endif // __linux__
+
+    int fds_[PC_COUNT];
+    std::string error_;
+};
+
+#endif // !MCNBT_BENCH_PERF_COUNTERS_HPP
@@ -92,6 +92,47 @@ void test1()
     out("-After Value: ");
     out(nested);
 
+    // Valid assignment, the member is in the data shared with the copy of parent.
+    out("<Valid assignment> (Copy shared parent to self)");
+
+    out("-Before Value: ");
+    out(nested);
+
+    try
+    {
+        Tag& member = nested[0];
+        Tag copy = nested;
+        member = copy;
+        nested[0][0] = nested.copy();
+    }
+    catch (std::exception& e)
+    {
+        out(e.what());
+    }
+
+    out("-After Value: ");
+    out(nested);
+
+    // Valid add, the member is got before the parent is copied.
+    out("<Valid add> (Add copy of parent to self)");
+
+    out("-Before Value: ");
+    out(nested);
+
+    try
+    {
+        Tag& member = nested[0];
+        Tag copy = nested;
+        member << copy.copy().setName("loop");
+    }
+    catch (std::exception& e)
+    {
+        out(e.what());
+    }
+
+    out("-After Value: ");
+    out(nested);
+
     // Assign to self.
     out("<Assign to self>");
 
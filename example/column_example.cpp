@@ -0,0 +1,47 @@
+#include <iostream>
+
+#include <mcnbt/column.hpp>
+
+using namespace nbt;
+
+int main()
+{
+    Tag root = gCompound();
+    Tag structure = gCompound("structure");
+    Tag entities = gList(TT_COMPOUND, "entities");
+    for (int i = 0; i < 4; ++i)
+    {
+        Tag entity = gCompound();
+        entity << (gList(TT_FLOAT, "Pos") << gFloat(i + 0.5f) << gFloat(64.0f) << gFloat(-i - 0.5f));
+        entity << gLong(-4294967296LL + i, "UniqueID");
+        entity << gString(i % 2 == 0 ? "minecraft:cow" : "minecraft:pig", "identifier");
+        if (i == 2)
+            entity << gString("Bessie", "CustomName");
+        entities << entity;
+    }
+    root << (structure << entities);
+
+    // Each member name is a column, the values are stored contiguously by type.
+    ColumnTable table = ColumnTable::fromTag(root, TagPath("structure.entities"));
+    const Column& pos = *table.column("Pos");
+    const Vec<Fp32>& xyz = pos.values<Fp32>();
+    for (size_t i = 0; i < table.rowCount(); ++i)
+        std::cout << "Pos of entity " << i << ": " << xyz[i * 3] << ", " << xyz[i * 3 + 1] << ", " << xyz[i * 3 + 2]
+                  << std::endl;
+
+    const Column& identifier = *table.column("identifier");
+    std::cout << "Distinct identifiers: " << identifier.dict.size() << std::endl;
+
+    const Column& name = *table.column("CustomName");
+    for (size_t i = 0; i < table.rowCount(); ++i)
+        std::cout << "CustomName of entity " << i << ": " << (name.isNull(i) ? "null" : name.dict[name.codes[i]])
+                  << std::endl;
+
+    // Save the columns as the binary columnar file, then get the list of compounds back.
+    std::string filename = "./column_example.col";
+    table.write(filename);
+    Tag list = ColumnTable::fromFile(filename).toTag();
+    std::cout << list.toSnbt(false) << std::endl;
+
+    return 0;
+}
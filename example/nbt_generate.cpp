@@ -0,0 +1,183 @@
+// Generate the synthetic NBT documents for the benchmarks and stress tests. (See mcnbt/corpus.hpp)
+//
+// Usage: nbt_generate [options] <kind> <output>
+//
+// e.g. Generate 100 region like files of 10 MiB (1 GiB in total) in the directory:
+// nbt_generate -S 10M -n 100 region ./corpus
+//
+// The same seed and options always generate the same files, the file i is generated by the seed + i.
+
+#include <cstdlib>
+#include <iostream>
+
+#ifdef _WIN32
+#include <direct.h>
+#else
+#include <sys/stat.h>
+#endif
+
+#include <mcnbt/corpus.hpp>
+
+using namespace nbt;
+
+struct Options
+{
+    corpus::DocumentKind kind   = corpus::DK_LEVEL;
+    UInt64 seed                 = 0;
+    size_t size                 = 1 << 20;
+    size_t count                = 0;    ///< The count of files in the output directory, 0 if the output is a file.
+    Encoding enc                = EC_BIG_ENDIAN;
+    bool isCompressed           = false;
+    String output;
+};
+
+static void usage()
+{
+    std::cerr <<
+        "Usage: nbt_generate [options] <kind> <output>\n"
+        "Kinds: level, nested, wide, long_arrays, entities, block_palette, mcstructure, region\n"
+        "Options:\n"
+        "  -s, --seed <number>                  The seed. (default: 0)\n"
+        "  -S, --size <bytes>[K|M|G]            The approximate size of each file before compress. (default: 1M)\n"
+        "  -n, --count <count>                  Generate the files in the output directory. (default: 1 file)\n"
+        "  -e, --encoding <big|little|network>  The encoding of the files. (default: big, little for mcstructure)\n"
+#ifdef MCNBT_ENABLE_GZIP
+        "  -z, --compress                       Compress the files with gzip.\n"
+#endif // MCNBT_ENABLE_GZIP
+        ;
+}
+
+static bool parseSize(const String& str, size_t& size)
+{
+    char* end = nullptr;
+    UInt64 value = std::strtoull(str.c_str(), &end, 10);
+    if (end == str.c_str())
+        return false;
+
+    String unit = end;
+    if (unit == "K" || unit == "k")
+        value <<= 10;
+    else if (unit == "M" || unit == "m")
+        value <<= 20;
+    else if (unit == "G" || unit == "g")
+        value <<= 30;
+    else if (!unit.empty())
+        return false;
+
+    size = static_cast<size_t>(value);
+    return true;
+}
+
+static bool parseArgs(int argc, char** argv, Options& options)
+{
+    Vec<String> positionals;
+    bool hasEncoding = false;
+    for (int i = 1; i < argc; ++i)
+    {
+        String arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if ((arg == "-s" || arg == "--seed") && hasValue)
+        {
+            options.seed = std::strtoull(argv[++i], nullptr, 10);
+        }
+        else if ((arg == "-S" || arg == "--size") && hasValue)
+        {
+            if (!parseSize(argv[++i], options.size))
+                return false;
+        }
+        else if ((arg == "-n" || arg == "--count") && hasValue)
+        {
+            options.count = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if ((arg == "-e" || arg == "--encoding") && hasValue)
+        {
+            String value = argv[++i];
+            if (value == "big")
+                options.enc = EC_BIG_ENDIAN;
+            else if (value == "little")
+                options.enc = EC_LITTLE_ENDIAN;
+            else if (value == "network")
+                options.enc = EC_NETWORK;
+            else
+                return false;
+            hasEncoding = true;
+        }
+    #ifdef MCNBT_ENABLE_GZIP
+        else if (arg == "-z" || arg == "--compress")
+        {
+            options.isCompressed = true;
+        }
+    #endif // MCNBT_ENABLE_GZIP
+        else if (arg.size() > 1 && arg[0] == '-')
+        {
+            return false;
+        }
+        else
+        {
+            positionals.push_back(arg);
+        }
+    }
+
+    if (positionals.size() != 2 || !corpus::getDocumentKind(positionals[0], options.kind))
+        return false;
+
+    // The MCStructure is the file of Bedrock Edition.
+    if (!hasEncoding && options.kind == corpus::DK_MCSTRUCTURE)
+        options.enc = EC_LITTLE_ENDIAN;
+
+    options.output = positionals[1];
+    return true;
+}
+
+static void writeFile(const Options& options, UInt64 seed, const String& filename)
+{
+    Tag tag = corpus::generate(options.kind, seed, options.size);
+#ifdef MCNBT_ENABLE_GZIP
+    tag.write(filename, options.enc, options.isCompressed);
+#else
+    tag.write(filename, options.enc);
+#endif // MCNBT_ENABLE_GZIP
+
+    std::cout << filename << ": " << tag.binarySize(options.enc) << " bytes" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseArgs(argc, argv, options))
+    {
+        usage();
+        return 2;
+    }
+
+    try
+    {
+        if (options.count == 0)
+        {
+            writeFile(options, options.seed, options.output);
+            return 0;
+        }
+
+    #ifdef _WIN32
+        ::_mkdir(options.output.c_str());
+    #else
+        ::mkdir(options.output.c_str(), 0755);
+    #endif // _WIN32
+
+        String ext = options.kind == corpus::DK_MCSTRUCTURE ? ".mcstructure" : ".nbt";
+        for (size_t i = 0; i < options.count; ++i)
+        {
+            String filename = options.output + "/" + corpus::getDocumentKindName(options.kind) + "_" +
+                              std::to_string(i) + ext;
+            writeFile(options, options.seed + i, filename);
+        }
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,324 @@
+// Profile where the bytes of many nbt files go, by the normalized paths of tags. (See mcnbt/profile.hpp)
+//
+// Usage: nbt_profile [options] <file or directory>...
+//
+// e.g. Find the paths which make the structures large, and how well they compress:
+// nbt_profile -e little -z -n 20 ./structures
+//
+// The files are walked in binary by the threads without construct the tags, each thread profiles the files it
+// takes, then the profiles are added together. The paths are ranked by their contribution (the bytes of the tags
+// exclude their children by default), so the bytes of all paths sum to the bytes of the files.
+
+#include <atomic>
+#include <cstdlib>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <thread>
+#include <algorithm>
+
+#include <mcnbt/profile.hpp>
+
+#include "tool_util.hpp"
+
+using namespace nbt;
+
+enum SortKey
+{
+    SORT_SELF,          ///< The bytes of tags exclude their children.
+    SORT_BYTES,         ///< The bytes of tags include their children.
+    SORT_COUNT,         ///< The count of tags.
+    SORT_MAX,           ///< The max bytes of a tag.
+    SORT_COMPRESSED     ///< The estimated compressed bytes.
+};
+
+enum Format
+{
+    FORMAT_TABLE,
+    FORMAT_CSV
+};
+
+struct Options
+{
+    Encoding enc        = EC_BIG_ENDIAN;
+    size_t headerSize   = 0;
+    size_t jobs         = 0;
+    size_t top          = 30;
+    SortKey sort        = SORT_SELF;
+    Format format       = FORMAT_TABLE;
+    bool isCompressedEstimated = false;
+    Vec<String> inputs;
+};
+
+static void usage()
+{
+    std::cerr <<
+        "Usage: nbt_profile [options] <file or directory>...\n"
+        "Options:\n"
+        "  -e, --encoding <big|little|network>  The encoding of the files. (default: big)\n"
+        "  -H, --header <size>                  The size of the header before the root tag. (default: 0)\n"
+        "  -j, --jobs <count>                   The count of threads. (default: count of cores)\n"
+        "  -n, --top <count>                    The count of paths to output, 0 for all. (default: 30)\n"
+        "  -s, --sort <self|bytes|count|max|compressed>\n"
+        "                                       The key to rank the paths. (default: self)\n"
+        "  -f, --format <table|csv>             The output format. (default: table)\n"
+#ifdef MCNBT_ENABLE_GZIP
+        "  -z, --compressed                     Estimate the compressed bytes of each path.\n"
+#endif // MCNBT_ENABLE_GZIP
+        ;
+}
+
+static bool parseArgs(int argc, char** argv, Options& options)
+{
+    for (int i = 1; i < argc; ++i)
+    {
+        String arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if ((arg == "-e" || arg == "--encoding") && hasValue)
+        {
+            String value = argv[++i];
+            if (value == "big")
+                options.enc = EC_BIG_ENDIAN;
+            else if (value == "little")
+                options.enc = EC_LITTLE_ENDIAN;
+            else if (value == "network")
+                options.enc = EC_NETWORK;
+            else
+                return false;
+        }
+        else if ((arg == "-H" || arg == "--header") && hasValue)
+        {
+            options.headerSize = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if ((arg == "-j" || arg == "--jobs") && hasValue)
+        {
+            options.jobs = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if ((arg == "-n" || arg == "--top") && hasValue)
+        {
+            options.top = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if ((arg == "-s" || arg == "--sort") && hasValue)
+        {
+            String value = argv[++i];
+            if (value == "self")
+                options.sort = SORT_SELF;
+            else if (value == "bytes")
+                options.sort = SORT_BYTES;
+            else if (value == "count")
+                options.sort = SORT_COUNT;
+            else if (value == "max")
+                options.sort = SORT_MAX;
+            else if (value == "compressed")
+                options.sort = SORT_COMPRESSED;
+            else
+                return false;
+        }
+        else if ((arg == "-f" || arg == "--format") && hasValue)
+        {
+            String value = argv[++i];
+            if (value == "table")
+                options.format = FORMAT_TABLE;
+            else if (value == "csv")
+                options.format = FORMAT_CSV;
+            else
+                return false;
+        }
+    #ifdef MCNBT_ENABLE_GZIP
+        else if (arg == "-z" || arg == "--compressed")
+        {
+            options.isCompressedEstimated = true;
+        }
+    #endif // MCNBT_ENABLE_GZIP
+        else if (arg.size() > 1 && arg[0] == '-')
+        {
+            return false;
+        }
+        else
+        {
+            options.inputs.push_back(arg);
+        }
+    }
+
+    return !options.inputs.empty() && (options.sort != SORT_COMPRESSED || options.isCompressedEstimated);
+}
+
+static UInt64 sortValue(const PathProfile& profile, SortKey key)
+{
+    switch (key)
+    {
+        case SORT_BYTES:        return profile.bytes;
+        case SORT_COUNT:        return profile.count;
+        case SORT_MAX:          return profile.maxBytes;
+        case SORT_COMPRESSED:   return profile.compressedBytes;
+        default:                return profile.selfBytes;
+    }
+}
+
+static String typeName(TagType type)
+{
+    return type == TT_END ? "Mixed" : getTagTypeString(type);
+}
+
+static String percent(UInt64 part, UInt64 total)
+{
+    SStream ss;
+    ss << std::fixed << std::setprecision(2) << (total == 0 ? 0.0 : part * 100.0 / total) << '%';
+    return ss.str();
+}
+
+class Profiler
+{
+public:
+    explicit Profiler(const Options& options) : options_(options), profile_(options.isCompressedEstimated) {}
+
+    /// @brief Profile the files by the threads, return the count of files failed.
+    size_t run(const Vec<String>& files)
+    {
+        size_t jobs = options_.jobs != 0 ? options_.jobs : std::thread::hardware_concurrency();
+        jobs = std::max<size_t>(1, std::min(jobs, files.size()));
+
+        Vec<std::thread> threads;
+        for (size_t i = 0; i < jobs; ++i)
+            threads.push_back(std::thread(&Profiler::work, this, std::cref(files)));
+
+        for (auto& thread : threads)
+            thread.join();
+
+        return failed_;
+    }
+
+    void write(std::ostream& os) const
+    {
+        auto paths = profile_.paths();
+        SortKey key = options_.sort;
+        std::stable_sort(paths.begin(), paths.end(),
+                         [key](const std::pair<String, PathProfile>& lhs, const std::pair<String, PathProfile>& rhs)
+        { return sortValue(lhs.second, key) > sortValue(rhs.second, key); });
+
+        if (options_.top != 0 && paths.size() > options_.top)
+            paths.resize(options_.top);
+
+        if (options_.format == FORMAT_CSV)
+            writeCsv(os, paths);
+        else
+            writeTable(os, paths);
+    }
+
+private:
+    void work(const Vec<String>& files)
+    {
+        Profile profile(options_.isCompressedEstimated);
+        for (;;)
+        {
+            size_t idx = next_.fetch_add(1);
+            if (idx >= files.size())
+                break;
+
+            try
+            {
+                profile.addFile(files[idx], options_.enc, options_.headerSize);
+            }
+            catch (const std::exception& e)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                std::cerr << files[idx] << ": " << e.what() << std::endl;
+                ++failed_;
+            }
+        }
+
+        std::lock_guard<std::mutex> lock(mutex_);
+        profile_.merge(profile);
+    }
+
+    void writeTable(std::ostream& os, const Vec<std::pair<String, PathProfile>>& paths) const
+    {
+        UInt64 total = profile_.bytes();
+        os << "documents: " << profile_.documentCount() << ", nbt bytes: " << total;
+        os << ", file bytes: " << profile_.fileBytes() << " (" << percent(profile_.fileBytes(), total) << ")\n";
+
+        if (options_.isCompressedEstimated)
+        {
+            UInt64 compressed = 0;
+            for (const auto& var : profile_.paths())
+                compressed += var.second.compressedBytes;
+            os << "compressed bytes by path: " << compressed << " (" << percent(compressed, total) << ")\n";
+        }
+
+        os << "\n" << std::right << std::setw(14) << "self" << std::setw(9) << "self%";
+        os << std::setw(14) << "bytes" << std::setw(9) << "bytes%" << std::setw(12) << "count";
+        os << std::setw(12) << "max bytes" << std::setw(10) << "max size";
+        if (options_.isCompressedEstimated)
+            os << std::setw(14) << "compressed" << std::setw(9) << "ratio";
+        os << "  " << std::left << std::setw(11) << "type" << "path\n";
+
+        for (const auto& var : paths)
+        {
+            const PathProfile& profile = var.second;
+            os << std::right << std::setw(14) << profile.selfBytes << std::setw(9) << percent(profile.selfBytes, total);
+            os << std::setw(14) << profile.bytes << std::setw(9) << percent(profile.bytes, total);
+            os << std::setw(12) << profile.count << std::setw(12) << profile.maxBytes;
+            os << std::setw(10) << profile.maxSize;
+            if (options_.isCompressedEstimated)
+            {
+                os << std::setw(14) << profile.compressedBytes;
+                os << std::setw(9) << percent(profile.compressedBytes, profile.selfBytes);
+            }
+            os << "  " << std::left << std::setw(11) << typeName(profile.type);
+            os << (var.first.empty() ? "(root)" : var.first) << "\n";
+        }
+    }
+
+    void writeCsv(std::ostream& os, const Vec<std::pair<String, PathProfile>>& paths) const
+    {
+        os << "path,type,count,self_bytes,bytes,max_bytes,max_size";
+        if (options_.isCompressedEstimated)
+            os << ",compressed_bytes";
+        os << "\n";
+
+        for (const auto& var : paths)
+        {
+            const PathProfile& profile = var.second;
+            os << csvField(var.first) << ',' << typeName(profile.type) << ',' << profile.count << ',';
+            os << profile.selfBytes << ',' << profile.bytes << ',' << profile.maxBytes << ',' << profile.maxSize;
+            if (options_.isCompressedEstimated)
+                os << ',' << profile.compressedBytes;
+            os << "\n";
+        }
+    }
+
+    const Options& options_;
+    Profile profile_;
+    std::atomic<size_t> next_{ 0 };
+    std::mutex mutex_;
+    size_t failed_ = 0;
+};
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseArgs(argc, argv, options))
+    {
+        usage();
+        return 2;
+    }
+
+    try
+    {
+        Vec<String> files;
+        for (const auto& input : options.inputs)
+            collectFiles(input, files);
+
+        Profiler profiler(options);
+        size_t failed = profiler.run(files);
+        profiler.write(std::cout);
+
+        return failed == 0 ? 0 : 1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+}
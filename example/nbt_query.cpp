@@ -0,0 +1,308 @@
+// Query the tags of a path from many nbt files in parallel.
+//
+// Usage: nbt_query [options] <path> <file or directory>...
+//
+// e.g. Find the command blocks of the command in the structures (the command is in one line):
+// nbt_query -e little -c Command -c CustomName
+//     "structure.palette.default.block_position_data.*[Command='say hi']" ./structures
+//
+// The files are walked in binary by the path (see mcnbt/path.hpp), the tags not in the path are skipped without
+// construct them. The results of a file are written together, but the files are in the order they are finished.
+
+#include <atomic>
+#include <cstdlib>
+#include <iostream>
+#include <mutex>
+#include <sstream>
+#include <thread>
+#include <algorithm>
+
+#include <mcnbt/path.hpp>
+
+#include "tool_util.hpp"
+
+using namespace nbt;
+
+enum Format
+{
+    FORMAT_SNBT,    ///< `<file>\t<snbt>` or `<file>\t<snbt of column>...` per result.
+    FORMAT_CSV,     ///< The header line and `<file>,<value>` or `<file>,<value of column>...` per result.
+    FORMAT_NBT      ///< The root compound `{file:"",value:...}` or `{file:"","<column>":...}` per result.
+};
+
+struct Options
+{
+    Encoding enc        = EC_BIG_ENDIAN;
+    size_t headerSize   = 0;
+    Format format       = FORMAT_SNBT;
+    size_t jobs         = 0;
+    Vec<String> columns;
+    String path;
+    Vec<String> inputs;
+};
+
+static void usage()
+{
+    std::cerr <<
+        "Usage: nbt_query [options] <path> <file or directory>...\n"
+        "Options:\n"
+        "  -e, --encoding <big|little|network>  The encoding of the files. (default: big)\n"
+        "  -H, --header <size>                  The size of the header before the root tag. (default: 0)\n"
+        "  -c, --column <path>                  The path from each result to output as a column, can be repeated.\n"
+        "  -f, --format <snbt|csv|nbt>          The output format. (default: snbt)\n"
+        "  -j, --jobs <count>                   The count of threads. (default: count of cores)\n";
+}
+
+static bool parseArgs(int argc, char** argv, Options& options)
+{
+    Vec<String> positionals;
+    for (int i = 1; i < argc; ++i)
+    {
+        String arg = argv[i];
+        bool hasValue = i + 1 < argc;
+
+        if ((arg == "-e" || arg == "--encoding") && hasValue)
+        {
+            String value = argv[++i];
+            if (value == "big")
+                options.enc = EC_BIG_ENDIAN;
+            else if (value == "little")
+                options.enc = EC_LITTLE_ENDIAN;
+            else if (value == "network")
+                options.enc = EC_NETWORK;
+            else
+                return false;
+        }
+        else if ((arg == "-H" || arg == "--header") && hasValue)
+        {
+            options.headerSize = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if ((arg == "-c" || arg == "--column") && hasValue)
+        {
+            options.columns.push_back(argv[++i]);
+        }
+        else if ((arg == "-f" || arg == "--format") && hasValue)
+        {
+            String value = argv[++i];
+            if (value == "snbt")
+                options.format = FORMAT_SNBT;
+            else if (value == "csv")
+                options.format = FORMAT_CSV;
+            else if (value == "nbt")
+                options.format = FORMAT_NBT;
+            else
+                return false;
+        }
+        else if ((arg == "-j" || arg == "--jobs") && hasValue)
+        {
+            options.jobs = static_cast<size_t>(std::strtoull(argv[++i], nullptr, 10));
+        }
+        else if (arg.size() > 1 && arg[0] == '-')
+        {
+            return false;
+        }
+        else
+        {
+            positionals.push_back(arg);
+        }
+    }
+
+    // The first one is the path, which can be empty to select the roots.
+    if (positionals.size() < 2)
+        return false;
+
+    options.path = positionals.front();
+    options.inputs.assign(positionals.begin() + 1, positionals.end());
+
+    return true;
+}
+
+/// @brief Get the SNBT of the value without the name.
+static String valueSnbt(const Tag& tag)
+{
+    if (tag.isListItem() || tag.name().empty())
+        return tag.toSnbt(false);
+
+    Tag value = tag.copy();
+    value.setName("");
+    return value.toSnbt(false);
+}
+
+/// @brief Get the plain text of the value for CSV, the string is not quoted and the numbers has no suffix.
+static String plainValue(const Tag& tag)
+{
+    if (tag.isString())
+        return tag.getString();
+
+    if (tag.isInteger())
+        return std::to_string(tag.getInteger());
+
+    if (tag.isFloatPoint())
+    {
+        SStream ss;
+        ss.precision(tag.isFloat() ? 9 : 17);
+        ss << tag.getFloatPoint();
+        return ss.str();
+    }
+
+    return valueSnbt(tag);
+}
+
+class Query
+{
+public:
+    explicit Query(const Options& options) : options_(options), path_(options.path)
+    {
+        for (const auto& column : options.columns)
+            columns_.push_back(TagPath(column));
+    }
+
+    /// @brief Query the files by the threads, return the count of files failed.
+    size_t run(const Vec<String>& files)
+    {
+        writeHeader();
+
+        size_t jobs = options_.jobs != 0 ? options_.jobs : std::thread::hardware_concurrency();
+        jobs = std::max<size_t>(1, std::min(jobs, files.size()));
+
+        Vec<std::thread> threads;
+        for (size_t i = 0; i < jobs; ++i)
+            threads.push_back(std::thread(&Query::work, this, std::cref(files)));
+
+        for (auto& thread : threads)
+            thread.join();
+
+        std::cout.flush();
+        return failed_;
+    }
+
+private:
+    void work(const Vec<String>& files)
+    {
+        for (;;)
+        {
+            size_t idx = next_.fetch_add(1);
+            if (idx >= files.size())
+                return;
+
+            const String& file = files[idx];
+            try
+            {
+                Vec<Tag> rslts = path_.selectFile(file, options_.enc, options_.headerSize);
+
+                // Format the results out of the lock, then write them together.
+                String out;
+                for (const auto& tag : rslts)
+                    out += format(file, tag);
+
+                std::lock_guard<std::mutex> lock(mutex_);
+                std::cout.write(out.data(), static_cast<std::streamsize>(out.size()));
+            }
+            catch (const std::exception& e)
+            {
+                std::lock_guard<std::mutex> lock(mutex_);
+                std::cerr << file << ": " << e.what() << std::endl;
+                ++failed_;
+            }
+        }
+    }
+
+    void writeHeader()
+    {
+        if (options_.format != FORMAT_CSV)
+            return;
+
+        std::cout << "file";
+        if (columns_.empty())
+            std::cout << ',' << csvField(options_.path);
+        for (const auto& column : options_.columns)
+            std::cout << ',' << csvField(column);
+        std::cout << '\n';
+    }
+
+    String format(const String& file, const Tag& tag) const
+    {
+        switch (options_.format)
+        {
+            case FORMAT_SNBT:
+            {
+                String line = file;
+                if (columns_.empty())
+                    line += '\t' + tag.toSnbt(false);
+                for (const auto& column : columns_)
+                {
+                    const Tag* value = column.first(tag);
+                    line += '\t' + (value ? valueSnbt(*value) : String());
+                }
+
+                return line + '\n';
+            }
+            case FORMAT_CSV:
+            {
+                String line = csvField(file);
+                if (columns_.empty())
+                    line += ',' + csvField(plainValue(tag));
+                for (const auto& column : columns_)
+                {
+                    const Tag* value = column.first(tag);
+                    line += ',' + (value ? csvField(plainValue(*value)) : String());
+                }
+
+                return line + '\n';
+            }
+            case FORMAT_NBT:
+            {
+                Tag root = gCompound();
+                root << gString(file, "file");
+                if (columns_.empty())
+                    root << tag.copy().setName("value");
+                for (const auto& column : columns_)
+                {
+                    const Tag* value = column.first(tag);
+                    if (value)
+                        root << value->copy().setName(column.str());
+                }
+
+                String bin;
+                root.writeTo(bin, options_.enc);
+                return bin;
+            }
+        }
+
+        return String();
+    }
+
+    const Options& options_;
+    TagPath path_;
+    Vec<TagPath> columns_;
+    std::atomic<size_t> next_{ 0 };
+    std::mutex mutex_;
+    size_t failed_ = 0;
+};
+
+int main(int argc, char** argv)
+{
+    Options options;
+    if (!parseArgs(argc, argv, options))
+    {
+        usage();
+        return 2;
+    }
+
+    try
+    {
+        Vec<String> files;
+        for (const auto& input : options.inputs)
+            collectFiles(input, files);
+
+        Query query(options);
+        size_t failed = query.run(files);
+
+        return failed == 0 ? 0 : 1;
+    }
+    catch (const std::exception& e)
+    {
+        std::cerr << e.what() << std::endl;
+        return 2;
+    }
+}
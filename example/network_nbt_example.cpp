@@ -0,0 +1,46 @@
+#include <iostream>
+#include <sstream>
+#include <utility>  // std::pair
+#include <vector>
+
+#include <mcnbt/mcnbt.hpp>
+
+using namespace nbt;
+
+// Convert the sample file to the Bedrock edition network encoding and read it back.
+bool roundTrip(const std::string& filename, Encoding enc)
+{
+    auto root = Tag::fromFile(filename, enc);
+
+    std::stringstream ss;
+    root.write(ss, EC_NETWORK);
+
+    auto network = Tag::fromBinStream(ss, EC_NETWORK);
+
+    std::cout << filename << " (" << ss.str().size() << " bytes in network encoding): ";
+    return root.toSnbt(false) == network.toSnbt(false);
+}
+
+int main(int argc, char** argv)
+{
+    std::string dir = argc > 1 ? argv[1] : "sample_data";
+
+    std::vector<std::pair<std::string, Encoding>> samples = {
+        { "BigEndian_Uncompressed.nbt", EC_BIG_ENDIAN },
+        { "LittleEndian_Uncompressed.nbt", EC_LITTLE_ENDIAN },
+    #ifdef MCNBT_ENABLE_GZIP
+        { "BigEndian_Compressed.nbt", EC_BIG_ENDIAN },
+        { "LittleEndian_Compressed.nbt", EC_LITTLE_ENDIAN },
+    #endif // MCNBT_ENABLE_GZIP
+    };
+
+    bool ok = true;
+    for (const auto& var : samples)
+    {
+        bool rslt = roundTrip(dir + "/" + var.first, var.second);
+        std::cout << (rslt ? "OK" : "MISMATCH") << std::endl;
+        ok = ok && rslt;
+    }
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,44 @@
+#include <iostream>
+#include <sstream>
+
+#include <mcnbt/patch.hpp>
+
+using namespace nbt;
+
+int main()
+{
+    Tag level = gCompound("Level");
+    level << gString("My World", "LevelName");
+    level << gLong(1000, "Time");
+    level << gIntArray({ 1, 2, 3, 4, 5, 6, 7, 8 }, "Heights");
+    level << (gList(TT_STRING, "Players") << gString("Alex") << gString("Steve"));
+
+    // The copy shares the data with the original until it is changed.
+    Tag edited = level.copy();
+    edited["Time"].setLong(2000);
+    edited["Heights"].setIntArray({ 1, 2, 3, 9, 5, 6, 7, 8 });
+    edited["Players"].insertTag(1, gString("Herobrine"));
+    edited << gByte(1, "Raining");
+
+    Patch patch = diff(level, edited);
+    std::cout << "Patch of " << patch.size() << " operations: " << patch.toTag().toSnbt(false) << std::endl;
+
+    // Send the patch as the binary NBT, then apply it to another copy.
+    std::stringstream ss;
+    patch.toTag().write(ss, EC_LITTLE_ENDIAN);
+    Patch received = Patch::fromTag(Tag::fromBinStream(ss, EC_LITTLE_ENDIAN));
+
+    apply(level, received);
+    std::cout << "Patched: " << (level == edited ? "OK" : "MISMATCH") << std::endl;
+
+    // Change a number in the file without read and write the whole file.
+    std::string filename = "./patch_example.nbt";
+    level.write(filename, EC_LITTLE_ENDIAN);
+    bool isInPlace = patchFileInPlace(filename, EC_LITTLE_ENDIAN, { "Time" }, gLong(3000));
+
+    auto patched = Tag::fromFile(filename, EC_LITTLE_ENDIAN);
+    std::cout << "Patched file " << (isInPlace ? "in place" : "by rewrite") << ": " << patched["Time"].getLong();
+    std::cout << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,90 @@
+// The functions shared by the command line tools nbt_query and nbt_profile.
+
+#ifndef MCNBT_EXAMPLE_TOOL_UTIL_HPP
+#define MCNBT_EXAMPLE_TOOL_UTIL_HPP
+
+#include <algorithm>
+
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <dirent.h>
+#include <sys/stat.h>
+#endif
+
+#include <mcnbt/mcnbt.hpp>
+
+/// @brief Append the files in the directory (and its subdirectories) or the file itself.
+inline void collectFiles(const nbt::String& input, nbt::Vec<nbt::String>& files)
+{
+#ifdef _WIN32
+    DWORD attrs = ::GetFileAttributesA(input.c_str());
+    if (attrs == INVALID_FILE_ATTRIBUTES || !(attrs & FILE_ATTRIBUTE_DIRECTORY))
+    {
+        files.push_back(input);
+        return;
+    }
+
+    WIN32_FIND_DATAA data;
+    HANDLE handle = ::FindFirstFileA((input + "\\*").c_str(), &data);
+    if (handle == INVALID_HANDLE_VALUE)
+        return;
+
+    nbt::Vec<nbt::String> names;
+    do
+    {
+        nbt::String name = data.cFileName;
+        if (name != "." && name != "..")
+            names.push_back(name);
+    } while (::FindNextFileA(handle, &data));
+    ::FindClose(handle);
+
+    std::sort(names.begin(), names.end());
+    for (const auto& name : names)
+        collectFiles(input + "\\" + name, files);
+#else
+    struct stat st;
+    if (::stat(input.c_str(), &st) != 0 || !S_ISDIR(st.st_mode))
+    {
+        files.push_back(input);
+        return;
+    }
+
+    DIR* dir = ::opendir(input.c_str());
+    if (!dir)
+        return;
+
+    nbt::Vec<nbt::String> names;
+    while (dirent* entry = ::readdir(dir))
+    {
+        nbt::String name = entry->d_name;
+        if (name != "." && name != "..")
+            names.push_back(name);
+    }
+    ::closedir(dir);
+
+    std::sort(names.begin(), names.end());
+    for (const auto& name : names)
+        collectFiles(input + "/" + name, files);
+#endif // _WIN32
+}
+
+/// @brief Quote the field of CSV if it has the comma, quote or newline.
+inline nbt::String csvField(const nbt::String& field)
+{
+    if (field.find_first_of(",\"\r\n") == nbt::String::npos)
+        return field;
+
+    nbt::String rslt = "\"";
+    for (char ch : field)
+    {
+        if (ch == '"')
+            rslt.push_back('"');
+        rslt.push_back(ch);
+    }
+    rslt.push_back('"');
+
+    return rslt;
+}
+
+#endif // !MCNBT_EXAMPLE_TOOL_UTIL_HPP
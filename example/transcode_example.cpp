@@ -0,0 +1,23 @@
+#include <iostream>
+
+#include <mcnbt/transcode.hpp>
+
+using namespace nbt;
+
+int main(int argc, char** argv)
+{
+    std::string dir = argc > 1 ? argv[1] : "sample_data";
+    std::string src = dir + "/BigEndian_Uncompressed.nbt";
+    std::string dst = "./transcode_example.nbt";
+
+    // Convert the Java edition file to the Bedrock edition file without build the tag tree.
+    transcodeFile(src, dst, EC_BIG_ENDIAN, EC_LITTLE_ENDIAN);
+
+    auto java = Tag::fromFile(src, EC_BIG_ENDIAN);
+    auto bedrock = Tag::fromFile(dst, EC_LITTLE_ENDIAN);
+
+    std::cout << "Transcoded " << src << " to " << dst << ": ";
+    std::cout << (java.toSnbt() == bedrock.toSnbt() ? "OK" : "MISMATCH") << std::endl;
+
+    return 0;
+}
@@ -0,0 +1,157 @@
+#ifndef MCNBT_ALLOCATION_HPP
+#define MCNBT_ALLOCATION_HPP
+
+#include <cstddef>      // size_t, max_align_t
+#include <cstdlib>      // malloc(), free()
+#include <new>          // bad_alloc, nothrow_t
+
+#include "mcnbt.hpp"
+
+// The counting of the heap allocations of the calling thread, e.g. how many allocations a read or write takes.
+// The global operator new and delete are replaced only if #MCNBT_DEFINE_COUNTING_ALLOCATOR is written in one
+// source file (out of any namespace) of the program, else nothing is counted. e.g.
+//
+// #include <mcnbt/allocation.hpp>
+// MCNBT_DEFINE_COUNTING_ALLOCATOR
+//
+// AllocationScope scope;
+// Tag tag = Tag::fromFile("level.dat", EC_BIG_ENDIAN);
+// AllocationStats stats = scope.stats(); // The allocations of the read and the tag alive.
+
+namespace nbt
+{
+
+struct AllocationStats
+{
+    UInt64 allocations      = 0;    ///< The count of allocations.
+    UInt64 deallocations    = 0;    ///< The count of deallocations.
+    UInt64 allocatedBytes   = 0;    ///< The bytes of allocations.
+    UInt64 freedBytes       = 0;    ///< The bytes of deallocations.
+
+    /// @brief Get the bytes allocated but not freed yet.
+    Int64 liveBytes() const { return static_cast<Int64>(allocatedBytes - freedBytes); }
+
+    AllocationStats operator-(const AllocationStats& other) const
+    {
+        AllocationStats rslt;
+        rslt.allocations = allocations - other.allocations;
+        rslt.deallocations = deallocations - other.deallocations;
+        rslt.allocatedBytes = allocatedBytes - other.allocatedBytes;
+        rslt.freedBytes = freedBytes - other.freedBytes;
+
+        return rslt;
+    }
+};
+
+/// @brief The counts of the calling thread. (Trivial type, so it is usable before the static initialization)
+inline AllocationStats& _threadAllocationStats()
+{
+    static thread_local AllocationStats stats;
+    return stats;
+}
+
+/// @brief Get the allocations of the calling thread since it is started.
+inline AllocationStats getAllocationStats() { return _threadAllocationStats(); }
+
+/// @brief Check if the allocations are counted. (See #MCNBT_DEFINE_COUNTING_ALLOCATOR)
+inline bool isAllocationCounted()
+{
+    UInt64 before = _threadAllocationStats().allocations;
+    ::operator delete(::operator new(1));
+    return _threadAllocationStats().allocations != before;
+}
+
+/// @brief Get the allocations of the calling thread from construction to the call of #stats().
+class AllocationScope
+{
+public:
+    AllocationScope() : begin_(getAllocationStats()) {}
+
+    AllocationStats stats() const { return getAllocationStats() - begin_; }
+
+private:
+    AllocationStats begin_;
+};
+
+/// @brief Call the function and get the allocations of the calling thread in it.
+template <typename Func>
+AllocationStats countAllocations(Func func)
+{
+    AllocationScope scope;
+    func();
+    return scope.stats();
+}
+
+// The size of allocation is stored before the memory returned, so the deallocation knows it.
+constexpr size_t _ALLOCATION_HEADER_SIZE = alignof(std::max_align_t);
+
+inline void* _countedAllocate(size_t size) noexcept
+{
+    // The allocations of the document being read or written are timed. (See mcnbt/stats.hpp)
+    MCNBT_STATS(CodecStats* codecStats = _currentStats();)
+    MCNBT_STATS(uint64_t begin = codecStats ? _statsNow() : 0;)
+
+    void* ptr = std::malloc(size + _ALLOCATION_HEADER_SIZE);
+    if (!ptr)
+        return nullptr;
+
+    MCNBT_STATS(if (codecStats) { codecStats->allocNs += _statsNow() - begin; })
+    MCNBT_STATS(if (codecStats) { ++codecStats->allocations; codecStats->allocatedBytes += size; })
+
+    *static_cast<size_t*>(ptr) = size;
+
+    AllocationStats& stats = _threadAllocationStats();
+    ++stats.allocations;
+    stats.allocatedBytes += size;
+
+    return static_cast<char*>(ptr) + _ALLOCATION_HEADER_SIZE;
+}
+
+inline void* _countedAllocateOrThrow(size_t size)
+{
+    // Same as the standard, the allocation of 0 byte returns the unique pointer.
+    void* ptr = _countedAllocate(size == 0 ? 1 : size);
+    if (!ptr)
+        throw std::bad_alloc();
+
+    return ptr;
+}
+
+inline void _countedDeallocate(void* ptr) noexcept
+{
+    if (!ptr)
+        return;
+
+    // The memory may be freed by the other thread, so the counts of threads are only meaningful in sum.
+    void* base = static_cast<char*>(ptr) - _ALLOCATION_HEADER_SIZE;
+    AllocationStats& stats = _threadAllocationStats();
+    ++stats.deallocations;
+    stats.freedBytes += *static_cast<size_t*>(base);
+
+    MCNBT_STATS(CodecStats* codecStats = _currentStats();)
+    MCNBT_STATS(uint64_t begin = codecStats ? _statsNow() : 0;)
+
+    std::free(base);
+
+    MCNBT_STATS(if (codecStats) { codecStats->allocNs += _statsNow() - begin; })
+}
+
+} // namespace nbt
+
+/// @brief Replace the global operator new and delete to count the allocations. (See #getAllocationStats())
+/// @attention Must be written only once in the program, out of any namespace.
+#define MCNBT_DEFINE_COUNTING_ALLOCATOR \
+    void* operator new(std::size_t size) { return nbt::_countedAllocateOrThrow(size); } \
+    void* operator new[](std::size_t size) { return nbt::_countedAllocateOrThrow(size); } \
+    void* operator new(std::size_t size, const std::nothrow_t&) noexcept \
+    { return nbt::_countedAllocate(size == 0 ? 1 : size); } \
+    void* operator new[](std::size_t size, const std::nothrow_t&) noexcept \
+    { return nbt::_countedAllocate(size == 0 ? 1 : size); } \
+    void operator delete(void* ptr) noexcept { nbt::_countedDeallocate(ptr); } \
+    void operator delete[](void* ptr) noexcept { nbt::_countedDeallocate(ptr); } \
+    void operator delete(void* ptr, std::size_t) noexcept { nbt::_countedDeallocate(ptr); } \
+    void operator delete[](void* ptr, std::size_t) noexcept { nbt::_countedDeallocate(ptr); } \
+    void operator delete(void* ptr, const std::nothrow_t&) noexcept { nbt::_countedDeallocate(ptr); } \
+    void operator delete[](void* ptr, const std::nothrow_t&) noexcept { nbt::_countedDeallocate(ptr); }
+
+#endif // !MCNBT_ALLOCATION_HPP
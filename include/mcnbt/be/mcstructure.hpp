@@ -4,6 +4,8 @@
 #include "block_entity.hpp"
 #include "block_state.hpp"
 
+#include "../path.hpp"
+
 namespace nbt
 {
 
@@ -54,21 +56,63 @@ struct MCStructure
         root << structure;
     };
 
-    Tag& formatVersion()            { return root[0]; }
+    // The paths are compiled once and find the members by name, so they are not broken by the other order of members.
 
-    Tag& size()                     { return root[1]; }
+    /// @note Throw std::out_of_range if the root has no "format_version".
+    Tag& formatVersion()
+    {
+        static const TagPath path("format_version");
+        return path.get(root);
+    }
 
-    Tag& structureWorldOrigin()     { return root[2]; }
+    /// @note Throw std::out_of_range if the root has no "size".
+    Tag& size()
+    {
+        static const TagPath path("size");
+        return path.get(root);
+    }
+
+    /// @note Throw std::out_of_range if the root has no "structure_world_origin".
+    Tag& structureWorldOrigin()
+    {
+        static const TagPath path("structure_world_origin");
+        return path.get(root);
+    }
 
-    Tag& blockIndices1()            { return root[3][0][0]; }
+    /// @note Throw std::out_of_range if the root has no "structure.block_indices[0]".
+    Tag& blockIndices1()
+    {
+        static const TagPath path("structure.block_indices[0]");
+        return path.get(root);
+    }
 
-    Tag& blockIndices2()            { return root[3][0][1]; }
+    /// @note Throw std::out_of_range if the root has no "structure.block_indices[1]".
+    Tag& blockIndices2()
+    {
+        static const TagPath path("structure.block_indices[1]");
+        return path.get(root);
+    }
 
-    Tag& entities()                 { return root[3][1]; }
+    /// @note Throw std::out_of_range if the root has no "structure.entities".
+    Tag& entities()
+    {
+        static const TagPath path("structure.entities");
+        return path.get(root);
+    }
 
-    Tag& blockPalette()             { return root[3][2][0][0]; }
+    /// @note Throw std::out_of_range if the root has no "structure.palette.default.block_palette".
+    Tag& blockPalette()
+    {
+        static const TagPath path("structure.palette.default.block_palette");
+        return path.get(root);
+    }
 
-    Tag& blockPositionData()        { return root[3][2][0][1]; }
+    /// @note Throw std::out_of_range if the root has no "structure.palette.default.block_position_data".
+    Tag& blockPositionData()
+    {
+        static const TagPath path("structure.palette.default.block_position_data");
+        return path.get(root);
+    }
 
     Tag root;
 };
@@ -0,0 +1,678 @@
+#ifndef MCNBT_COLUMN_HPP
+#define MCNBT_COLUMN_HPP
+
+#include <cstring>
+
+#include "path.hpp"
+
+namespace nbt
+{
+
+// The columnar layout of the compounds (e.g. the items of the list of entities), for the analytics over lots of
+// records. Each member name is a column of all the compounds (the rows), which values are stored contiguously by
+// type, and a bitmap records which rows have the member.
+//
+// The binary columnar file (all numbers are little endian):
+// - "MCNBTCOL", UInt32 version (1), UInt64 count of rows, UInt32 count of columns.
+// - Each column: UInt32 length and bytes of name, Byte kind, Byte type, Byte item type, UInt32 width,
+//   the bitmap of (rows + 7) / 8 bytes, then the values by kind:
+//   #CK_NUMBER and #CK_NUMBERS:    rows * width numbers.
+//   #CK_STRING:                    UInt32 count of strings, each UInt32 length and bytes, then rows Int32 codes.
+//   #CK_TAG:                       The tag of each row which has the member, as the little endian binary NBT.
+
+enum ColumnKind : Byte
+{
+    CK_NUMBER   = 1,    ///< A number per row, in #Column::numbers.
+    CK_NUMBERS  = 2,    ///< #Column::width numbers per row (the lists of numbers or arrays of same size, e.g. `Pos`),
+                        // in #Column::numbers.
+    CK_STRING   = 3,    ///< A string per row, dictionary encoded in #Column::dict and #Column::codes.
+    CK_TAG      = 4     ///< A tag per row in #Column::tags, for the other types and the members of different types.
+};
+
+struct Column
+{
+    /// @brief Check if the row has no this member.
+    bool isNull(size_t row) const { return (validity[row / 8] & (1 << (row % 8))) == 0; }
+
+    /// @brief Get the numbers of #CK_NUMBER and #CK_NUMBERS, #width numbers per row, zeros for the null rows.
+    /// @tparam T The type of number, must be correspond to #type (or #itemType of #CK_NUMBERS).
+    template <typename T>
+    const Vec<T>& values() const { return numbers.listData<T>(); }
+
+    String name;
+    ColumnKind kind     = CK_TAG;
+    TagType type        = TT_END;   ///< The type of the values, #TT_END if they are different types. (#CK_TAG only)
+    TagType itemType    = TT_END;   ///< The type of the numbers of #CK_NUMBERS.
+    size_t width        = 1;        ///< The count of numbers per row of #CK_NUMBERS.
+    Vec<UChar> validity;            ///< The bitmap of rows which have the member, the bit (i % 8) of byte (i / 8).
+    Tag numbers;                    ///< The list of numbers of #CK_NUMBER and #CK_NUMBERS.
+    Vec<String> dict;               ///< The distinct strings of #CK_STRING in the order of first appearance.
+    Vec<Int32> codes;               ///< The index in #dict of each row of #CK_STRING, 0 for the null rows.
+    Vec<Tag> tags;                  ///< The tag (without name) of each row of #CK_TAG, end tag for the null rows.
+};
+
+// Get or make the number tag as the specified type.
+
+inline Byte _getNum(const Tag& tag, Byte*)      { return tag.getByte(); }
+inline Int16 _getNum(const Tag& tag, Int16*)    { return tag.getShort(); }
+inline Int32 _getNum(const Tag& tag, Int32*)    { return tag.getInt(); }
+inline Int64 _getNum(const Tag& tag, Int64*)    { return tag.getLong(); }
+inline Fp32 _getNum(const Tag& tag, Fp32*)      { return tag.getFloat(); }
+inline Fp64 _getNum(const Tag& tag, Fp64*)      { return tag.getDouble(); }
+
+inline Tag _makeNum(Byte value)                 { return gByte(value); }
+inline Tag _makeNum(Int16 value)                { return gShort(value); }
+inline Tag _makeNum(Int32 value)                { return gInt(value); }
+inline Tag _makeNum(Int64 value)                { return gLong(value); }
+inline Tag _makeNum(Fp32 value)                 { return gFloat(value); }
+inline Tag _makeNum(Fp64 value)                 { return gDouble(value); }
+
+inline void _appendNums(Tag& tag, const Byte* data, size_t count)   { tag.appendBytes(data, count); }
+inline void _appendNums(Tag& tag, const Int16* data, size_t count)  { tag.appendShorts(data, count); }
+inline void _appendNums(Tag& tag, const Int32* data, size_t count)  { tag.appendInts(data, count); }
+inline void _appendNums(Tag& tag, const Int64* data, size_t count)  { tag.appendLongs(data, count); }
+inline void _appendNums(Tag& tag, const Fp32* data, size_t count)   { tag.appendFloats(data, count); }
+inline void _appendNums(Tag& tag, const Fp64* data, size_t count)   { tag.appendDoubles(data, count); }
+
+/// @brief Call the #visitor with the null pointer of the type of number.
+/// @param visitor Has the member function template `void operator()(T*)`.
+template <typename Visitor>
+void _visitNumType(TagType type, Visitor& visitor)
+{
+    switch (type)
+    {
+        case TT_BYTE:       visitor(static_cast<Byte*>(nullptr)); break;
+        case TT_SHORT:      visitor(static_cast<Int16*>(nullptr)); break;
+        case TT_INT:        visitor(static_cast<Int32*>(nullptr)); break;
+        case TT_LONG:       visitor(static_cast<Int64*>(nullptr)); break;
+        case TT_FLOAT:      visitor(static_cast<Fp32*>(nullptr)); break;
+        case TT_DOUBLE:     visitor(static_cast<Fp64*>(nullptr)); break;
+        default:            break;
+    }
+}
+
+/// @brief Get the type of the numbers of the array.
+inline TagType _arrayItemType(TagType type)
+{
+    switch (type)
+    {
+        case TT_BYTE_ARRAY: return TT_BYTE;
+        case TT_INT_ARRAY:  return TT_INT;
+        case TT_LONG_ARRAY: return TT_LONG;
+        default:            return TT_END;
+    }
+}
+
+class ColumnTable
+{
+public:
+    ColumnTable() = default;
+
+    /// @brief Get the count of rows.
+    size_t rowCount() const                 { return rowCount_; }
+
+    const Vec<Column>& columns() const      { return columns_; }
+
+    /// @brief Get the column by the member name, nullptr if not exists.
+    const Column* column(const String& name) const
+    {
+        auto it = idxs_.find(name);
+        return it != idxs_.end() ? &columns_[it->second] : nullptr;
+    }
+
+    /// @brief Get the columns of the compounds, the other tags are ignored.
+    /// @note The columns are in the order of the first appearance of the members.
+    static ColumnTable fromTags(const Vec<const Tag*>& rows)
+    {
+        ColumnTable table;
+        table.build_(rows);
+        return table;
+    }
+
+    /// @overload
+    static ColumnTable fromTags(const Vec<Tag>& rows)
+    {
+        Vec<const Tag*> ptrs;
+        ptrs.reserve(rows.size());
+        for (const auto& var : rows)
+            ptrs.push_back(&var);
+
+        return fromTags(ptrs);
+    }
+
+    /// @brief Get the columns of the items of the list of compounds.
+    static ColumnTable fromTag(const Tag& list)
+    {
+        assert(list.isList());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!list.isList())
+            throw std::logic_error("Can't get the columns of non-list tag.");
+    #endif
+
+        Vec<const Tag*> rows;
+        if (list.listItemType() == TT_COMPOUND)
+        {
+            rows.reserve(list.size());
+            for (size_t i = 0; i < list.size(); ++i)
+                rows.push_back(&list.getTag(i));
+        }
+
+        return fromTags(rows);
+    }
+
+    /// @brief Get the columns of the compounds of the path from the tag, the items of the lists of compounds
+    // of the path are the rows too. e.g. `structure.entities`.
+    static ColumnTable fromTag(const Tag& tag, const TagPath& path)
+    {
+        Vec<const Tag*> rows;
+        for (const Tag* var : path.select(tag))
+        {
+            if (var->isList() && var->listItemType() == TT_COMPOUND)
+            {
+                for (size_t i = 0; i < var->size(); ++i)
+                    rows.push_back(&var->getTag(i));
+            }
+            else
+            {
+                rows.push_back(var);
+            }
+        }
+
+        return fromTags(rows);
+    }
+
+    /// @brief Get the list of compounds from the columns.
+    /// @note The members are in the order of the columns.
+    Tag toTag() const
+    {
+        Tag list = gList(TT_COMPOUND);
+        list.reserve(rowCount_);
+        for (size_t i = 0; i < rowCount_; ++i)
+            list << row(i);
+
+        return list.shareShapes();
+    }
+
+    /// @brief Get the compound of the row.
+    Tag row(size_t idx) const
+    {
+        if (idx >= rowCount_)
+            throw std::out_of_range("The specified index is out of range.");
+
+        Tag rslt = gCompound();
+        for (const auto& col : columns_)
+        {
+            if (col.isNull(idx))
+                continue;
+
+            Tag value;
+            switch (col.kind)
+            {
+                case CK_NUMBER:
+                {
+                    NumberGetter_ getter{ col, idx, value };
+                    _visitNumType(col.type, getter);
+                    break;
+                }
+                case CK_NUMBERS:
+                {
+                    value = col.type == TT_LIST ? gList(col.itemType) : Tag(col.type);
+                    NumbersGetter_ getter{ col, idx, value };
+                    _visitNumType(col.itemType, getter);
+                    break;
+                }
+                case CK_STRING:
+                    value = gString(col.dict[static_cast<size_t>(col.codes[idx])]);
+                    break;
+                case CK_TAG:
+                    value = col.tags[idx].copy();
+                    break;
+            }
+
+            rslt << value.setName(col.name);
+        }
+
+        return rslt;
+    }
+
+    /// @brief Write the columns as the binary columnar file. (See the comment before #ColumnKind)
+    void write(OStream& os) const
+    {
+        StreamSink sink(os);
+        writeToSink(sink);
+        sink.flush();
+    }
+
+    /// @overload
+    void write(const String& filename) const
+    {
+        _File file(filename, false);
+
+        FileSink sink(file.fd());
+        writeToSink(sink);
+        sink.flush();
+
+        file.close();
+    }
+
+    /// @brief Write the columns to any sink. (See #write())
+    template <typename Sink>
+    void writeToSink(Sink& os) const
+    {
+        os.write(magic_(), magicSize_());
+        _num2bytes<UInt32>(version_(), os);
+        _num2bytes<UInt64>(rowCount_, os);
+        _num2bytes<UInt32>(static_cast<UInt32>(columns_.size()), os);
+
+        for (const auto& col : columns_)
+        {
+            writeString_(col.name, os);
+            os.put(static_cast<char>(col.kind));
+            os.put(static_cast<char>(col.type));
+            os.put(static_cast<char>(col.itemType));
+            _num2bytes<UInt32>(static_cast<UInt32>(col.width), os);
+            os.write(reinterpret_cast<const char*>(col.validity.data()), col.validity.size());
+
+            switch (col.kind)
+            {
+                case CK_NUMBER:
+                case CK_NUMBERS:
+                {
+                    NumbersWriter_<Sink> writer{ col, os };
+                    _visitNumType(col.kind == CK_NUMBER ? col.type : col.itemType, writer);
+                    break;
+                }
+                case CK_STRING:
+                    _num2bytes<UInt32>(static_cast<UInt32>(col.dict.size()), os);
+                    for (const auto& var : col.dict)
+                        writeString_(var, os);
+                    _writeFixedArray(col.codes.data(), col.codes.size(), os, false);
+                    break;
+                case CK_TAG:
+                    for (size_t i = 0; i < rowCount_; ++i)
+                    {
+                        if (!col.isNull(i))
+                            col.tags[i].writeToSink(os, EC_LITTLE_ENDIAN);
+                    }
+                    break;
+            }
+        }
+    }
+
+    /// @brief Get the columns from the binary columnar file. (See #write())
+    static ColumnTable fromBinStream(IStream& is)
+    {
+        Vec<Byte> content;
+        StreamSource stream(is);
+        _readRemain(stream, content);
+
+        BufferSource src(content.data(), content.size());
+        return fromSource(src);
+    }
+
+    /// @overload
+    /// @note The regular file is mapped to memory (or read to a buffer of exact size) at once.
+    static ColumnTable fromFile(const String& filename)
+    {
+        _File file(filename);
+
+        Int64 size = file.size();
+        if (size < 0)
+        {
+            Vec<Byte> content;
+            FileSource stream(file.fd());
+            _readRemain(stream, content);
+
+            BufferSource src(content.data(), content.size());
+            return fromSource(src);
+        }
+
+        if (static_cast<UInt64>(size) > static_cast<UInt64>(SIZE_MAX))
+            throw std::runtime_error("The file is too large: " + filename);
+
+        _FileContent content(file, static_cast<size_t>(size));
+        BufferSource src(content.data(), content.size());
+        return fromSource(src);
+    }
+
+    /// @brief Get the columns from the memory of binary columnar file. (See #write())
+    static ColumnTable fromSource(BufferSource& src)
+    {
+        if (std::memcmp(src.take(magicSize_()), magic_(), magicSize_()) != 0 ||
+            src.readNum<UInt32>(false) != version_())
+            invalid_();
+
+        ColumnTable table;
+        UInt64 rowCount = src.readNum<UInt64>(false);
+        // Each row has a bit in the bitmap of each column at least.
+        if (rowCount > static_cast<UInt64>(src.remain()) * 8)
+            invalid_();
+        table.rowCount_ = static_cast<size_t>(rowCount);
+
+        size_t columnCount = src.readNum<UInt32>(false);
+        for (size_t i = 0; i < columnCount; ++i)
+        {
+            Column col;
+            col.name = readString_(src);
+            col.kind = static_cast<ColumnKind>(src.get());
+            col.type = static_cast<TagType>(src.get());
+            col.itemType = static_cast<TagType>(src.get());
+            col.width = src.readNum<UInt32>(false);
+
+            const char* validity = src.take(validitySize_(table.rowCount_));
+            col.validity.assign(validity, validity + validitySize_(table.rowCount_));
+
+            switch (col.kind)
+            {
+                case CK_NUMBER:
+                case CK_NUMBERS:
+                {
+                    TagType numType = col.kind == CK_NUMBER ? col.type : col.itemType;
+                    if (!isNum(numType) || (col.kind == CK_NUMBER && col.width != 1) ||
+                        (col.kind == CK_NUMBERS && col.type != TT_LIST && _arrayItemType(col.type) != numType))
+                        invalid_();
+
+                    // The width can't be trusted before the numbers are read.
+                    if (col.width != 0 && table.rowCount_ > SIZE_MAX / col.width)
+                        invalid_();
+
+                    col.numbers = gList(numType);
+                    NumbersReader_ reader{ col, src, table.rowCount_ * col.width };
+                    _visitNumType(numType, reader);
+                    break;
+                }
+                case CK_STRING:
+                {
+                    if (col.type != TT_STRING)
+                        invalid_();
+
+                    size_t dictSize = src.readNum<UInt32>(false);
+                    for (size_t j = 0; j < dictSize; ++j)
+                        col.dict.push_back(readString_(src));
+
+                    _readFixedArray(src, table.rowCount_, col.codes, false);
+                    for (size_t j = 0; j < table.rowCount_; ++j)
+                    {
+                        if (!col.isNull(j) && (col.codes[j] < 0 || static_cast<size_t>(col.codes[j]) >= dictSize))
+                            invalid_();
+                    }
+                    break;
+                }
+                case CK_TAG:
+                {
+                    col.tags.resize(table.rowCount_);
+                    for (size_t j = 0; j < table.rowCount_; ++j)
+                    {
+                        if (col.isNull(j))
+                            continue;
+
+                        col.tags[j] = Tag::fromSource(src, EC_LITTLE_ENDIAN);
+                        if (col.tags[j].isEnd() || (col.type != TT_END && col.tags[j].type() != col.type))
+                            invalid_();
+                    }
+                    break;
+                }
+                default:
+                    invalid_();
+            }
+
+            if (!table.idxs_.emplace(col.name, table.columns_.size()).second)
+                invalid_();
+            table.columns_.push_back(std::move(col));
+        }
+
+        return table;
+    }
+
+private:
+    static const char* magic_()     { return "MCNBTCOL"; }
+    static UInt32 version_()        { return 1; }
+    static size_t magicSize_()      { return 8; }
+
+    static void invalid_() { throw std::runtime_error("Invalid columnar data."); }
+
+    static size_t validitySize_(size_t rowCount) { return rowCount / 8 + (rowCount % 8 != 0 ? 1 : 0); }
+
+    template <typename Sink>
+    static void writeString_(const String& str, Sink& os)
+    {
+        _num2bytes<UInt32>(static_cast<UInt32>(str.size()), os);
+        os.write(str.data(), str.size());
+    }
+
+    static String readString_(BufferSource& src)
+    {
+        size_t len = src.readNum<UInt32>(false);
+        return String(src.take(len), len);
+    }
+
+    // The state of the column while the rows are scanned.
+    struct Scan_
+    {
+        bool isMixed    = false;    ///< The values are different types.
+        bool isFixed    = true;     ///< The lists or arrays have same item type and size.
+        size_t hint     = 0;        ///< The index of the member in the row scanned last time.
+    };
+
+    /// @brief Merge the type of the value to the column.
+    static void scanValue_(Column& col, Scan_& scan, const Tag& value, bool isFirst)
+    {
+        TagType itemType = value.isList() ? value.listItemType() : _arrayItemType(value.type());
+        if (isFirst)
+        {
+            col.type = value.type();
+            col.itemType = itemType;
+            col.width = value.isList() || value.isArray() ? value.size() : 1;
+            return;
+        }
+
+        if (value.type() != col.type)
+            scan.isMixed = true;
+        else if ((value.isList() || value.isArray()) && (itemType != col.itemType || value.size() != col.width))
+            scan.isFixed = false;
+    }
+
+    void build_(const Vec<const Tag*>& rows)
+    {
+        Vec<Scan_> scans;
+
+        // Find the columns and their types.
+        for (const Tag* row : rows)
+        {
+            if (!row->isCompound())
+                continue;
+
+            size_t matched = 0;
+            for (size_t i = 0; i < columns_.size(); ++i)
+            {
+                size_t idx = row->indexOf(columns_[i].name, scans[i].hint);
+                if (idx == row->size())
+                    continue;
+
+                scans[i].hint = idx;
+                scanValue_(columns_[i], scans[i], row->getTag(idx), false);
+                ++matched;
+            }
+
+            // The members not in the columns yet.
+            for (size_t idx = 0; matched < row->size() && idx < row->size(); ++idx)
+            {
+                const Tag& member = row->getTag(idx);
+                String name = member.name();
+                if (idxs_.find(name) != idxs_.end())
+                    continue;
+
+                idxs_.emplace(name, columns_.size());
+                columns_.push_back(Column());
+                columns_.back().name = name;
+                scans.push_back(Scan_());
+                scans.back().hint = idx;
+                scanValue_(columns_.back(), scans.back(), member, true);
+                ++matched;
+            }
+        }
+
+        for (size_t i = 0; i < columns_.size(); ++i)
+        {
+            Column& col = columns_[i];
+            if (scans[i].isMixed)
+                col.kind = CK_TAG, col.type = TT_END, col.itemType = TT_END;
+            else if (nbt::isNum(col.type))
+                col.kind = CK_NUMBER;
+            else if (col.type == TT_STRING)
+                col.kind = CK_STRING;
+            else if ((col.type == TT_LIST || isArray(col.type)) && nbt::isNum(col.itemType) && scans[i].isFixed)
+                col.kind = CK_NUMBERS;
+            else
+                col.kind = CK_TAG;
+
+            if (col.kind != CK_NUMBERS)
+                col.width = 1, col.itemType = TT_END;
+        }
+
+        // Fill the values column by column, the rows have the same layout mostly, so the member is found by the
+        // index found in the last row.
+        Vec<const Tag*> compounds;
+        compounds.reserve(rows.size());
+        for (const Tag* row : rows)
+        {
+            if (row->isCompound())
+                compounds.push_back(row);
+        }
+
+        rowCount_ = compounds.size();
+        for (size_t i = 0; i < columns_.size(); ++i)
+            fill_(columns_[i], scans[i].hint, compounds);
+    }
+
+    void fill_(Column& col, size_t hint, const Vec<const Tag*>& rows)
+    {
+        col.validity.assign(validitySize_(rows.size()), 0);
+        if (col.kind == CK_NUMBER || col.kind == CK_NUMBERS)
+            col.numbers = gList(col.kind == CK_NUMBER ? col.type : col.itemType);
+        if (col.kind == CK_STRING)
+            col.codes.assign(rows.size(), 0);
+        if (col.kind == CK_TAG)
+            col.tags.resize(rows.size());
+
+        NumbersFiller_ filler{ col, rows, hint };
+        if (col.kind == CK_NUMBER || col.kind == CK_NUMBERS)
+        {
+            _visitNumType(col.kind == CK_NUMBER ? col.type : col.itemType, filler);
+            return;
+        }
+
+        Map<String, Int32> codes;
+        for (size_t i = 0; i < rows.size(); ++i)
+        {
+            const Tag* value = filler.find(i);
+            if (!value)
+                continue;
+
+            if (col.kind == CK_STRING)
+            {
+                auto rslt = codes.emplace(value->getString(), static_cast<Int32>(col.dict.size()));
+                if (rslt.second)
+                    col.dict.push_back(rslt.first->first);
+                col.codes[i] = rslt.first->second;
+            }
+            else
+            {
+                col.tags[i] = value->copy();
+                col.tags[i].setName("");
+            }
+        }
+    }
+
+    // The visitors of the type of numbers. (See #_visitNumType())
+
+    struct NumbersFiller_
+    {
+        Column& col;
+        const Vec<const Tag*>& rows;
+        size_t hint;
+
+        /// @brief Find the member of the column in the row and set the bit of it, nullptr if not exists.
+        const Tag* find(size_t row)
+        {
+            size_t idx = rows[row]->indexOf(col.name, hint);
+            if (idx == rows[row]->size())
+                return nullptr;
+
+            hint = idx;
+            col.validity[row / 8] |= static_cast<UChar>(1 << (row % 8));
+            return &rows[row]->getTag(idx);
+        }
+
+        template <typename T>
+        void operator()(T*)
+        {
+            Vec<T>& data = col.numbers.listData<T>();
+            data.assign(rows.size() * col.width, T());
+
+            for (size_t i = 0; i < rows.size(); ++i)
+            {
+                const Tag* value = find(i);
+                if (!value)
+                    continue;
+
+                if (col.kind == CK_NUMBER)
+                    data[i] = _getNum(*value, static_cast<T*>(nullptr));
+                else
+                    value->copyNumbers(data.data() + i * col.width, col.width);
+            }
+        }
+    };
+
+    struct NumberGetter_
+    {
+        const Column& col;
+        size_t row;
+        Tag& value;
+
+        template <typename T>
+        void operator()(T*) { value = _makeNum(col.values<T>()[row]); }
+    };
+
+    struct NumbersGetter_
+    {
+        const Column& col;
+        size_t row;
+        Tag& value;
+
+        template <typename T>
+        void operator()(T*) { _appendNums(value, col.values<T>().data() + row * col.width, col.width); }
+    };
+
+    template <typename Sink>
+    struct NumbersWriter_
+    {
+        const Column& col;
+        Sink& os;
+
+        template <typename T>
+        void operator()(T*)
+        {
+            const Vec<T>& data = col.values<T>();
+            _writeFixedArray(data.data(), data.size(), os, false);
+        }
+    };
+
+    struct NumbersReader_
+    {
+        Column& col;
+        BufferSource& src;
+        size_t count;
+
+        template <typename T>
+        void operator()(T*) { _readFixedArray(src, count, col.numbers.listData<T>(), false); }
+    };
+
+    size_t rowCount_ = 0;
+    Vec<Column> columns_;
+    Map<String, size_t> idxs_;
+};
+
+} // namespace nbt
+
+#endif // !MCNBT_COLUMN_HPP
@@ -0,0 +1,516 @@
+#ifndef MCNBT_CORPUS_HPP
+#define MCNBT_CORPUS_HPP
+
+#include "be/entity.hpp"
+#include "be/mcstructure.hpp"
+
+namespace nbt
+{
+
+// The synthetic NBT documents for the benchmarks and stress tests, so they can run on the inputs of any size
+// without the binary fixtures. The same seed and parameters always give the same document on all platforms.
+namespace corpus
+{
+
+/// @brief The deterministic random numbers (SplitMix64), not depend on the distributions of the standard library.
+class Random
+{
+public:
+    explicit Random(UInt64 seed) : state_(seed) {}
+
+    UInt64 next()
+    {
+        UInt64 z = (state_ += 0x9E3779B97F4A7C15ULL);
+        z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ULL;
+        z = (z ^ (z >> 27)) * 0x94D049BB133111EBULL;
+        return z ^ (z >> 31);
+    }
+
+    /// @brief Get the number in [0, bound).
+    Int32 nextInt(Int32 bound)      { return bound <= 0 ? 0 : static_cast<Int32>(next() % static_cast<UInt64>(bound)); }
+
+    /// @brief Get the number in [low, high).
+    Fp32 nextFloat(Fp32 low, Fp32 high)
+    { return low + (high - low) * static_cast<Fp32>(next() >> 40) / static_cast<Fp32>(1 << 24); }
+
+    bool nextBool(Int32 percent)    { return nextInt(100) < percent; }
+
+    /// @brief Get the random item of the array.
+    template <typename T, size_t N>
+    const T& pick(const T (&arr)[N]) { return arr[static_cast<size_t>(nextInt(static_cast<Int32>(N)))]; }
+
+private:
+    UInt64 state_;
+};
+
+enum DocumentKind
+{
+    DK_LEVEL,           ///< The level.dat like compound. (See #level())
+    DK_NESTED,          ///< The deep nested compounds and lists. (See #nested())
+    DK_WIDE,            ///< The compound of many members. (See #wideCompound())
+    DK_LONG_ARRAYS,     ///< The huge long arrays. (See #longArrays())
+    DK_ENTITIES,        ///< The list of entities. (See #entities())
+    DK_BLOCK_PALETTE,   ///< The list of blocks. (See #blockPalette())
+    DK_MCSTRUCTURE,     ///< The MCStructure. (See #mcstructure())
+    DK_REGION           ///< The region like compound of chunks. (See #region())
+};
+
+inline const char* getDocumentKindName(DocumentKind kind)
+{
+    switch (kind)
+    {
+        case DK_LEVEL:          return "level";
+        case DK_NESTED:         return "nested";
+        case DK_WIDE:           return "wide";
+        case DK_LONG_ARRAYS:    return "long_arrays";
+        case DK_ENTITIES:       return "entities";
+        case DK_BLOCK_PALETTE:  return "block_palette";
+        case DK_MCSTRUCTURE:    return "mcstructure";
+        case DK_REGION:         return "region";
+        default:                return "unknown";
+    }
+}
+
+/// @brief Get the document kind by its name. (See #getDocumentKindName())
+/// @return Whether the name is valid.
+inline bool getDocumentKind(const String& name, DocumentKind& kind)
+{
+    for (int i = DK_LEVEL; i <= DK_REGION; ++i)
+    {
+        if (name == getDocumentKindName(static_cast<DocumentKind>(i)))
+        {
+            kind = static_cast<DocumentKind>(i);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+inline const char* const* _blockNames(size_t& count)
+{
+    static const char* const names[] = {
+        "minecraft:stone", "minecraft:dirt", "minecraft:grass_block", "minecraft:oak_log", "minecraft:oak_leaves",
+        "minecraft:water", "minecraft:sand", "minecraft:gravel", "minecraft:coal_ore", "minecraft:iron_ore",
+        "minecraft:deepslate", "minecraft:air", "minecraft:chest", "minecraft:torch", "minecraft:glass",
+        "minecraft:oak_planks"
+    };
+
+    count = sizeof(names) / sizeof(names[0]);
+    return names;
+}
+
+inline const char* const* _entityIds(size_t& count)
+{
+    static const char* const ids[] = {
+        "minecraft:pig", "minecraft:cow", "minecraft:sheep", "minecraft:chicken", "minecraft:zombie",
+        "minecraft:skeleton", "minecraft:creeper", "minecraft:villager_v2", "minecraft:item", "minecraft:armor_stand"
+    };
+
+    count = sizeof(ids) / sizeof(ids[0]);
+    return ids;
+}
+
+/// @brief Get the count of units to make the document of about the size, by the size of the sample of some units.
+inline size_t _unitCount(const Tag& sample, size_t sampleUnits, size_t size)
+{
+    size_t unitSize = sample.binarySize(EC_LITTLE_ENDIAN) / sampleUnits;
+    return size / (unitSize == 0 ? 1 : unitSize) + 1;
+}
+
+/// @brief Get the level.dat like compound of about 4 KiB, has the game rules and the player with inventory.
+inline Tag level(UInt64 seed)
+{
+    Random rand(seed);
+
+    Tag data = gCompound("Data");
+    data << gString("World " + std::to_string(rand.nextInt(10000)), "LevelName");
+    data << gLong(static_cast<Int64>(rand.next() >> 24), "Time");
+    data << gLong(static_cast<Int64>(rand.next()), "RandomSeed");
+    data << gInt(3700, "DataVersion") << gByte(1, "allowCommands") << gDouble(0.2, "BorderDamagePerBlock");
+
+    Tag rules = gCompound("GameRules");
+    for (int i = 0; i < 40; ++i)
+        rules << gString(rand.nextBool(50) ? "true" : "false", "gameRule" + std::to_string(i));
+    data << rules;
+
+    // The random values are drawn one per statement, as the order of evaluation of the operands is unspecified.
+    Tag player = gCompound("Player");
+    Fp32 x = rand.nextFloat(-1000, 1000);
+    Fp32 y = rand.nextFloat(0, 256);
+    Fp32 z = rand.nextFloat(-1000, 1000);
+    player << (gList(TT_DOUBLE, "Pos") << gDouble(x) << gDouble(y) << gDouble(z));
+    Fp32 yaw = rand.nextFloat(0, 360);
+    Fp32 pitch = rand.nextFloat(-90, 90);
+    player << (gList(TT_FLOAT, "Rotation") << gFloat(yaw) << gFloat(pitch));
+    Vec<Int32> uuid(4);
+    for (auto& var : uuid)
+        var = rand.nextInt(1 << 30);
+    player << gIntArray(uuid, "UUID");
+    player << gFloat(20.0f, "Health");
+
+    size_t nameCount = 0;
+    const char* const* names = _blockNames(nameCount);
+    Tag inventory = gList(TT_COMPOUND, "Inventory");
+    for (int i = 0; i < 36; ++i)
+    {
+        Tag item = gCompound();
+        item << gByte(static_cast<Byte>(i), "Slot");
+        item << gString(names[rand.nextInt(static_cast<Int32>(nameCount))], "id");
+        item << gByte(static_cast<Byte>(1 + rand.nextInt(64)), "Count");
+        item << (gCompound("tag") << gInt(rand.nextInt(1000), "Damage"));
+        inventory << item;
+    }
+    player << inventory;
+    data << player;
+
+    Tag root = gCompound();
+    root << data;
+
+    return root;
+}
+
+/// @brief Get the compound of the compounds and lists nested alternately.
+/// @param depth    The depth of nesting, the root compound is the first level.
+/// @param breadth  The count of children of each compound or list, the count of compounds is
+// about breadth ^ (depth / 2), take care of the large breadth.
+/// @attention The depth above the limit of reading (512) makes the document can't be read.
+inline Tag nested(UInt64 seed, size_t depth, size_t breadth = 1)
+{
+    Random rand(seed);
+
+    // Build from the innermost level, so the copies of children are cheap.
+    Tag child;
+    for (size_t level = depth; level > 0; --level)
+    {
+        Tag tag;
+        if (level % 2 == 1)
+        {
+            tag = gCompound();
+            tag << gInt(static_cast<Int32>(level), "level") << gString("node", "name");
+            tag << gDouble(rand.nextFloat(0, 1), "weight");
+            for (size_t i = 0; i < breadth && !child.isEnd(); ++i)
+                tag << child.copy().setName("child" + std::to_string(i));
+        }
+        else
+        {
+            tag = gList(child.isEnd() ? TT_INT : TT_COMPOUND);
+            for (size_t i = 0; i < breadth; ++i)
+            {
+                if (child.isEnd())
+                    tag << gInt(rand.nextInt(1000));
+                else
+                    tag << child.copy();
+            }
+        }
+
+        child = tag;
+    }
+
+    return child.isEnd() ? gCompound() : child;
+}
+
+/// @brief Get the compound of members of all the types, mostly numbers and strings.
+inline Tag wideCompound(UInt64 seed, size_t width)
+{
+    Random rand(seed);
+
+    Tag tag = gCompound();
+    tag.reserve(width);
+    for (size_t i = 0; i < width; ++i)
+    {
+        String name = "member" + std::to_string(i);
+        switch (i % 10)
+        {
+            case 0:     tag << gByte(static_cast<Byte>(rand.nextInt(128)), name); break;
+            case 1:     tag << gShort(static_cast<Int16>(rand.nextInt(32768)), name); break;
+            case 2:     tag << gInt(rand.nextInt(1 << 30), name); break;
+            case 3:     tag << gLong(static_cast<Int64>(rand.next() >> 1), name); break;
+            case 4:     tag << gFloat(rand.nextFloat(-1, 1), name); break;
+            case 5:     tag << gDouble(rand.nextFloat(-1000, 1000), name); break;
+            case 6:     tag << gString("value" + std::to_string(rand.nextInt(1000)), name); break;
+            case 7:     tag << gByteArray({ 1, 2, 3, static_cast<Byte>(rand.nextInt(128)) }, name); break;
+            case 8:
+            {
+                Int32 first = rand.nextInt(100);
+                Int32 second = rand.nextInt(100);
+                tag << (gList(TT_INT, name) << gInt(first) << gInt(second));
+                break;
+            }
+            default:    tag << (gCompound(name) << gByte(static_cast<Byte>(rand.nextBool(50)), "flag")); break;
+        }
+    }
+
+    return tag;
+}
+
+/// @brief Get the compound of long arrays named `data<index>`, e.g. the block states and heightmaps of chunks.
+inline Tag longArrays(UInt64 seed, size_t count, size_t length)
+{
+    Random rand(seed);
+
+    Tag tag = gCompound();
+    Vec<Int64> data(length);
+    for (size_t i = 0; i < count; ++i)
+    {
+        for (auto& var : data)
+            var = static_cast<Int64>(rand.next());
+
+        Tag array(TT_LONG_ARRAY);
+        array.setName("data" + std::to_string(i));
+        array.appendLongs(data.data(), data.size());
+        tag << array;
+    }
+
+    return tag;
+}
+
+/// @brief Get the list of entities, each is the tag of #be::CommonEntityData.
+inline Tag entities(UInt64 seed, size_t count)
+{
+    Random rand(seed);
+    size_t idCount = 0;
+    const char* const* ids = _entityIds(idCount);
+
+    Tag list = gList(TT_COMPOUND);
+    list.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        be::CommonEntityData entity(ids[rand.nextInt(static_cast<Int32>(idCount))]);
+        entity.isBaby = rand.nextBool(20);
+        entity.isOnGround = rand.nextBool(80);
+        entity.fireTicks = static_cast<Int16>(rand.nextBool(5) ? rand.nextInt(200) : 0);
+        entity.lastDimensionId = 0;
+        entity.strength = rand.nextInt(5);
+        entity.strengthMax = 5;
+        entity.variant = rand.nextInt(4);
+        entity.uniqueId = -static_cast<Int64>(rand.next() >> 20);
+        entity.fallDistance = rand.nextFloat(0, 3);
+        entity.definitions.push_back(String("+") + entity.id);
+        if (rand.nextBool(30))
+            entity.tags.push_back("tagged");
+
+        entity.pos[0] = rand.nextFloat(-1000, 1000);
+        entity.pos[1] = rand.nextFloat(0, 256);
+        entity.pos[2] = rand.nextFloat(-1000, 1000);
+        entity.rotation[0] = rand.nextFloat(0, 360);
+        entity.rotation[1] = rand.nextFloat(-90, 90);
+
+        list << entity.getTag();
+    }
+
+    return list;
+}
+
+/// @brief Get the list of blocks of `name`, `states` and `version`, the names are unique.
+inline Tag blockPalette(UInt64 seed, size_t count)
+{
+    static const char* const axes[] = { "x", "y", "z" };
+    static const char* const facings[] = { "north", "south", "east", "west", "up", "down" };
+
+    Random rand(seed);
+    size_t nameCount = 0;
+    const char* const* names = _blockNames(nameCount);
+
+    Tag list = gList(TT_COMPOUND);
+    list.reserve(count);
+    for (size_t i = 0; i < count; ++i)
+    {
+        String name = names[i % nameCount];
+        if (i >= nameCount)
+            name += "_" + std::to_string(i / nameCount);
+
+        Tag states = gCompound("states");
+        if (rand.nextBool(50))
+            states << gString(rand.pick(axes), "pillar_axis");
+        if (rand.nextBool(30))
+        {
+            Int32 direction = rand.nextInt(6);
+            states << gInt(direction, "facing_direction") << gString(rand.pick(facings), "facing");
+        }
+        if (rand.nextBool(20))
+            states << gByte(static_cast<Byte>(rand.nextBool(50)), "open_bit");
+
+        Tag block = gCompound();
+        block << gString(name, "name") << states << gInt(18105860, "version");
+        list << block;
+    }
+
+    return list;
+}
+
+/// @brief Get the MCStructure of the size, the blocks are random in the palette, about 1% of the blocks
+// have the block entity data and 1 entity per 1000 blocks.
+inline Tag mcstructure(UInt64 seed, Int32 sizeX, Int32 sizeY, Int32 sizeZ, size_t paletteSize = 16)
+{
+    Random rand(seed);
+    be::MCStructure mcs(1, sizeX, sizeY, sizeZ);
+    size_t volume = static_cast<size_t>(sizeX) * static_cast<size_t>(sizeY) * static_cast<size_t>(sizeZ);
+
+    Vec<Int32> indices(volume);
+    for (auto& var : indices)
+        var = rand.nextInt(static_cast<Int32>(paletteSize));
+    mcs.blockIndices1().appendInts(indices.data(), indices.size());
+
+    indices.assign(volume, -1);
+    mcs.blockIndices2().appendInts(indices.data(), indices.size());
+
+    Tag palette = blockPalette(seed, paletteSize);
+    Tag& blockPalette = mcs.blockPalette();
+    for (size_t i = 0; i < palette.size(); ++i)
+        blockPalette << palette[i].copy();
+
+    Tag& positions = mcs.blockPositionData();
+    for (size_t i = 0; i < volume; ++i)
+    {
+        if (!rand.nextBool(1))
+            continue;
+
+        Int32 x = static_cast<Int32>(i / (static_cast<size_t>(sizeY) * sizeZ));
+        Int32 y = static_cast<Int32>(i / sizeZ % sizeY);
+        Int32 z = static_cast<Int32>(i % sizeZ);
+
+        Tag items = gList(TT_COMPOUND, "Items");
+        for (Int32 j = rand.nextInt(4); j > 0; --j)
+        {
+            Tag item = gCompound();
+            item << gString("minecraft:stone", "Name") << gByte(static_cast<Byte>(1 + rand.nextInt(64)), "Count");
+            item << gByte(static_cast<Byte>(j), "Slot");
+            items << item;
+        }
+
+        Tag entity = gCompound("block_entity_data");
+        entity << gString("Chest", "id") << gInt(x, "x") << gInt(y, "y") << gInt(z, "z") << items;
+        positions << (gCompound(std::to_string(i)) << entity);
+    }
+
+    Tag list = entities(seed + 1, volume / 1000);
+    Tag& entityList = mcs.entities();
+    for (size_t i = 0; i < list.size(); ++i)
+        entityList << list[i].copy();
+
+    return mcs.root;
+}
+
+/// @brief Get the region like compound of the chunks, each has 16 sections of block states (long arrays of
+// 256 longs with small palette), some block entities and entities, and the heightmaps, about 40 KiB.
+inline Tag region(UInt64 seed, size_t chunks)
+{
+    Random rand(seed);
+
+    Tag list = gList(TT_COMPOUND, "chunks");
+    list.reserve(chunks);
+    for (size_t c = 0; c < chunks; ++c)
+    {
+        Tag chunk = gCompound();
+        chunk << gInt(static_cast<Int32>(c % 32), "xPos") << gInt(static_cast<Int32>(c / 32), "zPos");
+        chunk << gString("minecraft:full", "Status") << gLong(static_cast<Int64>(rand.next() >> 40), "InhabitedTime");
+
+        Tag sections = gList(TT_COMPOUND, "sections");
+        for (int y = 0; y < 16; ++y)
+        {
+            Tag blockStates = gCompound("block_states");
+            UInt64 paletteSeed = rand.next();
+            size_t paletteSize = static_cast<size_t>(1 + rand.nextInt(8));
+            blockStates << blockPalette(paletteSeed, paletteSize).setName("palette");
+            blockStates << longArrays(rand.next(), 1, 256)["data0"].copy().setName("data");
+
+            Tag section = gCompound();
+            section << gByte(static_cast<Byte>(y), "Y") << blockStates;
+            section << (gCompound("biomes") << (gList(TT_STRING, "palette") << gString("minecraft:plains")));
+            sections << section;
+        }
+        chunk << sections;
+
+        Tag blockEntities = gList(TT_COMPOUND, "block_entities");
+        for (Int32 i = rand.nextInt(8); i > 0; --i)
+        {
+            Tag entity = gCompound();
+            Int32 x = rand.nextInt(16);
+            Int32 y = rand.nextInt(256);
+            Int32 z = rand.nextInt(16);
+            entity << gString("minecraft:chest", "id") << gInt(x, "x") << gInt(y, "y") << gInt(z, "z");
+            entity << gByte(0, "keepPacked");
+            blockEntities << entity;
+        }
+        chunk << blockEntities;
+        UInt64 entitySeed = rand.next();
+        size_t entityCount = static_cast<size_t>(rand.nextInt(4));
+        chunk << entities(entitySeed, entityCount).setName("entities");
+
+        Tag heightmaps = longArrays(rand.next(), 1, 37);
+        heightmaps["data0"].setName("MOTION_BLOCKING");
+        chunk << heightmaps.setName("Heightmaps");
+
+        list << chunk;
+    }
+
+    Tag root = gCompound();
+    root << gInt(3700, "DataVersion") << list;
+
+    return root;
+}
+
+/// @brief Get the document of the kind, of about the size of binary. (#DK_LEVEL ignores the size)
+inline Tag generate(DocumentKind kind, UInt64 seed, size_t size)
+{
+    switch (kind)
+    {
+        case DK_LEVEL:
+            return level(seed);
+        case DK_NESTED:
+        {
+            // The chains of nesting of depth 256, in the list of the root.
+            const size_t depth = 256;
+            Tag chain = nested(seed, depth);
+            size_t count = _unitCount(chain, 1, size);
+
+            Tag list = gList(TT_COMPOUND, "chains");
+            list.reserve(count);
+            for (size_t i = 0; i < count; ++i)
+                list << (i == 0 ? chain : nested(seed + i, depth));
+
+            Tag root = gCompound();
+            root << list;
+            return root;
+        }
+        case DK_WIDE:
+            return wideCompound(seed, _unitCount(wideCompound(seed, 1000), 1000, size));
+        case DK_LONG_ARRAYS:
+        {
+            // The arrays of 1M longs (8 MiB) at most.
+            size_t length = size / 8 < (1 << 20) ? size / 8 + 1 : (1 << 20);
+            return longArrays(seed, size / (length * 8) + 1, length);
+        }
+        case DK_ENTITIES:
+        {
+            Tag root = gCompound();
+            root << entities(seed, _unitCount(entities(seed, 100), 100, size)).setName("entities");
+            return root;
+        }
+        case DK_BLOCK_PALETTE:
+        {
+            Tag root = gCompound();
+            root << blockPalette(seed, _unitCount(blockPalette(seed, 100), 100, size)).setName("block_palette");
+            return root;
+        }
+        case DK_MCSTRUCTURE:
+        {
+            // 8 bytes of the block indices per block mostly.
+            Int32 edge = 1;
+            while (static_cast<size_t>(edge + 1) * (edge + 1) * (edge + 1) * 8 <= size)
+                ++edge;
+            return mcstructure(seed, edge, edge, edge);
+        }
+        case DK_REGION:
+            return region(seed, _unitCount(region(seed, 4), 4, size));
+        default:
+            return gCompound();
+    }
+}
+
+} // namespace corpus
+
+} // namespace nbt
+
+#endif // !MCNBT_CORPUS_HPP
@@ -2,7 +2,9 @@
 #define MCNBT_GZIP_HPP
 
 #include <cstddef>      // size_t
+#include <cstring>      // memcpy()
 #include <string>       // string
+#include <vector>       // vector
 #include <limits>       // numeric_limits
 #include <stdexcept>    // runtime_error
 
@@ -11,6 +13,8 @@
 #endif // !ZLIB_CONST
 #include <zlib.h>
 
+#include "stats.hpp"
+
 namespace nbt
 {
 
@@ -18,9 +22,9 @@ namespace gzip
 {
 
 /// @brief Checks if the given data is compressed using Gzip or Zlib.
-inline bool isCompressed(const std::string& data)
+inline bool isCompressed(const char* data, size_t size)
 {
-    if (data.size() < 2)
+    if (size < 2)
         return false;
 
     unsigned char byte1 = data[0];
@@ -33,9 +37,9 @@ inline bool isCompressed(const std::string& data)
 }
 
 /// @overload
-inline bool isCompressed(const char* data, size_t size)
+inline bool isCompressed(const std::string& data)
 {
-    return isCompressed(std::string(data, size));
+    return isCompressed(data.data(), data.size());
 }
 
 /// @brief Compresses the given data using Gzip.
@@ -44,6 +48,8 @@ inline std::string compress(const std::string& data)
     if (data.size() > std::numeric_limits<uInt>::max())
         throw std::runtime_error("The input data is too large to be compressed.");
 
+    MCNBT_STATS(_StatsScope scope(SK_COMPRESS);)
+
     z_stream stream;
     stream.zalloc = Z_NULL;
     stream.zfree = Z_NULL;
@@ -76,7 +82,9 @@ inline std::string compress(const std::string& data)
         stream.avail_out = increaseSize;
         stream.next_out = reinterpret_cast<Bytef*>(&compressed[0] + compressedSize);
 
+        MCNBT_STATS(uint64_t begin = _statsNow();)
         ret = deflate(&stream, Z_FINISH);
+        MCNBT_STATS(scope.stats().gzipNs += _statsNow() - begin;)
         if (ret != Z_STREAM_END && ret != Z_OK)
         {
             std::string errmsg = stream.msg;
@@ -91,6 +99,9 @@ inline std::string compress(const std::string& data)
 
     compressed.resize(compressedSize);
 
+    MCNBT_STATS(scope.stats().uncompressedBytes += data.size();)
+    MCNBT_STATS(scope.stats().compressedBytes += compressedSize;)
+
     return compressed;
 }
 
@@ -106,6 +117,8 @@ inline std::string decompress(const std::string& data)
     if (data.size() * 2 > std::numeric_limits<uInt>::max())
         throw std::runtime_error("The input data is too large to be compressed.");
 
+    MCNBT_STATS(_StatsScope scope(SK_DECOMPRESS);)
+
     z_stream stream;
 
     stream.zalloc = Z_NULL;
@@ -133,10 +146,13 @@ inline std::string decompress(const std::string& data)
         stream.avail_out = static_cast<uInt>(decompressed.size() - decompressedSize);
         stream.next_out = reinterpret_cast<Bytef*>(&decompressed[0] + decompressedSize);
 
+        // With Z_FINISH, the full output buffer is reported as Z_BUF_ERROR, then the buffer grows and continues.
+        MCNBT_STATS(uint64_t begin = _statsNow();)
         ret = inflate(&stream, Z_FINISH);
-        if (ret != Z_STREAM_END && ret != Z_OK)
+        MCNBT_STATS(scope.stats().gzipNs += _statsNow() - begin;)
+        if (ret != Z_STREAM_END && ret != Z_OK && !(ret == Z_BUF_ERROR && stream.avail_out == 0))
         {
-            std::string errmsg = stream.msg;
+            std::string errmsg = stream.msg ? stream.msg : "Incomplete data.";
             inflateEnd(&stream);
             throw std::runtime_error("Failed to inflate data: " + errmsg);
         }
@@ -148,6 +164,9 @@ inline std::string decompress(const std::string& data)
 
     decompressed.resize(decompressedSize);
 
+    MCNBT_STATS(scope.stats().compressedBytes += data.size();)
+    MCNBT_STATS(scope.stats().uncompressedBytes += decompressedSize;)
+
     return decompressed;
 }
 
@@ -157,6 +176,222 @@ inline std::string decompress(const char* data, size_t size)
     return decompress(std::string(data, size));
 }
 
+/// @brief The sink which compresses the data with Gzip chunk by chunk and writes to the underlying sink.
+/// @tparam Sink Any type has the member functions put(char) and write(const char*, size_t).
+/// @note Must call #finish() after all data is written, else the Gzip stream is incomplete.
+template <typename Sink>
+class CompressSink
+{
+public:
+    explicit CompressSink(Sink& sink, int level = Z_DEFAULT_COMPRESSION) :
+        sink_(sink), in_(1 << 16), out_(1 << 16)
+    {
+        stream_.zalloc = Z_NULL;
+        stream_.zfree = Z_NULL;
+        stream_.opaque = Z_NULL;
+        stream_.avail_in = 0;
+        stream_.next_in = Z_NULL;
+
+        if (deflateInit2(&stream_, level, Z_DEFLATED, 15 + 16, 8, Z_DEFAULT_STRATEGY) != Z_OK)
+            throw std::runtime_error("Failed to initialize zlib deflate.");
+    }
+
+    ~CompressSink()                 { deflateEnd(&stream_); }
+
+    CompressSink(const CompressSink&) = delete;
+    CompressSink& operator=(const CompressSink&) = delete;
+
+    void put(char ch)
+    {
+        if (size_ == in_.size())
+            deflate_(Z_NO_FLUSH);
+        in_[size_++] = ch;
+    }
+
+    void write(const char* data, size_t size)
+    {
+        while (size != 0)
+        {
+            if (size_ == in_.size())
+                deflate_(Z_NO_FLUSH);
+
+            size_t n = in_.size() - size_ < size ? in_.size() - size_ : size;
+            std::memcpy(in_.data() + size_, data, n);
+            size_ += n;
+            data += n;
+            size -= n;
+        }
+    }
+
+    /// @brief Get the count of (uncompressed) bytes already written.
+    size_t pos() const              { return static_cast<size_t>(stream_.total_in) + size_; }
+
+    /// @brief Compress the remaining data and write the end of Gzip stream.
+    void finish()
+    {
+        if (!finished_)
+            deflate_(Z_FINISH);
+        finished_ = true;
+    }
+
+private:
+    void deflate_(int flush)
+    {
+        stream_.next_in = reinterpret_cast<z_const Bytef*>(in_.data());
+        stream_.avail_in = static_cast<uInt>(size_);
+
+        int ret = Z_OK;
+        do
+        {
+            stream_.next_out = reinterpret_cast<Bytef*>(out_.data());
+            stream_.avail_out = static_cast<uInt>(out_.size());
+
+            MCNBT_STATS(CodecStats* stats = _currentStats();)
+            MCNBT_STATS(uint64_t begin = stats ? _statsNow() : 0;)
+            ret = deflate(&stream_, flush);
+            if (ret == Z_STREAM_ERROR)
+                throw std::runtime_error("Failed to deflate data.");
+
+            MCNBT_STATS(if (stats) stats->gzipNs += _statsNow() - begin;)
+            MCNBT_STATS(if (stats) stats->compressedBytes += out_.size() - stream_.avail_out;)
+
+            sink_.write(out_.data(), out_.size() - stream_.avail_out);
+        } while (stream_.avail_out == 0 || (flush == Z_FINISH && ret != Z_STREAM_END));
+
+        MCNBT_STATS(if (_currentStats()) _currentStats()->uncompressedBytes += size_;)
+        size_ = 0;
+    }
+
+    Sink& sink_;
+    z_stream stream_;
+    std::vector<char> in_;
+    std::vector<char> out_;
+    size_t size_ = 0;
+    bool finished_ = false;
+};
+
+/// @brief The source which reads the Gzip or Zlib compressed data from the underlying source and decompresses
+/// it chunk by chunk.
+/// @tparam Source Any type has the member function `size_t read(char*, size_t)`.
+template <typename Source>
+class DecompressSource
+{
+public:
+    explicit DecompressSource(Source& src) : src_(src), in_(1 << 16), out_(1 << 16)
+    {
+        stream_.zalloc = Z_NULL;
+        stream_.zfree = Z_NULL;
+        stream_.opaque = Z_NULL;
+        stream_.avail_in = 0;
+        stream_.next_in = Z_NULL;
+
+        if (inflateInit2(&stream_, 15 + 32) != Z_OK)
+            throw std::runtime_error("Failed to initialize zlib inflate.");
+    }
+
+    ~DecompressSource()             { inflateEnd(&stream_); }
+
+    DecompressSource(const DecompressSource&) = delete;
+    DecompressSource& operator=(const DecompressSource&) = delete;
+
+    int get()
+    {
+        if (cur_ == end_ && !refill_())
+            return std::char_traits<char>::eof();
+        return static_cast<unsigned char>(out_[cur_++]);
+    }
+
+    int peek()
+    {
+        if (cur_ == end_ && !refill_())
+            return std::char_traits<char>::eof();
+        return static_cast<unsigned char>(out_[cur_]);
+    }
+
+    size_t read(char* dst, size_t size)
+    {
+        size_t total = 0;
+        while (total < size)
+        {
+            if (cur_ == end_ && !refill_())
+                break;
+
+            size_t n = end_ - cur_ < size - total ? end_ - cur_ : size - total;
+            std::memcpy(dst + total, out_.data() + cur_, n);
+            cur_ += n;
+            total += n;
+        }
+
+        return total;
+    }
+
+    void skip(size_t size)
+    {
+        while (size != 0)
+        {
+            if (cur_ == end_ && !refill_())
+                throw std::runtime_error("Unexpected end of data.");
+
+            size_t n = end_ - cur_ < size ? end_ - cur_ : size;
+            cur_ += n;
+            size -= n;
+        }
+    }
+
+    /// @brief Get the count of (decompressed) bytes already read.
+    size_t pos() const              { return static_cast<size_t>(stream_.total_out) - (end_ - cur_); }
+
+private:
+    bool refill_()
+    {
+        cur_ = 0;
+        end_ = 0;
+
+        while (end_ == 0 && !finished_)
+        {
+            if (stream_.avail_in == 0)
+            {
+                size_t n = src_.read(in_.data(), in_.size());
+                if (n == 0)
+                    throw std::runtime_error("Failed to inflate data: unexpected end of compressed data.");
+
+                stream_.next_in = reinterpret_cast<z_const Bytef*>(in_.data());
+                stream_.avail_in = static_cast<uInt>(n);
+            }
+
+            stream_.next_out = reinterpret_cast<Bytef*>(out_.data());
+            stream_.avail_out = static_cast<uInt>(out_.size());
+
+            MCNBT_STATS(CodecStats* stats = _currentStats();)
+            MCNBT_STATS(uint64_t begin = stats ? _statsNow() : 0;)
+            MCNBT_STATS(uInt availIn = stream_.avail_in;)
+            int ret = inflate(&stream_, Z_NO_FLUSH);
+            if (ret != Z_OK && ret != Z_STREAM_END && ret != Z_BUF_ERROR)
+            {
+                std::string errmsg = stream_.msg ? stream_.msg : "unknown error";
+                throw std::runtime_error("Failed to inflate data: " + errmsg);
+            }
+
+            finished_ = ret == Z_STREAM_END;
+            end_ = out_.size() - stream_.avail_out;
+
+            MCNBT_STATS(if (stats) stats->gzipNs += _statsNow() - begin;)
+            MCNBT_STATS(if (stats) stats->compressedBytes += availIn - stream_.avail_in;)
+            MCNBT_STATS(if (stats) stats->uncompressedBytes += end_;)
+        }
+
+        return end_ != 0;
+    }
+
+    Source& src_;
+    z_stream stream_;
+    std::vector<char> in_;
+    std::vector<char> out_;
+    size_t cur_ = 0;
+    size_t end_ = 0;
+    bool finished_ = false;
+};
+
 } // namespace gzip
 
 } // namespace nbt
@@ -33,18 +33,46 @@
 
 #include <cstdint>          // int16_t, int32_t, int64_t
 #include <cstddef>          // size_t
-#include <cstring>          // strlen(), memcpy()
+#include <cstring>          // strlen(), memcpy(), strerror()
 #include <string>           // string, to_string()
 #include <vector>           // vector
 #include <unordered_map>    // unordered_map
+#include <unordered_set>    // unordered_set
+#include <memory>           // shared_ptr
+#include <atomic>           // atomic
 #include <iostream>         // istream, ostream
 #include <fstream>          // ifstream, ofstream
 #include <sstream>          // stringstream
 #include <stdexcept>        // runtime_error, logic_error, out_of_range
 #include <cassert>          // assert()
+#include <algorithm>        // sort()
+#include <type_traits>      // is_integral
+#include <cerrno>           // errno, EINTR
+#include <chrono>           // steady_clock
+
+#include <cstdio>           // rename(), remove()
+#include <fcntl.h>          // open(), O_RDONLY, O_DIRECT
+
+#ifdef _WIN32
+    #include <io.h>         // _open(), _read(), _write(), _commit()
+    #include <process.h>    // _getpid()
+    #include <sys/stat.h>   // _fstat64()
+#else
+    #include <unistd.h>     // read(), write(), fdatasync(), getpid()
+    #include <sys/stat.h>   // fstat(), fchmod()
+    #include <sys/mman.h>   // mmap(), munmap()
+#endif // _WIN32
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+    #include <immintrin.h>  // _mm_shuffle_epi8(), _mm256_shuffle_epi8()
+#elif defined(__ARM_NEON)
+    #include <arm_neon.h>   // vrev16q_u8(), vrev32q_u8(), vrev64q_u8()
+#endif
 
 #include <mcnbt/config.hpp>
 
+#include "stats.hpp"
+
 #ifdef MCNBT_ENABLE_GZIP
     #include "gzip.hpp"
 #endif // MCNBT_ENABLE_GZIP
@@ -59,6 +87,9 @@ using Byte      = char;
 using Int16     = int16_t;
 using Int32     = int32_t;
 using Int64     = int64_t;
+using UInt16    = uint16_t;
+using UInt32    = uint32_t;
+using UInt64    = uint64_t;
 using Fp32      = float;
 using Fp64      = double;
 
@@ -105,12 +136,28 @@ enum TagType : UChar
     TT_LONG_ARRAY   = 12
 };
 
+/// @brief The enum of binary encoding of NBT.
+enum Encoding : UChar
+{
+    EC_BIG_ENDIAN       = 0,    ///< Java edition.
+    EC_LITTLE_ENDIAN    = 1,    ///< Bedrock edition (file and level database).
+    EC_NETWORK          = 2     ///< Bedrock edition network protocol. (little endian with VarInt)
+};
+
+/// @brief Get the encoding of the specified endianness.
+inline Encoding getEncoding(bool isBigEndian)
+{ return isBigEndian ? EC_BIG_ENDIAN : EC_LITTLE_ENDIAN; }
+
 // Constants about the indent of snbt.
 
 constexpr size_t _SNBT_INDENT_WIDTH     = 2;
 constexpr char _SNBT_INDENT_CHAR        = 0x20;     // Space
 static const String _SNBT_INDENT_STR    = String(_SNBT_INDENT_WIDTH, _SNBT_INDENT_CHAR);
 
+// Constants about the binary data.
+
+constexpr size_t _MAX_NESTING_DEPTH     = 512;      // Same as the limit of Minecraft.
+
 // Aux functions about the tag type.
 
 inline bool isEnd(TagType type)
@@ -167,6 +214,15 @@ inline bool isArray(TagType type)
 inline bool isContainer(TagType type)
 { return isList(type) || isCompound(type); }
 
+/// @brief The tag type of the number type. (e.g. #TT_INT of #Int32)
+template <typename T> struct _NumTagType;
+template <> struct _NumTagType<Byte>    { static constexpr TagType value = TT_BYTE; };
+template <> struct _NumTagType<Int16>   { static constexpr TagType value = TT_SHORT; };
+template <> struct _NumTagType<Int32>   { static constexpr TagType value = TT_INT; };
+template <> struct _NumTagType<Int64>   { static constexpr TagType value = TT_LONG; };
+template <> struct _NumTagType<Fp32>    { static constexpr TagType value = TT_FLOAT; };
+template <> struct _NumTagType<Fp64>    { static constexpr TagType value = TT_DOUBLE; };
+
 /// @brief Get the string text of the tag type.
 inline String getTagTypeString(TagType type)
 {
@@ -218,6 +274,10 @@ inline void _reverse(char* srcStr, char* dstStr, size_t size = 0)
 /// @brief Check whether the memory order of system of compiler environment is big endian.
 inline bool _isBigEndian()
 {
+#if defined(__BYTE_ORDER__) && defined(__ORDER_BIG_ENDIAN__)
+    // Known at compile time, so the branches on it can be folded.
+    return __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__;
+#else
     static bool isInited = false;
     static bool rslt = false;
 
@@ -230,6 +290,132 @@ inline bool _isBigEndian()
     isInited = true;
 
     return rslt;
+#endif
+}
+
+// Functions of byte swap.
+
+inline UInt16 _byteswap16(UInt16 num)
+{ return static_cast<UInt16>((num >> 8) | (num << 8)); }
+
+inline UInt32 _byteswap32(UInt32 num)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap32(num);
+#else
+    return ((num & 0xFF000000u) >> 24) | ((num & 0x00FF0000u) >> 8) |
+           ((num & 0x0000FF00u) << 8) | ((num & 0x000000FFu) << 24);
+#endif
+}
+
+inline UInt64 _byteswap64(UInt64 num)
+{
+#if defined(__GNUC__) || defined(__clang__)
+    return __builtin_bswap64(num);
+#else
+    return (static_cast<UInt64>(_byteswap32(static_cast<UInt32>(num))) << 32) |
+           _byteswap32(static_cast<UInt32>(num >> 32));
+#endif
+}
+
+/// @brief Reverse the bytes of each element of an array.
+/// @param dst      The destination, can be equal to the src.
+/// @param count    The count of elements.
+/// @param width    The size of element, must be 1, 2, 4 or 8.
+inline void _reverseEach(char* dst, const char* src, size_t count, size_t width)
+{
+    size_t bytes = count * width;
+    size_t i = 0;
+
+    if (width == 1)
+    {
+        if (dst != src)
+            std::memmove(dst, src, bytes);
+        return;
+    }
+
+#if defined(__AVX2__) || defined(__SSSE3__)
+    // The shuffle control of reverse bytes in each 2, 4 or 8 bytes lane.
+    alignas(16) static const char masks[3][16] = {
+        { 1, 0, 3, 2, 5, 4, 7, 6, 9, 8, 11, 10, 13, 12, 15, 14 },
+        { 3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12 },
+        { 7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8 }
+    };
+    const char* mask = masks[width == 2 ? 0 : (width == 4 ? 1 : 2)];
+    __m128i mask128 = _mm_load_si128(reinterpret_cast<const __m128i*>(mask));
+
+#if defined(__AVX2__)
+    __m256i mask256 = _mm256_broadcastsi128_si256(mask128);
+    for (; i + 32 <= bytes; i += 32)
+    {
+        __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(src + i));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_shuffle_epi8(v, mask256));
+    }
+#endif // __AVX2__
+    for (; i + 16 <= bytes; i += 16)
+    {
+        __m128i v = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + i));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_shuffle_epi8(v, mask128));
+    }
+#elif defined(__ARM_NEON)
+    for (; i + 16 <= bytes; i += 16)
+    {
+        uint8x16_t v = vld1q_u8(reinterpret_cast<const uint8_t*>(src + i));
+        if (width == 2)         v = vrev16q_u8(v);
+        else if (width == 4)    v = vrev32q_u8(v);
+        else                    v = vrev64q_u8(v);
+        vst1q_u8(reinterpret_cast<uint8_t*>(dst + i), v);
+    }
+#endif
+
+    // The remainder (or all, if without SIMD) in scalar.
+    for (; i < bytes; i += width)
+    {
+        if (width == 2)
+        {
+            UInt16 v;
+            std::memcpy(&v, src + i, 2);
+            v = _byteswap16(v);
+            std::memcpy(dst + i, &v, 2);
+        }
+        else if (width == 4)
+        {
+            UInt32 v;
+            std::memcpy(&v, src + i, 4);
+            v = _byteswap32(v);
+            std::memcpy(dst + i, &v, 4);
+        }
+        else
+        {
+            UInt64 v;
+            std::memcpy(&v, src + i, 8);
+            v = _byteswap64(v);
+            std::memcpy(dst + i, &v, 8);
+        }
+    }
+}
+
+/// @brief Load a number from memory bytes with the specified endianness.
+template <typename T>
+T _loadNum(const char* src, bool isBigEndian)
+{
+    T num;
+    if (isBigEndian != _isBigEndian())
+        _reverseEach(reinterpret_cast<char*>(&num), src, 1, sizeof(T));
+    else
+        std::memcpy(&num, src, sizeof(T));
+
+    return num;
+}
+
+/// @brief Store a number to memory bytes with the specified endianness.
+template <typename T>
+void _storeNum(T num, char* dst, bool isBigEndian)
+{
+    if (isBigEndian != _isBigEndian())
+        _reverseEach(dst, reinterpret_cast<const char*>(&num), 1, sizeof(T));
+    else
+        std::memcpy(dst, &num, sizeof(T));
 }
 
 /// @brief Obtain bytes from input stream, and convert it to number.
@@ -268,2169 +454,6215 @@ T _bytes2num(IStream& is, bool isBigEndian = false, bool resumeCursor = false)
 
 /// @brief Convert the number to bytes, and write it to output stream.
 /// @param num              The number to convert.
-/// @param os               The output stream.
+/// @param os               The output stream or any sink has the member functions put(char) and write(const char*, n).
 /// @param isBigEndian      The endianness of the bytes need to write.
-template <typename T>
-void _num2bytes(T num, OStream& os, bool isBigEndian = false)
+template <typename T, typename Sink>
+void _num2bytes(T num, Sink& os, bool isBigEndian = false)
 {
-    size_t size = sizeof(T);
-    static Byte buffer[sizeof(T)] = {};
+    Byte buffer[sizeof(T)];
 
-    // Convert the number to bytes. (reinterpreting memory bytes)
-    std::memcpy(buffer, &num, size);
-
-    // Reverse the bytes if the specified endianness is different from system's endianness.
-    if (isBigEndian != _isBigEndian())
-        _reverse(buffer, buffer, size);
+    // Convert the number to bytes with the specified endianness.
+    _storeNum<T>(num, buffer, isBigEndian);
 
-    os.write(buffer, size);
+    os.write(buffer, sizeof(T));
 }
 
-} // namespace nbt
+// Functions of VarInt (used by the Bedrock edition network protocol).
 
-// Main
-namespace nbt
-{
+/// @brief ZigZag encode a signed integer, so that small negative numbers also have short VarInt.
+inline UInt32 _zigzagEncode32(Int32 num)
+{ return (static_cast<UInt32>(num) << 1) ^ static_cast<UInt32>(-static_cast<Int32>(static_cast<UInt32>(num) >> 31)); }
 
-class Tag
+/// @overload
+inline UInt64 _zigzagEncode64(Int64 num)
+{ return (static_cast<UInt64>(num) << 1) ^ static_cast<UInt64>(-static_cast<Int64>(static_cast<UInt64>(num) >> 63)); }
+
+inline Int32 _zigzagDecode32(UInt32 num)
+{ return static_cast<Int32>((num >> 1) ^ (~(num & 1) + 1)); }
+
+inline Int64 _zigzagDecode64(UInt64 num)
+{ return static_cast<Int64>((num >> 1) ^ (~(num & 1) + 1)); }
+
+/// @brief Get the count of bytes of the VarInt of the number. (1 to 10)
+inline size_t _varIntSize(UInt64 num)
 {
-public:
-    Tag() = default;
+#if defined(__GNUC__) || defined(__clang__)
+    // Bit width of the number (at least 1) rounded up to a multiple of 7.
+    return (64 - static_cast<size_t>(__builtin_clzll(num | 1)) + 6) / 7;
+#else
+    size_t size = 1;
+    while (num >= 0x80)
+    {
+        num >>= 7;
+        size++;
+    }
+    return size;
+#endif
+}
 
-    /// @note Release all alloced memory and set the parent to nullptr.
-    ~Tag()
+/// @brief Encode the number to VarInt.
+/// @param dst The buffer to store the bytes, must be at least 10 (5 for 32-bit number) bytes.
+/// @return The count of written bytes.
+inline size_t _encodeVarInt(UInt64 num, char* dst)
+{
+    // The size is known up front, so the loop has a fixed trip count and no data dependent exit.
+    size_t size = _varIntSize(num);
+    for (size_t i = 0; i + 1 < size; ++i)
     {
-        release_();
-        parent_ = nullptr;
+        dst[i] = static_cast<char>((num & 0x7F) | 0x80);
+        num >>= 7;
     }
+    dst[size - 1] = static_cast<char>(num);
 
-    /// @note Deep copy but not copy the other's parent.
-    Tag(const Tag& other)
-        : tagType_(other.tagType_), itemType_(other.itemType_)
+    return size;
+}
+
+/// @brief Decode the VarInt from buffer.
+/// @param maxSize  The max count of bytes of the VarInt. (5 for 32-bit number, 10 for 64-bit number)
+/// @return The count of read bytes, 0 if the VarInt is incomplete or too long.
+inline size_t _decodeVarInt(const char* src, const char* end, UInt64& num, size_t maxSize = 10)
+{
+    const UChar* p = reinterpret_cast<const UChar*>(src);
+    size_t avail = static_cast<size_t>(end - src);
+    size_t limit = avail < maxSize ? avail : maxSize;
+
+    // Fast path for the most common one and two bytes VarInt.
+    if (limit >= 2)
     {
-        if (other.isNum())                                      tagData_.num = other.tagData_.num;
-        else if (other.isString() && other.tagData_.str)        tagData_.str = new String(*other.tagData_.str);
-        else if (other.isArray() && other.tagData_.bad)         tagData_.bad = new Vec<Byte>(*other.tagData_.bad);
-        else if (other.isIntArray() && other.tagData_.iad)      tagData_.iad = new Vec<Int32>(*other.tagData_.iad);
-        else if (other.isLongArray() && other.tagData_.lad)     tagData_.lad = new Vec<Int64>(*other.tagData_.lad);
-        else if (other.isList() && other.tagData_.ld)
+        if (p[0] < 0x80)
         {
-            tagData_.ld = new Vec<Tag>();
-            tagData_.ld->reserve(other.tagData_.ld->size());
-
-            for (const auto& var : *other.tagData_.ld)
-            {
-                tagData_.ld->emplace_back(var);
-                tagData_.ld->back().parent_ = this;
-            }
+            num = p[0];
+            return 1;
         }
-        else if (other.isCompound() && other.tagData_.cd)
+        if (p[1] < 0x80)
         {
-            tagData_.cd = new CompoundData();
-            tagData_.cd->reserve(other.tagData_.cd->size());
-
-            tagData_.cd->idxs = other.tagData_.cd->idxs;
-            for (const auto& var : other.tagData_.cd->data)
-            {
-                tagData_.cd->data.emplace_back(var);
-                tagData_.cd->data.back().parent_ = this;
-            }
+            num = (p[0] & 0x7F) | (static_cast<UInt64>(p[1]) << 7);
+            return 2;
         }
-
-        if (other.tagName_ && !other.tagName_->empty())
-            tagName_ = new String(*other.tagName_);
     }
 
-    /// @note Copy the other's parent.
-    Tag(Tag&& other) noexcept
-        : tagType_(other.tagType_), itemType_(other.itemType_), tagData_(other.tagData_), tagName_(other.tagName_)
+    UInt64 rslt = 0;
+    for (size_t i = 0; i < limit; ++i)
     {
-        if (isList() && tagData_.ld)
-        {
-            for (auto& var : *tagData_.ld)
-                var.parent_ = this;
-        }
-        else if (isCompound() && tagData_.cd)
+        rslt |= static_cast<UInt64>(p[i] & 0x7F) << (7 * i);
+        if (p[i] < 0x80)
         {
-            for (auto& var : tagData_.cd->data)
-                var.parent_ = this;
+            num = rslt;
+            return i + 1;
         }
-
-        other.tagData_.str  = nullptr;
-        other.tagName_      = nullptr;
     }
 
-    /// @note Deep copy but not copy the other's parent.
-    Tag& operator=(const Tag& other)
-    {
-        assert(!(isListItem() && (type() != other.type())));
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (isListItem() && (type() != other.type()))
-            throw std::logic_error("Can't assign a tag of incorrect tag type to list element.");
-    #endif
+    return 0;
+}
 
-        if (this == &other)
-            return *this;
+/// @brief Write a VarInt to output stream.
+template <typename Sink>
+void _writeVarInt(UInt64 num, Sink& os)
+{
+    char buffer[10];
+    os.write(buffer, _encodeVarInt(num, buffer));
+}
 
-        release_();
+// Functions of read and write the fields of binary NBT with the specified encoding.
+//
+// The source is any type has the member functions:
+//     int get()                                Read a byte, return EOF if no more data.
+//     int peek()                               Get the next byte without move the cursor, return EOF if no more data.
+//     size_t read(char* dst, size_t size)      Read bytes, return the count of read bytes (less than size at end).
+//     void skip(size_t size)                   Discard bytes, throw if no enough data.
+// The sink is any type has the member functions:
+//     void put(char ch)
+//     void write(const char* data, size_t size)
+// See #BufferSource, #StreamSource, #FileSource, #BufferSink, #VecSink, #StreamSink, #FileSink and the ones in gzip.hpp.
+
+/// @brief Read all the remaining bytes and append them to the vector.
+template <typename Source>
+void _readRemain(Source& src, Vec<Byte>& dst)
+{
+    constexpr size_t kChunkSize = 64 * 1024;
 
-        tagType_ = other.tagType_;
-        itemType_ = other.itemType_;
+    size_t size = dst.size();
+    for (;;)
+    {
+        dst.resize(size + kChunkSize);
+        size_t count = src.read(&dst[size], kChunkSize);
+        size += count;
 
-        if (other.isNum())                                      tagData_.num = other.tagData_.num;
-        else if (other.isString() && other.tagData_.str)        tagData_.str = new String(*other.tagData_.str);
-        else if (other.isArray() && other.tagData_.bad)         tagData_.bad = new Vec<Byte>(*other.tagData_.bad);
-        else if (other.isIntArray() && other.tagData_.iad)      tagData_.iad = new Vec<Int32>(*other.tagData_.iad);
-        else if (other.isLongArray() && other.tagData_.lad)     tagData_.lad = new Vec<Int64>(*other.tagData_.lad);
-        else if (other.isList() && other.tagData_.ld)
-        {
-            tagData_.ld = new Vec<Tag>();
-            tagData_.ld->reserve(other.tagData_.ld->size());
+        if (count < kChunkSize)
+            break;
+    }
 
-            for (const auto& var : *other.tagData_.ld)
-            {
-                tagData_.ld->emplace_back(var);
-                tagData_.ld->back().parent_ = this;
-            }
-        }
-        else if (other.isCompound() && other.tagData_.cd)
-        {
-            tagData_.cd = new CompoundData();
-            tagData_.cd->reserve(other.tagData_.cd->size());
+    dst.resize(size);
+}
 
-            tagData_.cd->idxs = other.tagData_.cd->idxs;
-            for (const auto& var : other.tagData_.cd->data)
-            {
-                tagData_.cd->data.emplace_back(var);
-                tagData_.cd->data.back().parent_ = this;
-            }
-        }
+/// @brief Read the specified count of bytes, throw if no enough data.
+template <typename Source>
+void _readBytes(Source& src, char* dst, size_t size)
+{
+    if (src.read(dst, size) != size)
+        throw std::runtime_error("Unexpected end of data.");
+}
 
-        if (!isListItem() && !other.name().empty())
-            tagName_ = new String(other.name());
+/// @brief Read a fixed width number.
+template <typename T, typename Source>
+T _readNum(Source& src, bool isBigEndian)
+{
+    char buffer[sizeof(T)];
+    _readBytes(src, buffer, sizeof(T));
+    return _loadNum<T>(buffer, isBigEndian);
+}
 
-        return *this;
+/// @brief Read a VarInt.
+/// @param maxSize The max count of bytes of the VarInt. (5 for 32-bit number, 10 for 64-bit number)
+template <typename Source>
+UInt64 _readVarInt(Source& src, size_t maxSize = 10)
+{
+    UInt64 rslt = 0;
+    for (size_t i = 0; i < maxSize; ++i)
+    {
+        int ch = src.get();
+        if (ch == std::char_traits<char>::eof())
+            throw std::runtime_error("Unexpected end of data.");
+
+        rslt |= static_cast<UInt64>(ch & 0x7F) << (7 * i);
+        if ((ch & 0x80) == 0)
+            return rslt;
     }
 
-    /// @note Copy the other's parent.
-    Tag& operator=(Tag&& other)
-    {
-        assert(!isContained(other));
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (isContained(other))
-            throw std::logic_error("Can't assign parent to self.");
-    #endif
+    throw std::runtime_error("The VarInt is too long.");
+}
 
-        assert(!(isListItem() && (type() != other.type())));
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (isListItem() && (type() != other.type()))
-            throw std::logic_error("Can't assign a tag of incorrect tag type to list element");
-    #endif
+template <typename Source>
+Int32 _readInt32(Source& src, Encoding enc)
+{
+    if (enc == EC_NETWORK)
+        return _zigzagDecode32(static_cast<UInt32>(_readVarInt(src, 5)));
+    return _readNum<Int32>(src, enc == EC_BIG_ENDIAN);
+}
 
-        if (this == &other)
-            return *this;
+template <typename Source>
+Int64 _readInt64(Source& src, Encoding enc)
+{
+    if (enc == EC_NETWORK)
+        return _zigzagDecode64(_readVarInt(src, 10));
+    return _readNum<Int64>(src, enc == EC_BIG_ENDIAN);
+}
 
-        release_();
+/// @brief Read the length of string or tag name.
+template <typename Source>
+size_t _readStringLength(Source& src, Encoding enc)
+{
+    if (enc == EC_NETWORK)
+        return static_cast<size_t>(static_cast<UInt32>(_readVarInt(src, 5)));
+    return _readNum<UInt16>(src, enc == EC_BIG_ENDIAN);
+}
 
-        tagType_    = other.tagType_;
-        itemType_   = other.itemType_;
-        tagData_    = other.tagData_;
-        tagName_    = other.tagName_;
+/// @brief Read the size of array or list, throw if it is negative.
+template <typename Source>
+size_t _readSize(Source& src, Encoding enc)
+{
+    Int32 size = _readInt32(src, enc);
+    if (size < 0)
+        throw std::runtime_error("Invalid negative size.");
 
-        if (isList() && tagData_.ld)
-        {
-            for (auto& var : *tagData_.ld)
-                var.parent_ = this;
-        }
-        else if (isCompound() && tagData_.cd)
-        {
-            for (auto& var : tagData_.cd->data)
-                var.parent_ = this;
-        }
+    return static_cast<size_t>(size);
+}
 
-        other.tagData_.str  = nullptr;
-        other.tagName_      = nullptr;
+/// @brief Read a string (or tag name) with its length prefix.
+template <typename Source>
+void _readString(Source& src, Encoding enc, String& str)
+{
+    size_t len = _readStringLength(src, enc);
+    str.resize(len);
+    if (len != 0)
+        _readBytes(src, &str[0], len);
+}
 
-        if (isListItem() && tagName_)
-        {
-            delete tagName_;
-            tagName_ = nullptr;
-        }
+/// @brief Read the array of fixed width numbers and append to the vector.
+// Read chunk by chunk so that a corrupted size can't allocate large memory without data.
+template <typename T, typename Source>
+void _readFixedArray(Source& src, size_t count, Vec<T>& dst, bool isBigEndian)
+{
+    constexpr size_t chunk = (1 << 20) / sizeof(T);
 
-        return *this;
+    while (count != 0)
+    {
+        size_t n = count < chunk ? count : chunk;
+        size_t pos = dst.size();
+        dst.resize(pos + n);
+
+        char* p = reinterpret_cast<char*>(dst.data() + pos);
+        _readBytes(src, p, n * sizeof(T));
+        if (sizeof(T) != 1 && isBigEndian != _isBigEndian())
+            _reverseEach(p, p, n, sizeof(T));
+
+        count -= n;
     }
+}
 
-    explicit Tag(TagType type) : tagType_(type) {}
+/// @brief Read the items of Int or Long array (or list) and append to the vector.
+template <typename T, typename Source>
+void _readIntegers(Source& src, size_t count, Vec<T>& dst, Encoding enc)
+{
+    if (enc != EC_NETWORK)
+    {
+        _readFixedArray(src, count, dst, enc == EC_BIG_ENDIAN);
+        return;
+    }
 
-    /// @brief Get the tag from binary input stream.
-    /// @param is               The input stream.
-    /// @param isBigEndian      Whether the read data from input stream with big endian.
-    /// @param headerSize       The size of need discard data from input stream begin.
-    // (usually is 0, but bedrock edition map file is 8, some useless dat)
-    static Tag fromBinStream(IFStream& is, bool isBigEndian, size_t headerSize = 0)
+    for (size_t i = 0; i < count; ++i)
     {
-    #ifdef MCNBT_ENABLE_GZIP
-        SStream buf;
-        buf << is.rdbuf();
-        String content = buf.str();
+        if (sizeof(T) == sizeof(Int64))
+            dst.emplace_back(static_cast<T>(_readInt64(src, enc)));
+        else
+            dst.emplace_back(static_cast<T>(_readInt32(src, enc)));
+    }
+}
 
-        SStream ss;
-        if (gzip::isCompressed(content))
-            content = gzip::decompress(content);
+/// @brief Read the numbers of packed list and append to the vector, only the Int and Long are VarInt in network
+/// encoding.
+template <typename T, typename Source>
+void _readNumbers(Source& src, size_t count, Vec<T>& dst, Encoding enc)
+{
+    if (std::is_integral<T>::value && sizeof(T) >= sizeof(Int32))
+        _readIntegers(src, count, dst, enc);
+    else
+        _readFixedArray(src, count, dst, enc == EC_BIG_ENDIAN);
+}
 
-        ss << content;
+template <typename Sink>
+void _writeInt32(Int32 num, Sink& os, Encoding enc)
+{
+    if (enc == EC_NETWORK)
+        _writeVarInt(_zigzagEncode32(num), os);
+    else
+        _num2bytes<Int32>(num, os, enc == EC_BIG_ENDIAN);
+}
 
-        if (headerSize != 0)
-            ss.seekg(headerSize, ss.cur);
+template <typename Sink>
+void _writeInt64(Int64 num, Sink& os, Encoding enc)
+{
+    if (enc == EC_NETWORK)
+        _writeVarInt(_zigzagEncode64(num), os);
+    else
+        _num2bytes<Int64>(num, os, enc == EC_BIG_ENDIAN);
+}
 
-        return fromBinStream_(ss, isBigEndian, false);
-    #else
-        if (headerSize != 0)
-            is.seekg(headerSize, is.cur);
+/// @brief Write the length of string or tag name.
+template <typename Sink>
+void _writeStringLength(size_t size, Sink& os, Encoding enc)
+{
+    if (enc == EC_NETWORK)
+        _writeVarInt(static_cast<UInt32>(size), os);
+    else
+        _num2bytes<UInt16>(static_cast<UInt16>(size), os, enc == EC_BIG_ENDIAN);
+}
 
-        return fromBinStream_(is, isBigEndian, false);
-    #endif // MCNBT_ENABLE_GZIP
-    }
+/// @brief Write the array of fixed width numbers, converting the byte order chunk by chunk if needed.
+template <typename T, typename Sink>
+void _writeFixedArray(const T* data, size_t count, Sink& os, bool isBigEndian)
+{
+    const char* bytes = reinterpret_cast<const char*>(data);
 
-    /// @brief Get the tag from a nbt file.
-    static Tag fromFile(const String& filename, bool isBigEndian, size_t headerSize = 0)
+    if (sizeof(T) == 1 || isBigEndian == _isBigEndian())
     {
-        IFStream ifs(filename, std::ios::binary);
-        if (!ifs.is_open())
-            throw std::runtime_error("Failed to open file: " + filename);
-
-        Tag rslt = fromBinStream(ifs, isBigEndian, headerSize);
+        os.write(bytes, count * sizeof(T));
+        return;
+    }
 
-        ifs.close();
+    char buffer[4096];
+    constexpr size_t chunk = sizeof(buffer) / sizeof(T);
+    for (size_t i = 0; i < count; i += chunk)
+    {
+        size_t n = count - i < chunk ? count - i : chunk;
+        _reverseEach(buffer, bytes + i * sizeof(T), n, sizeof(T));
+        os.write(buffer, n * sizeof(T));
+    }
+}
 
-        return rslt;
+/// @brief Write the items of Int or Long array (or list).
+template <typename T, typename Sink>
+void _writeIntegers(const T* data, size_t count, Sink& os, Encoding enc)
+{
+    if (enc == EC_NETWORK)
+    {
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (sizeof(T) == sizeof(Int64))
+                _writeInt64(static_cast<Int64>(data[i]), os, enc);
+            else
+                _writeInt32(static_cast<Int32>(data[i]), os, enc);
+        }
+        return;
     }
 
-    /// @todo
-    /// @brief Get the tag from a text input stream.
-    /// @note - The root tag must be a compound tag.
-    /// @note - The tag name (key of key-value) must valid, it can't contains {, }, [,] and so on key characters.
-    static Tag fromSnbt(IStream& is) { return Tag(); };
+    _writeFixedArray(data, count, os, enc == EC_BIG_ENDIAN);
+}
 
-    /// @brief Get the tag from a string.
-    /// @note - The root tag must be a compound tag.
-    /// @note - The tag name (key of key-value) must valid, it can't contains {, }, [,] and so on key characters.
-    static Tag fromSnbt(const String& snbt)
-    {
-        SStream ss;
-        ss << snbt;
-        return fromSnbt(ss);
-    }
+/// @brief Write the numbers of packed list, only the Int and Long are VarInt in network encoding.
+template <typename T, typename Sink>
+void _writeNumbers(const T* data, size_t count, Sink& os, Encoding enc)
+{
+    if (std::is_integral<T>::value && sizeof(T) >= sizeof(Int32))
+        _writeIntegers(data, count, os, enc);
+    else
+        _writeFixedArray(data, count, os, enc == EC_BIG_ENDIAN);
+}
 
-   /// @brief Functions of check tag type.
+// Functions of get the size of the fields of binary NBT with the specified encoding.
 
-    bool isEnd() const          { return nbt::isEnd(tagType_); }
+inline size_t _int32Size(Int32 num, Encoding enc)
+{ return enc == EC_NETWORK ? _varIntSize(_zigzagEncode32(num)) : sizeof(Int32); }
 
-    bool isByte() const         { return nbt::isByte(tagType_); }
+inline size_t _int64Size(Int64 num, Encoding enc)
+{ return enc == EC_NETWORK ? _varIntSize(_zigzagEncode64(num)) : sizeof(Int64); }
 
-    bool isShort() const        { return nbt::isShort(tagType_); }
+inline size_t _stringLengthSize(size_t size, Encoding enc)
+{ return enc == EC_NETWORK ? _varIntSize(static_cast<UInt32>(size)) : sizeof(UInt16); }
 
-    bool isInt() const          { return nbt::isInt(tagType_); }
+/// @brief Get the size of the numbers written by #_writeNumbers().
+template <typename T>
+size_t _numbersSize(const T* data, size_t count, Encoding enc)
+{
+    if (enc != EC_NETWORK || !std::is_integral<T>::value || sizeof(T) < sizeof(Int32))
+        return count * sizeof(T);
 
-    bool isLong() const         { return nbt::isLong(tagType_); }
+    size_t size = 0;
+    for (size_t i = 0; i < count; ++i)
+    {
+        if (sizeof(T) == sizeof(Int64))
+            size += _int64Size(static_cast<Int64>(data[i]), enc);
+        else
+            size += _int32Size(static_cast<Int32>(data[i]), enc);
+    }
+    return size;
+}
 
-    bool isFloat() const        { return nbt::isFloat(tagType_); }
+// Functions of hash. (Fast and well mixed, but not cryptographic)
+// The hash of same bytes is same on all platforms, but the hash of numbers in memory depends on the endianness.
 
-    bool isDouble() const       { return nbt::isDouble(tagType_); }
+/// @brief The finalizer of MurmurHash3, each bit of the result depends on each bit of the input.
+inline UInt64 _hashFinalize(UInt64 hash)
+{
+    hash ^= hash >> 33;
+    hash *= 0xFF51AFD7ED558CCDull;
+    hash ^= hash >> 33;
+    hash *= 0xC4CEB9FE1A85EC53ull;
+    hash ^= hash >> 33;
+    return hash;
+}
 
-    bool isString() const       { return nbt::isString(tagType_); }
+/// @brief Combine the value to the hash, the result depends on the order of values.
+inline UInt64 _hashMix(UInt64 hash, UInt64 value)
+{ return _hashFinalize(hash ^ (value + 0x9E3779B97F4A7C15ull + (hash << 6) + (hash >> 2))); }
 
-    bool isByteArray() const    { return nbt::isByteArray(tagType_); }
+/// @brief Hash the bytes, 8 bytes (as little endian word) per round.
+inline UInt64 _hashBytes(const void* data, size_t size, UInt64 seed = 0)
+{
+    constexpr UInt64 k1 = 0x87C37B91114253D5ull;
+    constexpr UInt64 k2 = 0x4CF5AD432745937Full;
 
-    bool isIntArray() const     { return nbt::isIntArray(tagType_); }
+    const char* p = static_cast<const char*>(data);
+    UInt64 hash = seed ^ (static_cast<UInt64>(size) * k1);
 
-    bool isLongArray() const    { return nbt::isLongArray(tagType_); }
+    for (; size >= 8; p += 8, size -= 8)
+    {
+        UInt64 word = _loadNum<UInt64>(p, false);
+        hash ^= word * k1;
+        hash = ((hash << 31) | (hash >> 33)) * k2;
+    }
 
-    bool isList() const         { return nbt::isList(tagType_); }
+    if (size != 0)
+    {
+        char tail[8] = {};
+        std::memcpy(tail, p, size);
+        UInt64 word = _loadNum<UInt64>(tail, false);
+        hash ^= word * k1;
+        hash = ((hash << 31) | (hash >> 33)) * k2;
+    }
 
-    bool isCompound() const     { return nbt::isCompound(tagType_); }
+    return _hashFinalize(hash);
+}
 
-    bool isInteger() const      { return nbt::isInteger(tagType_); }
+// Sinks and sources of binary data.
+// The codec is instantiated on them, so the inner loop of read and write inlines to plain pointer bumps.
 
-    bool isFloatPoint() const   { return nbt::isFloatPoint(tagType_); }
+/// @brief Write the data to the file descriptor, retry until all data is written.
+inline void _writeFd(int fd, const char* data, size_t size)
+{
+    while (size != 0)
+    {
+        // Limit the size of single write for the platforms use the int as size.
+        size_t n = size < (1u << 30) ? size : (1u << 30);
+    #ifdef _WIN32
+        int rslt = ::_write(fd, data, static_cast<unsigned int>(n));
+    #else
+        ssize_t rslt = ::write(fd, data, n);
+    #endif
+        if (rslt < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error("Failed to write file: " + String(std::strerror(errno)));
+        }
 
-    bool isNum() const          { return nbt::isNum(tagType_); }
+        data += rslt;
+        size -= static_cast<size_t>(rslt);
+    }
+}
 
-    bool isArray() const        { return nbt::isArray(tagType_); }
+/// @brief Write all the data to the file descriptor at the offset, retry until all is written.
+/// @note The offset of the file descriptor is not changed, except on Windows.
+inline void _writeFdAt(int fd, const char* data, size_t size, Int64 offset)
+{
+#ifdef _WIN32
+    if (::_lseeki64(fd, offset, SEEK_SET) != offset)
+        throw std::runtime_error("Failed to seek file: " + String(std::strerror(errno)));
+    _writeFd(fd, data, size);
+#else
+    while (size != 0)
+    {
+        size_t n = size < (1u << 30) ? size : (1u << 30);
+        ssize_t rslt = ::pwrite(fd, data, n, static_cast<off_t>(offset));
+        if (rslt < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error("Failed to write file: " + String(std::strerror(errno)));
+        }
 
-    bool isContainer() const    { return nbt::isContainer(tagType_); }
+        data += rslt;
+        size -= static_cast<size_t>(rslt);
+        offset += rslt;
+    }
+#endif // _WIN32
+}
 
-    /// Functions of common to all tag.
+/// @brief Read the data from the file descriptor, retry until the size is read or end of file.
+/// @return The count of read bytes.
+inline size_t _readFd(int fd, char* dst, size_t size)
+{
+    size_t total = 0;
+    while (total < size)
+    {
+        size_t n = size - total < (1u << 30) ? size - total : (1u << 30);
+    #ifdef _WIN32
+        int rslt = ::_read(fd, dst + total, static_cast<unsigned int>(n));
+    #else
+        ssize_t rslt = ::read(fd, dst + total, n);
+    #endif
+        if (rslt < 0)
+        {
+            if (errno == EINTR)
+                continue;
+            throw std::runtime_error("Failed to read file: " + String(std::strerror(errno)));
+        }
+        if (rslt == 0)
+            break;
 
-    /// @brief Make a copy.
-    // Usually used for add tag to list or compound. (because default is move when add tag to list or compound)
-    Tag copy() const            { return Tag(*this); }
+        total += static_cast<size_t>(rslt);
+    }
 
-    /// @brief Assign a tag to self, be equal to *this = tag;
-    Tag& assign(const Tag& tag) { *this = tag; return *this; }
+    return total;
+}
 
-    /// @brief Get the tag type.
-    TagType type() const        { return tagType_; }
+/// @brief The sink of contiguous memory of known enough size.
+/// @note It doesn't check the capacity, the caller must ensure the memory is enough (e.g. by Tag::binarySize()).
+class BufferSink
+{
+public:
+    explicit BufferSink(char* data) : beg_(data), cur_(data) {}
 
-    /// @brief Get the name of tag.
-    String name() const         { return tagName_ ? *tagName_ : ""; }
+    /// @brief Get the count of bytes already written.
+    size_t pos() const                          { return static_cast<size_t>(cur_ - beg_); }
 
-    /// @brief Get the name length of tag.
-    Int16 nameLength() const    { return static_cast<Int16>(name().size()); }
+    void put(char ch)                           { *cur_++ = ch; }
 
-    /// @brief Set the name of tag.
-    /// @note If the new name already exist in parent, cover it.
-    /// @attention Only be called via non-ListItem.
-    Tag& setName(const String& name)
+    void write(const char* data, size_t size)
     {
-        assert(!isListItem());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (isListItem())
-            throw std::logic_error("Can't set name for list element.");
-    #endif
+        std::memcpy(cur_, data, size);
+        cur_ += size;
+    }
 
-        // If the new name is empty and the old name is empty (maybe not exists), do nothing.
-        if (name.empty() && this->name().empty())
-            return *this;
+    void flush() {}
 
-        // If the new name is equal to the old name, do nothing.
-        String oldname = this->name();
-        if (name == oldname)
-            return *this;
+private:
+    char* beg_;
+    char* cur_;
+};
 
-        // Why need some step above? see below.
+/// @brief The sink of growable vector, the data is appended to the vector.
+/// @note The vector has redundant capacity (as its size) while writing, call #flush() to trim it.
+class VecSink
+{
+public:
+    explicit VecSink(Vec<Byte>& dst) : dst_(dst), pos_(dst.size()) {}
 
-        if (!parent_)
-        {
-            if (tagName_)
-                *tagName_ = name;
-            else
-                tagName_ = new String(name);
+    ~VecSink()                                  { flush(); }
 
-            return *this;
-        }
-        else
-        {
-            Tag* p = parent_;
-            if (p->hasTag(name))
-                p->remove(name);
+    /// @brief Get the count of bytes in the vector.
+    size_t pos() const                          { return pos_; }
 
-            Tag& t = (*p)[oldname];
+    void put(char ch)
+    {
+        if (pos_ == dst_.size())
+            grow_(1);
+        dst_[pos_++] = ch;
+    }
 
-            if (t.tagName_)
-                *t.tagName_ = name;
-            else
-                t.tagName_ = new String(name);
+    void write(const char* data, size_t size)
+    {
+        if (size > dst_.size() - pos_)
+            grow_(size);
+        std::memcpy(dst_.data() + pos_, data, size);
+        pos_ += size;
+    }
 
-            size_t idx = p->tagData_.cd->idxs[oldname];
+    /// @brief Trim the vector to the written data.
+    void flush()                                { dst_.resize(pos_); }
 
-            p->tagData_.cd->idxs.erase(oldname);
-            p->tagData_.cd->idxs.insert({ name, idx });
+private:
+    void grow_(size_t need)
+    {
+        size_t size = dst_.size() * 2;
+        if (size < pos_ + need)
+            size = pos_ + need;
+        if (size < 4096)
+            size = 4096;
 
-            return t;
-        }
+        dst_.resize(size);
     }
 
-    /// @brief Check if is a list element.
-    bool isListItem() const     { return parent_ && parent_->isList(); }
+    Vec<Byte>& dst_;
+    size_t pos_;
+};
 
-    /// @brief Check if the parent is exists.
-    bool hasParent() const      { return parent_ != nullptr; }
+/// @brief The adapter of std::ostream, the data is written to the stream chunk by chunk.
+class StreamSink
+{
+public:
+    explicit StreamSink(OStream& os) : os_(os), cur_(buffer_) {}
 
-    /// @return The parent pointer.
-    const Tag* parent() const   { return parent_; }
+    ~StreamSink()                               { flush(); }
 
-    /// @brief Check if is be contained in specified tag.
-    /// @param container The tag that be checked whether self is contained in it.
-    /// @note Recursive check all the parent (parent's parent) until a parent is nullptr.
-    bool isContained(const Tag& container) const
+    /// @brief Get the count of bytes already written.
+    size_t pos() const                          { return flushed_ + static_cast<size_t>(cur_ - buffer_); }
+
+    void put(char ch)
     {
-        const Tag* p = parent_;
+        if (cur_ == buffer_ + sizeof(buffer_))
+            flush();
+        *cur_++ = ch;
+    }
 
-        while (p)
+    void write(const char* data, size_t size)
+    {
+        if (size > static_cast<size_t>(buffer_ + sizeof(buffer_) - cur_))
         {
-            if (p == &container)
-                return true;
-            p = p->parent_;
+            flush();
+
+            // Write the large data directly.
+            if (size >= sizeof(buffer_))
+            {
+                os_.write(data, size);
+                flushed_ += size;
+                return;
+            }
         }
 
-        return false;
+        std::memcpy(cur_, data, size);
+        cur_ += size;
     }
 
-    /// @brief Functions about the list tag.
+    void flush()
+    {
+        if (cur_ != buffer_)
+            os_.write(buffer_, cur_ - buffer_);
+        flushed_ += static_cast<size_t>(cur_ - buffer_);
+        cur_ = buffer_;
+    }
 
-    /// @brief Get the list item type.
-    /// @attention Only be called via #TT_LIST.
-    TagType listItemType() const
+private:
+    OStream& os_;
+    char buffer_[1 << 14];
+    char* cur_;
+    size_t flushed_ = 0;
+};
+
+/// @brief The sink of file descriptor with a large user-space buffer.
+/// @note The file descriptor is not closed by the sink. Call #flush() before close the file.
+class FileSink
+{
+public:
+    /// @param isDirect Whether the file descriptor is opened with O_DIRECT.
+    // If true, the buffer is aligned and only be written by whole blocks, the tail is written after O_DIRECT
+    // is turned off in #flush().
+    explicit FileSink(int fd, size_t bufferSize = 1 << 20, bool isDirect = false) :
+        fd_(fd), isDirect_(isDirect)
     {
-        assert(isList());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isList())
-            throw std::logic_error("Can't get the list item type for non-list tag.");
-    #endif
+        if (bufferSize < _BLOCK_SIZE)
+            bufferSize = _BLOCK_SIZE;
+        bufferSize = (bufferSize + _BLOCK_SIZE - 1) / _BLOCK_SIZE * _BLOCK_SIZE;
+
+        storage_.resize(bufferSize + (isDirect ? _BLOCK_SIZE : 0));
+        buffer_ = storage_.data();
+        if (isDirect)
+            buffer_ += (_BLOCK_SIZE - reinterpret_cast<uintptr_t>(buffer_) % _BLOCK_SIZE) % _BLOCK_SIZE;
+        size_ = bufferSize;
+    }
 
-        return itemType_;
+    ~FileSink()
+    {
+        try { flush(); }
+        catch (...) {}
     }
 
-    /// @brief Check if the list item type is be seted.
-    /// @attention Only be called via #TT_LIST.
-    bool hasSetListItemType() const
+    FileSink(const FileSink&) = delete;
+    FileSink& operator=(const FileSink&) = delete;
+
+    /// @brief Get the count of bytes already written.
+    size_t pos() const                          { return flushed_ + cur_; }
+
+    void put(char ch)
     {
-        return listItemType() != TT_END;
+        if (cur_ == size_)
+            flushBlocks_();
+        buffer_[cur_++] = ch;
     }
 
-    /// @brief Set the tag type of list item.
-    /// @note If the list item type already be seted, cover the original list item type and remove all original items.
-    /// @attention Only be called via #TT_LIST.
-    Tag& setListItemType(TagType type)
+    void write(const char* data, size_t size)
     {
-        assert(isList());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isList())
-            throw std::logic_error("Can't set the list item type for non-list tag.");
-    #endif
+        // Write the large data directly.
+        if (!isDirect_ && size >= size_)
+        {
+            flushBlocks_();
+            _writeFd(fd_, data, size);
+            flushed_ += size;
+            return;
+        }
 
-        if (itemType_ != TT_END)
+        while (size != 0)
         {
-            if (tagData_.ld)
-            {
-                delete tagData_.ld;
-                tagData_.ld = nullptr;
-            }
+            if (cur_ == size_)
+                flushBlocks_();
+
+            size_t n = size_ - cur_ < size ? size_ - cur_ : size;
+            std::memcpy(buffer_ + cur_, data, n);
+            cur_ += n;
+            data += n;
+            size -= n;
         }
+    }
 
-        itemType_ = type;
+    /// @brief Write all buffered data to the file.
+    void flush()
+    {
+        if (isDirect_ && cur_ % _BLOCK_SIZE != 0)
+        {
+            flushBlocks_();
+            setDirect_(false);
+        }
 
-        return *this;
+        flushBlocks_();
     }
 
-    /// @attention Only be called via #TT_LIST.
-    Tag& assign(size_t size, const Tag& tag)
+private:
+    static constexpr size_t _BLOCK_SIZE = 4096;
+
+    /// @brief Write the buffered data, only the whole blocks if in direct mode.
+    void flushBlocks_()
     {
-        assert(isList());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isList())
-            throw std::logic_error("Can't assign multiple tags to non-list tag.");
+        size_t size = isDirect_ ? cur_ / _BLOCK_SIZE * _BLOCK_SIZE : cur_;
+        _writeFd(fd_, buffer_, size);
+        flushed_ += size;
 
-        if (itemType_ == TT_END)
-            throw std::logic_error("Can't read or write a uninitialized list.");
+        cur_ -= size;
+        if (cur_ != 0)
+            std::memmove(buffer_, buffer_ + size, cur_);
+    }
 
-        if (tag.type() != itemType_)
-        {
-            String errmsg = "Can't assign the tag of " + getTagTypeString(tag.type());
-            errmsg += " to the list of " + getTagTypeString(itemType_);
-            throw std::logic_error(errmsg);
-        }
+    void setDirect_(bool isDirect)
+    {
+    #if defined(O_DIRECT) && !defined(_WIN32)
+        int flags = ::fcntl(fd_, F_GETFL);
+        if (flags != -1)
+            ::fcntl(fd_, F_SETFL, isDirect ? (flags | O_DIRECT) : (flags & ~O_DIRECT));
     #endif
+        isDirect_ = isDirect;
+    }
 
-        if (size == 0 && !tagData_.ld)
-            return *this;
+    int fd_;
+    bool isDirect_;
+    Vec<Byte> storage_;
+    char* buffer_;
+    size_t size_;
+    size_t cur_ = 0;
+    size_t flushed_ = 0;
+};
 
-        if (!tagData_.ld)
-            tagData_.ld = new Vec<Tag>();
+/// @brief The source of contiguous memory.
+/// Also be used as the bounds checked cursor by the functions which walk the binary layout without building tags.
+class BufferSource
+{
+public:
+    BufferSource(const char* data, size_t size) : beg_(data), cur_(data), end_(data + size) {}
 
-        tagData_.ld->assign(size, tag);
+    /// @brief Get the count of bytes already read.
+    size_t pos() const          { return static_cast<size_t>(cur_ - beg_); }
 
-        return *this;
-    }
+    /// @brief Get the count of bytes not read yet.
+    size_t remain() const       { return static_cast<size_t>(end_ - cur_); }
 
-    /// @brief Functions about the compound tag.
+    bool eof() const            { return cur_ == end_; }
 
-    /// @brief Check if the compound contains member of specified name.
-    /// @attention Only be called via #TT_COMPOUND.
-    bool hasTag(const String& name) const
+    /// @brief Get the pointer to the current position.
+    const char* data() const    { return cur_; }
+
+    int get()                   { return cur_ == end_ ? std::char_traits<char>::eof() : static_cast<UChar>(*cur_++); }
+
+    int peek() const            { return cur_ == end_ ? std::char_traits<char>::eof() : static_cast<UChar>(*cur_); }
+
+    size_t read(char* dst, size_t size)
     {
-        assert(isCompound());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isCompound())
-            throw std::logic_error("Can't check tag existence for non-compound tag.");
-    #endif
+        if (size > remain())
+            size = remain();
 
-        if (!tagData_.cd)
-            return false;
+        std::memcpy(dst, cur_, size);
+        cur_ += size;
 
-        return tagData_.cd->idxs.find(name) != tagData_.cd->idxs.end();
+        return size;
     }
 
-    /// @brief Functions about the tag of containers.
-
-    /// @brief Get the length of string or size of array or tag counts of list and compound.
-    /// @attention Only be called via
-    // #TT_STRING, #TT_BYTE_ARRAY, #TT_INT_ARRAY, #TT_LONG_ARRAY, #TT_LIST, #TT_COMPOUND.
-    size_t size() const
+    /// @brief Get the pointer to the next specified count of bytes and move the cursor over them.
+    const char* take(size_t size)
     {
-        assert(isString() || isArray() || isContainer());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isString() && !isArray() && !isContainer())
-            throw std::logic_error("Can't get size for non-string, non-array, non-container tag.");
-    #endif
+        if (size > remain())
+            throw std::runtime_error("Unexpected end of data.");
 
-        if (isString())     return !tagData_.str ? 0 : tagData_.str->size();
-        if (isByteArray())  return !tagData_.bad ? 0 : tagData_.bad->size();
-        if (isIntArray())   return !tagData_.iad ? 0 : tagData_.iad->size();
-        if (isLongArray())  return !tagData_.lad ? 0 : tagData_.lad->size();
-        if (isList())       return !tagData_.ld ? 0 : tagData_.ld->size();
-        if (isCompound())   return !tagData_.cd ? 0 : tagData_.cd->size();
-
-        return 0;
+        const char* p = cur_;
+        cur_ += size;
+        return p;
     }
 
-    /// @brief Check if the string or array or list or compound is empty.
-    /// @attention Only be called via
-    // #TT_STRING, #TT_BYTE_ARRAY, #TT_INT_ARRAY, #TT_LONG_ARRAY, #TT_LIST, #TT_COMPOUND.
-    bool isEmpty() const { return size() == 0; }
+    void skip(size_t size)      { take(size); }
 
-    /// @brief Reserve the space of string or array or list or compound.
-    /// @attention Only be called via
-    // #TT_STRING, #TT_BYTE_ARRAY, #TT_INT_ARRAY, #TT_LONG_ARRAY, #TT_LIST, #TT_COMPOUND.
-    void reserve(size_t size)
+    /// @brief Read a fixed width number.
+    template <typename T>
+    T readNum(bool isBigEndian) { return _loadNum<T>(take(sizeof(T)), isBigEndian); }
+
+    /// @brief Read a VarInt.
+    /// @param maxSize The max count of bytes of the VarInt. (5 for 32-bit number, 10 for 64-bit number)
+    UInt64 readVarInt(size_t maxSize = 10)
     {
-        assert(isString() || isArray() || isContainer());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isString() && !isArray() && !isContainer())
-            throw std::logic_error("Can't reserve space for non-string, non-array, non-container tag.");
-    #endif
+        UInt64 num = 0;
+        size_t size = _decodeVarInt(cur_, end_, num, maxSize);
+        if (size == 0)
+            throw std::runtime_error(remain() < maxSize ? "Unexpected end of data." : "The VarInt is too long.");
 
-        if (isString())
-        {
-            if (!tagData_.str)
-                tagData_.str = new String();
-            tagData_.str->reserve(size);
-        }
-        else if (isByteArray())
-        {
-            if (!tagData_.bad)
-                tagData_.bad = new Vec<Byte>();
-            tagData_.bad->reserve(size);
-        }
-        else if (isIntArray())
-        {
-            if (!tagData_.iad)
-                tagData_.iad = new Vec<Int32>();
-            tagData_.iad->reserve(size);
-        }
-        else if (isLongArray())
-        {
-            if (!tagData_.lad)
-                tagData_.lad = new Vec<Int64>();
-            tagData_.lad->reserve(size);
-        }
-        else if (isList())
-        {
-            if (!tagData_.ld)
-                tagData_.ld = new Vec<Tag>();
-            tagData_.ld->reserve(size);
-        }
-        else if (isCompound())
-        {
-            if (!tagData_.cd)
-                tagData_.cd = new CompoundData();
-            tagData_.cd->reserve(size);
-        }
+        cur_ += size;
+        return num;
     }
 
-    /// @brief Functions for set value. Only be called via corresponding tag.
-
-    /// @attention Only be called via #TT_BYTE.
-    Tag& setByte(Byte value)
+    Int32 readInt32(Encoding enc)
     {
-        assert(isByte());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isByte())
-            throw std::logic_error("Can't set byte value for non-byte tag.");
-    #endif
-
-        tagData_.num.i8 = value;
+        if (enc == EC_NETWORK)
+            return _zigzagDecode32(static_cast<UInt32>(readVarInt(5)));
+        return readNum<Int32>(enc == EC_BIG_ENDIAN);
+    }
 
-        return *this;
+    Int64 readInt64(Encoding enc)
+    {
+        if (enc == EC_NETWORK)
+            return _zigzagDecode64(readVarInt(10));
+        return readNum<Int64>(enc == EC_BIG_ENDIAN);
     }
 
-    /// @attention Only be called via #TT_SHORT.
-    Tag& setShort(Int16 value)
+    /// @brief Read the length of string or tag name.
+    size_t readStringLength(Encoding enc)
     {
-        assert(isShort());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isShort())
-            throw std::logic_error("Can't set short value for non-short tag.");
-    #endif
+        if (enc == EC_NETWORK)
+            return static_cast<size_t>(static_cast<UInt32>(readVarInt(5)));
+        return readNum<UInt16>(enc == EC_BIG_ENDIAN);
+    }
 
-        tagData_.num.i16 = value;
+    /// @brief Read the size of array or list. Throw if the size is negative.
+    size_t readSize(Encoding enc)
+    {
+        Int32 size = readInt32(enc);
+        if (size < 0)
+            throw std::runtime_error("Invalid negative size.");
 
-        return *this;
+        return static_cast<size_t>(size);
     }
 
-    /// @attention Only be called via #TT_INT.
-    Tag& setInt(Int32 value)
-    {
-        assert(isInt());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isInt())
-            throw std::logic_error("Can't set int value for non-int tag.");
-    #endif
+private:
+    const char* beg_;
+    const char* cur_;
+    const char* end_;
+};
 
-        tagData_.num.i32 = value;
+/// @brief Decode the VarInt from contiguous memory at once instead of byte by byte.
+inline UInt64 _readVarInt(BufferSource& src, size_t maxSize = 10)
+{ return src.readVarInt(maxSize); }
 
-        return *this;
+/// @brief Get the encoded size of the number of type, 0 if it is not fixed width.
+// (The Int and Long are VarInt in network encoding)
+inline size_t _fixedWidth(TagType type, Encoding enc)
+{
+    switch (type)
+    {
+        case TT_BYTE:   return 1;
+        case TT_SHORT:  return 2;
+        case TT_FLOAT:  return 4;
+        case TT_DOUBLE: return 8;
+        case TT_INT:    return enc == EC_NETWORK ? 0 : 4;
+        case TT_LONG:   return enc == EC_NETWORK ? 0 : 8;
+        default:        return 0;
     }
+}
 
-    /// @attention Only be called via #TT_LONG.
-    Tag& setLong(Int64 value)
+/// @brief Move the cursor over the specified count of encoded numbers.
+inline void _skipNumbers(BufferSource& src, TagType type, size_t count, Encoding enc)
+{
+    size_t width = _fixedWidth(type, enc);
+    if (width == 0)
     {
-        assert(isLong());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isLong())
-            throw std::logic_error("Can't set long value for non-long tag.");
-    #endif
-
-        tagData_.num.i64 = value;
-
-        return *this;
+        for (size_t i = 0; i < count; ++i)
+            src.readVarInt(type == TT_INT ? 5 : 10);
+        return;
     }
 
-    /// @attention Only be called via #TT_FLOAT.
-    Tag& setFloat(Fp32 value)
+    if (count > src.remain() / width)
+        throw std::runtime_error("Unexpected end of data.");
+    src.skip(count * width);
+}
+
+/// @brief Move the cursor over the encoded value (without type and name) of the type.
+inline void _skipValue(BufferSource& src, TagType type, Encoding enc, size_t depth = 0)
+{
+    switch (type)
     {
-        assert(isFloat());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isFloat())
-            throw std::logic_error("Can't set float value for non-float tag.");
-    #endif
+        case TT_BYTE:
+        case TT_SHORT:
+        case TT_INT:
+        case TT_LONG:
+        case TT_FLOAT:
+        case TT_DOUBLE:         _skipNumbers(src, type, 1, enc);                            break;
+        case TT_STRING:         src.skip(src.readStringLength(enc));                        break;
+        case TT_BYTE_ARRAY:     src.skip(src.readSize(enc));                                break;
+        case TT_INT_ARRAY:      _skipNumbers(src, TT_INT, src.readSize(enc), enc);          break;
+        case TT_LONG_ARRAY:     _skipNumbers(src, TT_LONG, src.readSize(enc), enc);         break;
+        case TT_LIST:
+        {
+            if (depth >= _MAX_NESTING_DEPTH)
+                throw std::runtime_error("The nesting depth of tag is too deep.");
 
-        tagData_.num.f32 = value;
+            TagType itemType = static_cast<TagType>(src.get());
+            size_t size = src.readSize(enc);
 
-        return *this;
-    }
+            if (isNum(itemType))
+                _skipNumbers(src, itemType, size, enc);
+            else
+                for (size_t i = 0; i < size; ++i)
+                    _skipValue(src, itemType, enc, depth + 1);
 
-    /// @attention Only be called via #TT_DOUBLE.
-    Tag& setDouble(Fp64 value)
-    {
-        assert(isDouble());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isDouble())
-            throw std::logic_error("Can't set double value for non-double tag.");
-    #endif
+            break;
+        }
+        case TT_COMPOUND:
+        {
+            if (depth >= _MAX_NESTING_DEPTH)
+                throw std::runtime_error("The nesting depth of tag is too deep.");
 
-        tagData_.num.f64 = value;
+            while (true)
+            {
+                int memberType = src.get();
+                if (memberType == std::char_traits<char>::eof())
+                    throw std::runtime_error("Unexpected end of data.");
 
-        return *this;
+                if (memberType == TT_END)
+                    break;
+
+                src.skip(src.readStringLength(enc));
+                _skipValue(src, static_cast<TagType>(memberType), enc, depth + 1);
+            }
+
+            break;
+        }
+        default:
+            throw std::runtime_error("Invalid tag type.");
     }
+}
 
-    /// @brief Fast way of set the integer value.
-    /// @attention Only be called via #TT_BYTE, #TT_SHORT, #TT_INT, #TT_LONG.
-    Tag& setInteger(Int64 value)
-    {
-        assert(isInteger());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isInteger())
-            throw std::logic_error("Can't set interger number for non-integer tag.");
-    #endif
+/// @brief The base of the sources which read the data chunk by chunk to a buffer.
+/// @tparam Derived Must have the member function `size_t fill_(char* dst, size_t size)` which returns 0 at end.
+template <typename Derived>
+class _ChunkSource
+{
+public:
+    explicit _ChunkSource(size_t bufferSize) : buffer_(bufferSize > 0 ? bufferSize : 1) {}
 
-        if (isByte())           setByte(static_cast<Byte>(value));
-        else if (isShort())     setShort(static_cast<Int16>(value));
-        else if (isInt())       setInt(static_cast<Int32>(value));
-        else if (isLong())      setLong(value);
+    /// @brief Get the count of bytes already read.
+    size_t pos() const          { return base_ + cur_; }
 
-        return *this;
+    int get()
+    {
+        if (cur_ == end_ && !refill_())
+            return std::char_traits<char>::eof();
+        return static_cast<UChar>(buffer_[cur_++]);
     }
 
-    /// @brief Fast way of set the float point value.
-    /// @attention Only be called via #TT_FLOAT, #TT_DOUBLE.
-    Tag& setFloatPoint(Fp64 value)
+    int peek()
     {
-        assert(isFloatPoint());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isFloatPoint())
-            throw std::logic_error("Can't set float point number value for non-float point tag.");
-    #endif
-
-        if (isFloat())
-            setFloat(static_cast<Fp32>(value));
-        else if (isDouble())
-            setDouble(value);
-
-        return *this;
+        if (cur_ == end_ && !refill_())
+            return std::char_traits<char>::eof();
+        return static_cast<UChar>(buffer_[cur_]);
     }
 
-    /// @attention Only be called via #TT_STRING.
-    Tag& setString(const String& value)
+    size_t read(char* dst, size_t size)
     {
-        assert(isString());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isString())
-            throw std::logic_error("Can't set string value for non-string tag.");
-    #endif
+        size_t total = 0;
+        while (total < size)
+        {
+            if (cur_ == end_)
+            {
+                // Read the large data directly.
+                if (size - total >= buffer_.size())
+                {
+                    size_t n = static_cast<Derived*>(this)->fill_(dst + total, size - total);
+                    if (n == 0)
+                        break;
+                    total += n;
+                    base_ += n;
+                    continue;
+                }
 
-        if (value.empty() && !tagData_.str)
-            return *this;
+                if (!refill_())
+                    break;
+            }
 
-        if (tagData_.str)
-            *tagData_.str = value;
-        else
-            tagData_.str = new String(value);
+            size_t n = end_ - cur_ < size - total ? end_ - cur_ : size - total;
+            std::memcpy(dst + total, buffer_.data() + cur_, n);
+            cur_ += n;
+            total += n;
+        }
 
-        return *this;
+        return total;
     }
 
-    /// @attention Only be called via #TT_BYTE_ARRAY.
-    Tag& setByteArray(const Vec<Byte>& value)
+    void skip(size_t size)
     {
-        assert(isByteArray());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isByteArray())
-            throw std::logic_error("Can't set Byte array value for non-Byte array tag.");
-    #endif
-
-        if (value.empty() && !tagData_.bad)
-            return *this;
-
-        if (tagData_.bad)
-            *tagData_.bad = value;
-        else
-            tagData_.bad = new Vec<Byte>(value);
+        while (size != 0)
+        {
+            if (cur_ == end_ && !refill_())
+                throw std::runtime_error("Unexpected end of data.");
 
-        return *this;
+            size_t n = end_ - cur_ < size ? end_ - cur_ : size;
+            cur_ += n;
+            size -= n;
+        }
     }
 
-    /// @attention Only be called via #TT_INT_ARRAY.
-    Tag& setIntArray(const Vec<Int32>& value)
+    /// @brief Make at least the specified count of bytes are buffered if possible, used for look ahead.
+    /// @return The count of buffered bytes, can be less than the size at end.
+    size_t prefetch(size_t size)
     {
-        assert(isIntArray());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isIntArray())
-            throw std::logic_error("Can't set int array value for non-int array tag.");
-    #endif
+        if (end_ - cur_ >= size)
+            return end_ - cur_;
 
-        if (value.empty() && !tagData_.iad)
-            return *this;
+        size = size < buffer_.size() ? size : buffer_.size();
+        std::memmove(buffer_.data(), buffer_.data() + cur_, end_ - cur_);
+        base_ += cur_;
+        end_ -= cur_;
+        cur_ = 0;
 
-        if (tagData_.iad)
-            *tagData_.iad = value;
-        else
-            tagData_.iad = new Vec<Int32>(value);
+        while (end_ < size)
+        {
+            size_t n = static_cast<Derived*>(this)->fill_(buffer_.data() + end_, buffer_.size() - end_);
+            if (n == 0)
+                break;
+            end_ += n;
+        }
 
-        return *this;
+        return end_;
     }
 
-    /// @attention Only be called via #TT_LONG_ARRAY.
-    Tag& setLongArray(const Vec<Int64>& value)
+    /// @brief Get the pointer to the buffered bytes. (See #prefetch())
+    const char* data() const { return buffer_.data() + cur_; }
+
+private:
+    bool refill_()
     {
-        assert(isLongArray());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isLongArray())
-            throw std::logic_error("Can't set long array value for non-long array tag.");
-    #endif
+        base_ += end_;
+        cur_ = 0;
+        end_ = static_cast<Derived*>(this)->fill_(buffer_.data(), buffer_.size());
+        return end_ != 0;
+    }
 
-        if (value.empty() && !tagData_.lad)
-            return *this;
+    Vec<Byte> buffer_;
+    size_t cur_ = 0;
+    size_t end_ = 0;
+    size_t base_ = 0;   ///< The count of bytes read before the buffer.
+};
 
-        if (tagData_.lad)
-            *tagData_.lad = value;
-        else
-            tagData_.lad = new Vec<Int64>(value);
+/// @brief The adapter of std::istream, the data is read from the stream chunk by chunk.
+class StreamSource : public _ChunkSource<StreamSource>
+{
+public:
+    explicit StreamSource(IStream& is, size_t bufferSize = 1 << 16) : _ChunkSource(bufferSize), is_(is) {}
 
-        return *this;
+    size_t fill_(char* dst, size_t size)
+    {
+        is_.read(dst, static_cast<std::streamsize>(size));
+        return static_cast<size_t>(is_.gcount());
     }
 
-    /// @attention Only be called via #TT_BYTE_ARRAY.
-    Tag& setArray(const Vec<Byte>& value) { return setByteArray(value); }
+private:
+    IStream& is_;
+};
 
-    /// @overload
-    /// @attention Only be called via #TT_INT_ARRAY.
-    Tag& setArray(const Vec<Int32>& value) { return setIntArray(value); }
+/// @brief The source of file descriptor with a large user-space buffer.
+/// @note The file descriptor is not closed by the source.
+class FileSource : public _ChunkSource<FileSource>
+{
+public:
+    explicit FileSource(int fd, size_t bufferSize = 1 << 20) : _ChunkSource(bufferSize), fd_(fd) {}
 
-    /// @overload
-    /// @attention Only be called via #TT_LONG_ARRAY.
-    Tag& setArray(const Vec<Int64>& value) { return setLongArray(value); }
+    size_t fill_(char* dst, size_t size) { return _readFd(fd_, dst, size); }
 
-    /// @brief Add a value to the byte array.
-    /// @attention Only be called via #TT_BYTE_ARRAY.
-    Tag& addByte(Byte value)
-    {
-        assert(isByteArray());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isByteArray())
-            throw std::logic_error("Can't add byte value to non-byte array tag.");
-    #endif
+private:
+    int fd_;
+};
 
-        if (!tagData_.bad)
-            tagData_.bad = new Vec<Byte>();
-        tagData_.bad->emplace_back(value);
+/// @brief The options of write the tag to file.
+struct FileWriteOptions
+{
+    /// @brief The size of the user-space buffer.
+    size_t bufferSize = 1 << 20;
+    /// @brief Whether bypass the page cache (O_DIRECT on Linux, F_NOCACHE on macOS, ignored on others).
+    bool isDirect = false;
+    /// @brief Whether flush the data to the storage device (fdatasync) before return.
+    bool isSync = false;
+    /// @brief Whether write to a temporary file then rename it to the target, so that the target file is either
+    /// the old one or the complete new one.
+    /// @note The temporary file is created in the same directory with a unique name, and has the permissions of
+    // the target if it exists.
+    /// On Windows the target is removed before rename, so it is not atomic at all.
+    bool isAtomic = false;
+    /// @brief Whether write the members of compounds in the order of names. (See #Tag::canonicalize())
+    bool isCanonical = false;
+    /// @brief The data written before the root tag (compressed with it), e.g. the header of level.dat of bedrock
+    /// edition. (See the headerSize of #Tag::fromFile())
+    String header;
+};
 
-        return *this;
-    }
+/// @brief The memory used by the tags in bytes, by the kinds of data. (See #Tag::memoryUsage())
+/// @note The data shared by several tags (the compounds of copies, the interned strings, the shapes and the kept
+/// bytes) is counted once. The sizes are estimated by the sizes of objects and the capacities of containers,
+/// the overhead of the allocator is not included, and the nodes of maps are estimated as a pointer and the
+/// cached hash besides the key and value (same as libstdc++).
+struct MemoryUsage
+{
+    size_t nodeBytes        = 0;    ///< The tag objects, include the root, the list items and the members.
+    size_t nameBytes        = 0;    ///< The names of tags and the keys of shapes.
+    size_t payloadBytes     = 0;    ///< The string values, and the numbers of arrays and packed lists.
+    size_t containerBytes   = 0;    ///< The vectors and compound data, include the unused capacity.
+    size_t indexBytes       = 0;    ///< The maps of name to index of compounds and shapes.
+    size_t keptBytes        = 0;    ///< The bytes kept by #ReadOptions::isSpanKept.
+    size_t tagCount         = 0;    ///< The count of tags, include the numbers of packed lists.
+    size_t sharedCount      = 0;    ///< The count of references to the data counted before.
+
+    size_t total() const
+    { return nodeBytes + nameBytes + payloadBytes + containerBytes + indexBytes + keptBytes; }
+};
 
-    /// @brief Add a value to the int array.
-    /// @attention Only be called via #TT_INT_ARRAY.
-    Tag& addInt(Int32 value)
+/// @brief The RAII wrapper of file descriptor.
+class _File
+{
+public:
+    /// @brief Open the file to read, or to read and write (not create or truncate) if the mode has out.
+    explicit _File(const String& filename, std::ios::openmode mode = std::ios::in)
     {
-        assert(isIntArray());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isIntArray())
-            throw std::logic_error("Can't add int value to non-int array tag.");
+        bool isWritable = (mode & std::ios::out) != 0;
+    #ifdef _WIN32
+        fd_ = ::_open(filename.c_str(), (isWritable ? _O_RDWR : _O_RDONLY) | _O_BINARY);
+    #else
+        fd_ = ::open(filename.c_str(), (isWritable ? O_RDWR : O_RDONLY) | O_CLOEXEC);
     #endif
-
-        if (!tagData_.iad)
-            tagData_.iad = new Vec<Int32>();
-        tagData_.iad->emplace_back(value);
-
-        return *this;
+        if (fd_ == -1)
+            throw std::runtime_error("Failed to open file: " + filename);
     }
 
-    /// @brief Add a value to the long array.
-    /// @attention Only be called via #TT_LONG_ARRAY.
-    Tag& addLong(Int64 value)
+    /// @brief Open (create or truncate) the file to write.
+    _File(const String& filename, bool isDirect)
     {
-        assert(isLongArray());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isLongArray())
-            throw std::logic_error("Can't add long value to non-long array tag.");
-    #endif
-
-        if (!tagData_.lad)
-            tagData_.lad = new Vec<Int64>();
-        tagData_.lad->emplace_back(value);
-
-        return *this;
+        if (!openToWrite_(filename, false, isDirect))
+            throw std::runtime_error("Failed to open file: " + filename);
     }
 
-    /// @brief Add a tag to the list or compound.
-    /// @note Original tag will be moved to the new tag whether left-value or right-value reference,
-    // and the original tag will invalid after this operation, but you can call #copy() function to avoid this.
-    /// @attention Only be called via #TT_LIST, #TT_COMPOUND.
-    Tag& addTag(Tag&& tag)
+    /// @brief Create a new file to write, named as the filename and a unique suffix, so it is in the same
+    // directory as the file. (e.g. for replace the file by rename)
+    /// @param path Output the name of the file created.
+    _File(const String& filename, bool isDirect, String& path)
     {
-        assert(isContainer());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isContainer())
-            throw std::logic_error("Can't add tag to non-container tag.");
-    #endif
+        static std::atomic<UInt64> counter{ 0 };
 
-        assert(this != &tag);
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (this == &tag)
-            throw std::logic_error("Can't add self to self.");
-    #endif
-
-        assert(!isContained(tag));
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (isContained(tag))
-            throw std::logic_error("Can't add parent to self.");
+    #ifdef _WIN32
+        UInt64 pid = static_cast<UInt64>(::_getpid());
+    #else
+        UInt64 pid = static_cast<UInt64>(::getpid());
     #endif
 
-        // List
-        if (isList())
-        {
-        #ifndef MCNBT_DISABLE_EXCEPTION
-            if (itemType_ == TT_END)
-                throw std::logic_error("Can't read or write a uninitialized list.");
-
-            if (tag.tagType_ != itemType_)
-            {
-                String errmsg = "Can't add the tag of " + getTagTypeString(tag.type());
-                errmsg += " to the list of " + getTagTypeString(itemType_);
-                throw std::logic_error(errmsg);
-            }
-        #endif
-
-            if (!tagData_.ld)
-                tagData_.ld = new Vec<Tag>();
-
-            bool needShuffle = (tagData_.ld->capacity() - tagData_.ld->size()) == 0;
-            tagData_.ld->emplace_back(std::move(tag));
-
-            if (needShuffle)
-            {
-                for (auto& var : *tagData_.ld)
-                    var.parent_ = this;
-            }
-            else
-            {
-                tagData_.ld->back().parent_ = this;
-            }
-
-            if (tagData_.ld->back().tagName_)
-            {
-                delete tagData_.ld->back().tagName_;
-                tagData_.ld->back().tagName_ = nullptr;
-            }
-        }
-        // Compound
-        else
+        // The name is random to avoid the retries, the exclusive creation makes it unique.
+        for (int i = 0; i < 100; ++i)
         {
-            if (!tagData_.cd)
-                tagData_.cd = new CompoundData();
+            UInt64 now = static_cast<UInt64>(std::chrono::steady_clock::now().time_since_epoch().count());
+            UInt64 id = _hashMix(_hashMix(pid, now), counter.fetch_add(1, std::memory_order_relaxed));
 
-            if (hasTag(tag.name()))
-            {
-                tagData_.cd->data[tagData_.cd->idxs[tag.name()]] = std::move(tag);
-            }
-            else
-            {
-                bool needShuffle = (tagData_.cd->data.capacity() - tagData_.cd->size()) == 0;
-                tagData_.cd->data.emplace_back(std::move(tag));
-                tagData_.cd->idxs.insert({ tagData_.cd->data.back().name(), tagData_.cd->data.size() - 1 });
+            char suffix[24];
+            std::snprintf(suffix, sizeof(suffix), ".%016llx", static_cast<unsigned long long>(id));
+            path = filename + suffix + ".tmp";
 
-                if (needShuffle)
-                {
-                    for (auto& var : tagData_.cd->data)
-                        var.parent_ = this;
-                }
-                else
-                {
-                    tagData_.cd->data.back().parent_ = this;
-                }
-            }
+            if (openToWrite_(path, true, isDirect))
+                return;
+            if (errno != EEXIST)
+                break;
         }
 
-        return *this;
+        throw std::runtime_error("Failed to create temporary file for: " + filename);
     }
 
-    /// @overload
-    Tag& addTag(Tag& tag) { return addTag(std::move(tag)); }
+    /// @note The error of close is ignored, call #close() to check it.
+    ~_File()                    { closeFd_(); }
 
-    /// @brief Functions for get value. Only be called via corresponding tag.
+    _File(const _File&) = delete;
+    _File& operator=(const _File&) = delete;
 
-    /// @attention Only be called via #TT_BYTE.
-    Byte getByte() const
+    int fd() const              { return fd_; }
+
+    /// @brief Whether the file is opened with O_DIRECT.
+    bool isDirect() const
     {
-        assert(isByte());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isByte())
-            throw std::logic_error("Can't get byte value for non-byte tag.");
+    #if defined(O_DIRECT) && !defined(_WIN32)
+        int flags = ::fcntl(fd_, F_GETFL);
+        return flags != -1 && (flags & O_DIRECT) != 0;
+    #else
+        return false;
     #endif
-
-        return tagData_.num.i8;
     }
 
-    /// @attention Only be called via #TT_SHORT.
-    Int16 getShort() const
+    /// @brief Get the size of the file, return -1 if it is not a regular file (e.g. pipe).
+    Int64 size() const
     {
-        assert(isShort());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isShort())
-            throw std::logic_error("Can't get short value for non-short tag.");
+    #ifdef _WIN32
+        struct _stat64 st;
+        if (::_fstat64(fd_, &st) != 0 || (st.st_mode & _S_IFREG) == 0)
+            return -1;
+    #else
+        struct stat st;
+        if (::fstat(fd_, &st) != 0 || !S_ISREG(st.st_mode))
+            return -1;
     #endif
-
-        return tagData_.num.i16;
+        return static_cast<Int64>(st.st_size);
     }
 
-    /// @attention Only be called via #TT_INT.
-    Int32 getInt() const
+    /// @brief Set the permissions of the file same as the other file, if it exists.
+    void copyMode(const String& filename)
     {
-        assert(isInt());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isInt())
-            throw std::logic_error("Can't get int value for non-int tag.");
+    #ifdef _WIN32
+        (void) filename;
+    #else
+        struct stat st;
+        if (::stat(filename.c_str(), &st) == 0 && ::fchmod(fd_, st.st_mode & 07777) != 0)
+            throw std::runtime_error("Failed to set the mode of file: " + String(std::strerror(errno)));
     #endif
-
-        return tagData_.num.i32;
     }
 
-    /// @attention Only be called via #TT_LONG.
-    Int64 getLong() const
+    /// @brief Flush the data of the file to the storage device.
+    void sync()
     {
-        assert(isLong());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isLong())
-            throw std::logic_error("Can't get long value for non-long tag.");
+    #if defined(_WIN32)
+        int rslt = ::_commit(fd_);
+    #elif defined(__APPLE__)
+        int rslt = ::fsync(fd_);
+    #else
+        int rslt = ::fdatasync(fd_);
     #endif
+        if (rslt != 0)
+            throw std::runtime_error("Failed to sync file: " + String(std::strerror(errno)));
+    }
 
-        return tagData_.num.i64;
+    void close()
+    {
+        if (closeFd_() != 0)
+            throw std::runtime_error("Failed to close file: " + String(std::strerror(errno)));
     }
 
-    /// @attention Only be called via #TT_FLOAT.
-    Fp32 getFloat() const
+private:
+    /// @param isExclusive If true, create the file and fail if it exists, else create or truncate it.
+    bool openToWrite_(const String& filename, bool isExclusive, bool isDirect)
     {
-        assert(isFloat());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isFloat())
-            throw std::logic_error("Can't get float value for non-float tag.");
+    #ifdef _WIN32
+        (void) isDirect;
+        int flags = _O_WRONLY | _O_CREAT | _O_BINARY | (isExclusive ? _O_EXCL : _O_TRUNC);
+        fd_ = ::_open(filename.c_str(), flags, _S_IREAD | _S_IWRITE);
+    #else
+        int flags = O_WRONLY | O_CREAT | O_CLOEXEC | (isExclusive ? O_EXCL : O_TRUNC);
+        #ifdef O_DIRECT
+        fd_ = ::open(filename.c_str(), isDirect ? (flags | O_DIRECT) : flags, 0666);
+        // Some file systems don't support O_DIRECT.
+        if (fd_ == -1 && isDirect && errno == EINVAL)
+        #endif
+            fd_ = ::open(filename.c_str(), flags, 0666);
+        #if defined(F_NOCACHE)
+        if (fd_ != -1 && isDirect)
+            ::fcntl(fd_, F_NOCACHE, 1);
+        #endif
     #endif
-
-        return tagData_.num.f32;
+        return fd_ != -1;
     }
 
-    /// @attention Only be called via #TT_DOUBLE.
-    Fp64 getDouble() const
+    int closeFd_() noexcept
     {
-        assert(isDouble());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isDouble())
-            throw std::logic_error("Can't get double value for non-double tag.");
+        if (fd_ == -1)
+            return 0;
+
+    #ifdef _WIN32
+        int rslt = ::_close(fd_);
+    #else
+        int rslt = ::close(fd_);
     #endif
+        fd_ = -1;
 
-        return tagData_.num.f64;
+        return rslt;
     }
 
-    /// @brief Fast way of get the integer value.
-    /// @attention Only be called via #TT_BYTE, #TT_SHORT, #TT_INT, #TT_LONG.
-    Int64 getInteger() const
+    int fd_ = -1;
+};
+
+/// @brief The whole content of a file, mapped to memory if possible, else read to a buffer of exact size.
+class _FileContent
+{
+public:
+    /// @param size The size of the file, must be non-negative.
+    _FileContent(_File& file, size_t size) : size_(size)
     {
-        assert(isInteger());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isInteger())
-            throw std::logic_error("Can't get interger number for non-integer tag.");
-    #endif
+        if (size == 0)
+            return;
 
-        if (isByte())           return tagData_.num.i8;
-        if (isShort())          return tagData_.num.i16;
-        if (isInt())            return tagData_.num.i32;
-        if (isLong())           return tagData_.num.i64;
+    #ifndef _WIN32
+        void* addr = ::mmap(nullptr, size, PROT_READ, MAP_PRIVATE, file.fd(), 0);
+        if (addr != MAP_FAILED)
+        {
+        #ifdef MADV_SEQUENTIAL
+            ::madvise(addr, size, MADV_SEQUENTIAL);
+        #endif
+            map_ = addr;
+            data_ = static_cast<const char*>(addr);
+            return;
+        }
+    #endif
 
-        return 0;
+        buffer_.resize(size);
+        size_ = _readFd(file.fd(), buffer_.data(), size);
+        data_ = buffer_.data();
     }
 
-    /// @brief Fast way of get the float point value.
-    /// @attention Only be called via #TT_FLOAT, #TT_DOUBLE.
-    Fp64 getFloatPoint() const
+    ~_FileContent()
     {
-        assert(isFloatPoint());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isFloatPoint())
-            throw std::logic_error("Can't get float point number value for non-float point tag.");
+    #ifndef _WIN32
+        if (map_)
+            ::munmap(map_, size_);
     #endif
+    }
 
-        if (isFloat())
-            return tagData_.num.f32;
-        else
-            return tagData_.num.f64;
+    _FileContent(const _FileContent&) = delete;
+    _FileContent& operator=(const _FileContent&) = delete;
 
-        return 0;
-    }
+    const char* data() const    { return data_; }
 
-    /// @attention Only be called via #TT_STRING.
-    String getString() const
-    {
-        assert(isString());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isString())
-            throw std::logic_error("Can't get string value for non-string tag.");
-    #endif
+    size_t size() const         { return size_; }
 
-        return tagData_.str ? *tagData_.str : "";
-    }
+private:
+    void* map_ = nullptr;
+    Vec<Byte> buffer_;
+    const char* data_ = nullptr;
+    size_t size_;
+};
 
-    /// @attention Only be called via #TT_BYTE_ARRAY.
-    Vec<Byte> getByteArray() const
-    {
-        assert(isByteArray());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isByteArray())
-            throw std::logic_error("Can't get byte array value for non-byte array tag.");
-    #endif
+// The intrusive reference count of the data shared by several tags, the tags can be used by several threads.
+// The shared data is immutable, so only the count needs to be atomic.
+using _RefCount = std::atomic<size_t>;
 
-        return tagData_.bad ? *tagData_.bad : Vec<Byte>();
-    }
+inline void _addRef(_RefCount& refs)
+{ refs.fetch_add(1, std::memory_order_relaxed); }
 
-    /// @attention Only be called via #TT_INT_ARRAY.
-    Vec<Int32> getIntArray() const
-    {
-        assert(isIntArray());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isIntArray())
-            throw std::logic_error("Can't get int array value for non-int array tag.");
-    #endif
+/// @brief Remove a reference.
+/// @return true if no reference remains, then the data can be deleted.
+inline bool _subRef(_RefCount& refs)
+{ return refs.fetch_sub(1, std::memory_order_acq_rel) == 1; }
 
-        return tagData_.iad ? *tagData_.iad : Vec<Int32>();
-    }
+/// @brief Check if the data is referenced by one owner only, then it can be changed.
+inline bool _isUnique(const _RefCount& refs)
+{ return refs.load(std::memory_order_acquire) == 1; }
 
-    /// @attention Only be called via #TT_LONG_ARRAY.
-    Vec<Int64> getLongArray() const
-    {
-        assert(isLongArray());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isLongArray())
-            throw std::logic_error("Can't get long array value for non-long array tag.");
-    #endif
+// The string with intrusive reference count, can be shared by several tags.
+// (e.g. the same tag names and string values interned by #StringPool)
+// The shared string is immutable, a tag copies it before modify if it is shared. (See #_isShared())
+struct _SharedString
+{
+    explicit _SharedString(const String& str) : str(str) {}
 
-        return tagData_.lad ? *tagData_.lad : Vec<Int64>();
-    }
+    explicit _SharedString(String&& str) : str(std::move(str)) {}
 
-    /// @overload
-    /// @brief Get a value from the byte array by index.
-    /// @attention Only be called via #TT_BYTE_ARRAY.
-    Byte getByte(size_t idx) const
-    {
-        assert(isByteArray());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isByteArray())
-            throw std::logic_error("Can't get byte value from non-byte array tag.");
-    #endif
+    String str;
+    _RefCount refs{ 1 };
+    UInt64 hash = 0;    ///< The hash of #str, 0 if it is not computed. (See #_hashString())
+};
 
-        if (!tagData_.bad || idx >= tagData_.bad->size())
-            throw std::out_of_range("The specified index is out of range.");
+/// @brief Add a reference to the shared string.
+inline _SharedString* _retain(_SharedString* str)
+{
+    if (str)
+        _addRef(str->refs);
+    return str;
+}
 
-        return (*tagData_.bad)[idx];
-    }
+/// @brief Remove a reference from the shared string, delete it if no reference.
+inline void _release(_SharedString* str)
+{
+    if (str && _subRef(str->refs))
+        delete str;
+}
 
-    /// @attention Only be called via #TT_BYTE_ARRAY.
-    Byte getFrontByte() const
-    {
-        assert(isByteArray());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isByteArray())
-            throw std::logic_error("Can't get front byte value from non-byte array tag.");
-    #endif
+inline bool _isShared(const _SharedString* str)
+{ return str && !_isUnique(str->refs); }
 
-        if (!tagData_.bad || tagData_.bad->empty())
-            throw std::out_of_range("The front member is not exists.");
+/// @brief Get the hash of the shared string, 0 if it is empty. (nullptr is empty string)
+// Use the hash computed by #StringPool if has.
+inline UInt64 _hashString(const _SharedString* str)
+{
+    if (!str || str->str.empty())
+        return 0;
 
-        return tagData_.bad->front();
-    }
+    return str->hash != 0 ? str->hash : _hashBytes(str->str.data(), str->str.size());
+}
 
-    /// @attention Only be called via #TT_BYTE_ARRAY.
-    Byte getBackByte() const
-    {
-        assert(isByteArray());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isByteArray())
-            throw std::logic_error("Can't get back byte value from non-byte array tag.");
-    #endif
+/// @brief Check if the two shared strings are equal, compare the pointer first. (nullptr is empty string)
+inline bool _isEqual(const _SharedString* lhs, const _SharedString* rhs)
+{
+    if (lhs == rhs)
+        return true;
 
-        if (!tagData_.bad || tagData_.bad->empty())
-            throw std::out_of_range("The back member is not exits.");
+    if (!lhs || !rhs)
+        return (lhs ? lhs : rhs)->str.empty();
 
-        return tagData_.bad->back();
-    }
+    return lhs->str == rhs->str;
+}
 
-    /// @overload
-    /// @brief Get a value from the int array by index.
-    /// @attention Only be called via #TT_INT_ARRAY.
-    Int32 getInt(size_t idx) const
-    {
-        assert(isIntArray());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isIntArray())
-            throw std::logic_error("Can't get int value from non-int array tag.");
-    #endif
+class Tag;
 
-        if (!tagData_.iad || idx >= tagData_.iad->size())
-            throw std::out_of_range("The specified index is out of range.");
+/// @brief The table of interned strings, the same tag names and string values read from binary are
+/// stored once and shared by the tags, and be compared by pointer.
+/// @note Every read of binary uses a pool of its own if no pool is specified,
+// specify a pool to share the strings among the tags of several reads (e.g. the files of a world).
+// The pool holds a reference to each string, and can be destroyed before the tags.
+class StringPool
+{
+public:
+    StringPool() = default;
 
-        return (*tagData_.iad)[idx];
-    }
+    ~StringPool() { clear(); }
 
-    /// @attention Only be called via #TT_INT_ARRAY.
-    Int32 getFrontInt() const
-    {
-        assert(isIntArray());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isIntArray())
-            throw std::logic_error("Can't get front int value from non-int array tag.");
-    #endif
+    StringPool(const StringPool&) = delete;
+    StringPool& operator=(const StringPool&) = delete;
 
-        if (!tagData_.iad || tagData_.iad->empty())
-            throw std::out_of_range("The front member is not exists.");
+    /// @brief Get the count of interned strings.
+    size_t size() const { return strs_.size(); }
 
-        return tagData_.iad->front();
+    /// @brief Remove the strings which are not referenced by any tag.
+    void shrink()
+    {
+        for (auto it = strs_.begin(); it != strs_.end();)
+        {
+            if (_isUnique((*it)->refs))
+            {
+                _release(*it);
+                it = strs_.erase(it);
+            }
+            else
+            {
+                ++it;
+            }
+        }
     }
 
-    /// @attention Only be called via #TT_INT_ARRAY.
-    Int32 getBackInt() const
+    /// @brief Remove all strings. (The strings referenced by tags are still valid)
+    void clear()
     {
-        assert(isIntArray());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isIntArray())
-            throw std::logic_error("Can't get back int value from non-int array tag.");
-    #endif
+        for (auto var : strs_)
+            _release(var);
+        strs_.clear();
+    }
 
-        if (!tagData_.iad || tagData_.iad->empty())
-            throw std::out_of_range("The back member is not exits.");
+private:
+    friend class Tag;
 
-        return tagData_.iad->back();
-    }
+    struct Hash
+    {
+        size_t operator()(const _SharedString* str) const { return static_cast<size_t>(str->hash); }
+    };
 
-    /// @overload
-    /// @brief Get a value from long array by index.
-    /// @attention Only be called via #TT_LONG_ARRAY.
-    Int64 getLong(size_t idx) const
+    struct Equal
     {
-        assert(isLongArray());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isLongArray())
-            throw std::logic_error("Can't get long value from non-long array tag.");
-    #endif
+        bool operator()(const _SharedString* lhs, const _SharedString* rhs) const
+        { return lhs == rhs || lhs->str == rhs->str; }
+    };
 
-        if (!tagData_.lad || idx >= tagData_.lad->size())
-            throw std::out_of_range("The specified index is out of range.");
+    /// @brief The buffer to read the string to intern, so that no allocation if the string is interned.
+    String& buffer_() { return probe_.str; }
 
-        return (*tagData_.lad)[idx];
+    /// @brief Intern the string in buffer.
+    /// @return The interned string with a new reference, or nullptr if the string is empty.
+    _SharedString* intern_()
+    {
+        if (probe_.str.empty())
+            return nullptr;
+
+        probe_.hash = _hashBytes(probe_.str.data(), probe_.str.size());
+        auto it = strs_.find(&probe_);
+        if (it != strs_.end())
+            return _retain(*it);
+
+        _SharedString* str = new _SharedString(probe_.str);
+        str->hash = probe_.hash;
+        strs_.insert(str);
+
+        return _retain(str);
     }
 
-    /// @attention Only be called via #TT_LONG_ARRAY.
-    Int64 getFrontLong() const
+    /// @brief Intern the string, it is added to the pool if no same string in pool.
+    /// @return The interned string with a new reference, or nullptr if the string is empty.
+    _SharedString* intern_(_SharedString* str)
     {
-        assert(isLongArray());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isLongArray())
-            throw std::logic_error("Can't get front long value from non-long array tag.");
-    #endif
+        if (!str || str->str.empty())
+            return nullptr;
 
-        if (!tagData_.lad || tagData_.lad->empty())
-            throw std::out_of_range("The front member is not exists.");
+        str->hash = _hashBytes(str->str.data(), str->str.size());
+        auto it = strs_.find(str);
+        if (it != strs_.end())
+            return _retain(*it);
 
-        return tagData_.lad->front();
+        strs_.insert(_retain(str));
+
+        return _retain(str);
     }
 
-    /// @attention Only be called via #TT_LONG_ARRAY.
-    Int64 getBackLong() const
-    {
-        assert(isLongArray());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isLongArray())
-            throw std::logic_error("Can't get back long value from non-long array tag.");
-    #endif
+    _SharedString probe_{ String() };
+    std::unordered_set<_SharedString*, Hash, Equal> strs_;
+};
 
-        if (!tagData_.lad || tagData_.lad->empty())
-            throw std::out_of_range("The back member is not exits.");
+/// @brief The options of read the tag from binary.
+struct ReadOptions
+{
+    /// @brief The pool to intern the tag names and string values, each read uses a pool of own if nullptr.
+    /// Specify it to share the strings among several reads. (See #StringPool)
+    StringPool* pool = nullptr;
+    /// @brief Whether share the identical compounds (hash-consing), e.g. the same block states and item stacks
+    /// are stored once. The shared compound is copied on first change, and writes the full bytes as usual.
+    bool isDedup = false;
+    /// @brief Whether keep the bytes read, then the compounds not accessed as non-const since read are written
+    /// by copy their bytes instead of encode again (when write with same encoding and not canonical).
+    /// So save a large tag which is slightly changed costs the time proportional to the changes.
+    /// @note All the remaining data of the source is read, and the bytes of the tag are kept in memory until the
+    // compounds are released.
+    /// Access the tags not need to change by const reference to keep them clean.
+    bool isSpanKept = false;
+};
 
-        return tagData_.lad->back();
+} // namespace nbt
+
+// Main
+namespace nbt
+{
+
+class Tag
+{
+public:
+    Tag() = default;
+
+    /// @note Release all alloced memory and set the parent to nullptr.
+    ~Tag()
+    {
+        release_();
+        parent_ = nullptr;
     }
 
-    /// @brief Get the tag by index.
-    /// @attention Only be called via #TT_LIST, #TT_COMPOUND.
-    Tag& getTag(size_t idx)
+    /// @note Not copy the other's parent.
+    // The compound data is shared with the other until either is changed, so copy is cheap. (See #copy())
+    Tag(const Tag& other)
     {
-        assert(isContainer());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isContainer())
-            throw std::logic_error("Can't get tag from non-container tag.");
-    #endif
+        copyData_(other);
 
-        // List
-        if (isList())
-        {
-        #ifndef MCNBT_DISABLE_EXCEPTION
-            if (itemType_ == TT_END)
-                throw std::logic_error("Can't read or write a uninitialized list.");
-        #endif
+        // The name is immutable, so share it.
+        tagName_ = _retain(other.nameRef_());
+    }
 
-            if (!tagData_.ld || idx >= tagData_.ld->size())
-                throw std::out_of_range("The specified index is out of range.");
+    /// @note Copy the other's parent.
+    Tag(Tag&& other) noexcept
+        : tagType_(other.tagType_), itemType_(other.itemType_), isPacked_(other.isPacked_),
+        tagData_(other.tagData_), tagName_(other.tagName_)
+    {
+        // The member of compound which shares the shape has no own name.
+        if (!tagName_)
+            tagName_ = _retain(other.nameRef_());
 
-            return (*tagData_.ld)[idx];
+        if (isList() && !isPacked_ && tagData_.ld)
+        {
+            for (auto& var : *tagData_.ld)
+                var.parent_ = this;
         }
-        // Compound
-        else
+        else if (isPackedList_())
         {
-            if (!tagData_.cd || idx >= tagData_.cd->size())
-                throw std::out_of_range("The specified index is out of range.");
-
-            return tagData_.cd->data[idx];
+            PackedReparenter_ reparenter{ *this };
+            visitPacked_(reparenter);
         }
+        else if (isCompound() && tagData_.cd)
+        {
+            // The members of shared data have no parent.
+            if (!tagData_.cd->empty() && tagData_.cd->data.front().parent_)
+            {
+                for (auto& var : tagData_.cd->data)
+                    var.parent_ = this;
+            }
+        }
+
+        other.tagData_.str  = nullptr;
+        other.tagName_      = nullptr;
     }
 
-    /// @overload
-    /// @brief Get the tag by name.
-    /// @attention Only be called via #TT_COMPOUND.
-    Tag& getTag(const String& name)
+    /// @note Not copy the other's parent.
+    // The compound data is shared with the other until either is changed. (See #copy())
+    Tag& operator=(const Tag& other)
     {
-        assert(isCompound());
-        assert(hasTag(name));
+        assert(!(isListItem() && (type() != other.type())));
     #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isCompound())
-            throw std::logic_error("Can't get tag from non-compound tag.");
+        if (isListItem() && (type() != other.type()))
+            throw std::logic_error("Can't assign a tag of incorrect tag type to list element.");
+    #endif
 
-        if (!hasTag(name))
-            throw std::logic_error("The specified name is not exists.");
+        if (this == &other)
+            return *this;
 
-        if (!tagData_.cd)
-            throw std::logic_error("The member of specified name is not exists.");
-    #endif
+        // The other may be a member of self or contain self, so copy it before release self.
+        Tag copy;
+        copy.copyData_(other);
+        _SharedString* name = isListItem() ? nullptr : _retain(other.nameRef_());
+
+        release_();
+
+        takeData_(copy);
+        tagName_ = name;
 
-        return tagData_.cd->data[tagData_.cd->idxs[name]];
+        return *this;
     }
 
-    /// @attention Only be called via #TT_LIST, #TT_COMPOUND.
-    Tag& getFrontTag()
+    /// @note Copy the other's parent.
+    Tag& operator=(Tag&& other)
     {
-        assert(isContainer());
+        assert(!isContained(other));
     #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isContainer())
-            throw std::logic_error("Can't get front tag from non-container tag.");
+        if (isContained(other))
+            throw std::logic_error("Can't assign parent to self.");
     #endif
 
-        // List
-        if (isList())
-        {
-        #ifndef MCNBT_DISABLE_EXCEPTION
-            if (itemType_ == TT_END)
-                throw std::logic_error("Can't read or write a uninitialized list.");
-        #endif
+        assert(!(isListItem() && (type() != other.type())));
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (isListItem() && (type() != other.type()))
+            throw std::logic_error("Can't assign a tag of incorrect tag type to list element");
+    #endif
 
-            if (!tagData_.ld || tagData_.ld->empty())
-                throw std::out_of_range("The front member is not exists.");
+        if (this == &other)
+            return *this;
 
-            return tagData_.ld->front();
-        }
-        // Compound
-        else
+        release_();
+
+        tagName_ = other.tagName_;
+        // The member of compound which shares the shape has no own name.
+        if (!tagName_)
+            tagName_ = _retain(other.nameRef_());
+
+        takeData_(other);
+        other.tagName_ = nullptr;
+
+        if (isListItem() && tagName_)
         {
-            if (!tagData_.cd || tagData_.cd->empty())
-                throw std::out_of_range("The front member is not exists.");
+            _release(tagName_);
+            tagName_ = nullptr;
+        }
 
-            return tagData_.cd->data.front();
+        return *this;
+    }
+
+    explicit Tag(TagType type) : tagType_(type) {}
+
+    /// @brief Get the tag from binary input stream.
+    /// @param is               The input stream.
+    /// @param enc              The encoding of the data of input stream.
+    /// @param headerSize       The size of need discard data from input stream begin.
+    // (usually is 0, but bedrock edition map file is 8, some useless dat)
+    /// @param options          The options about the memory of tag. (See #ReadOptions)
+    static Tag fromBinStream(IStream& is, Encoding enc, size_t headerSize = 0,
+                             const ReadOptions& options = ReadOptions())
+    {
+        return handleStream_(is, enc, headerSize, TagReader_{ options });
+    }
+
+    /// @overload
+    /// @param isBigEndian      Whether the read data from input stream with big endian.
+    static Tag fromBinStream(IStream& is, bool isBigEndian, size_t headerSize = 0)
+    {
+        return fromBinStream(is, getEncoding(isBigEndian), headerSize);
+    }
+
+    /// @brief Get the tag from a nbt file.
+    /// @note The regular file is mapped to memory (or read to a buffer of exact size) at once,
+    // others (e.g. pipe) are read chunk by chunk.
+    /// @param options          The options about the memory of tag. (See #ReadOptions)
+    static Tag fromFile(const String& filename, Encoding enc, size_t headerSize = 0,
+                        const ReadOptions& options = ReadOptions())
+    {
+        return handleFile_(filename, enc, headerSize, TagReader_{ options });
+    }
+
+    /// @overload
+    static Tag fromFile(const String& filename, bool isBigEndian, size_t headerSize = 0)
+    {
+        return fromFile(filename, getEncoding(isBigEndian), headerSize);
+    }
+
+    /// @brief Get the tag from any binary source.
+    /// @param src              The source, e.g. #BufferSource, #StreamSource, #FileSource or gzip::DecompressSource.
+    // See the comment about the source before #_readBytes().
+    /// @param options          The options about the memory of tag. (See #ReadOptions)
+    /// @note The data of source must be uncompressed.
+    template <typename Source>
+    static Tag fromSource(Source& src, Encoding enc, const ReadOptions& options = ReadOptions())
+    {
+        return TagReader_{ options }(src, enc);
+    }
+
+    /// @brief Get the tag from the value without type and name from any binary source, e.g. the list item.
+    // (See #fromSource())
+    /// @param type The type of the value.
+    /// @note The #ReadOptions::isSpanKept is ignored.
+    template <typename Source>
+    static Tag valueFromSource(Source& src, Encoding enc, TagType type, const ReadOptions& options = ReadOptions())
+    {
+        MCNBT_STATS(_StatsScope scope(SK_READ);)
+        MCNBT_STATS(_StatsBytes<Source> bytes(src);)
+
+        Tag tag;
+        tag.tagType_ = type;
+
+        ReadContext_ ctx(options);
+        readValue_(tag, src, enc, ctx, 0);
+
+        return tag;
+    }
+
+    /// @brief Get the fingerprint of the binary NBT from input stream, without construct the tags.
+    /// @note The fingerprint is the hash of the names, types and values of the tags, so it is same whether
+    // the data is compressed or not and in any encoding, and same on all platforms. But it is 64-bit and not
+    // cryptographic, don't use it against the crafted data.
+    // Same as the fingerprint of the tag read from the data. (See #fingerprint())
+    /// @param isKeyOrderIgnored If true, the compounds of same members in different order have same fingerprint.
+    static UInt64 fingerprintStream(IStream& is, Encoding enc, size_t headerSize = 0, bool isKeyOrderIgnored = false)
+    {
+        return handleStream_(is, enc, headerSize, FingerprintReader_{ isKeyOrderIgnored });
+    }
+
+    /// @brief Get the fingerprint of the nbt file, without construct the tags. (See #fingerprintStream())
+    static UInt64 fingerprintFile(const String& filename, Encoding enc, size_t headerSize = 0,
+                                  bool isKeyOrderIgnored = false)
+    {
+        return handleFile_(filename, enc, headerSize, FingerprintReader_{ isKeyOrderIgnored });
+    }
+
+    /// @brief Get the fingerprint of the binary NBT from any source, without construct the tags.
+    // (See #fingerprintStream() and #fromSource())
+    /// @note The data of source must be uncompressed.
+    template <typename Source>
+    static UInt64 fingerprintSource(Source& src, Encoding enc, bool isKeyOrderIgnored = false)
+    {
+        return FingerprintReader_{ isKeyOrderIgnored }(src, enc);
+    }
+
+    /// @todo
+    /// @brief Get the tag from a text input stream.
+    /// @note - The root tag must be a compound tag.
+    /// @note - The tag name (key of key-value) must valid, it can't contains {, }, [,] and so on key characters.
+    static Tag fromSnbt(IStream& is) { return Tag(); };
+
+    /// @brief Get the tag from a string.
+    /// @note - The root tag must be a compound tag.
+    /// @note - The tag name (key of key-value) must valid, it can't contains {, }, [,] and so on key characters.
+    static Tag fromSnbt(const String& snbt)
+    {
+        SStream ss;
+        ss << snbt;
+        return fromSnbt(ss);
+    }
+
+   /// @brief Functions of check tag type.
+
+    bool isEnd() const          { return nbt::isEnd(tagType_); }
+
+    bool isByte() const         { return nbt::isByte(tagType_); }
+
+    bool isShort() const        { return nbt::isShort(tagType_); }
+
+    bool isInt() const          { return nbt::isInt(tagType_); }
+
+    bool isLong() const         { return nbt::isLong(tagType_); }
+
+    bool isFloat() const        { return nbt::isFloat(tagType_); }
+
+    bool isDouble() const       { return nbt::isDouble(tagType_); }
+
+    bool isString() const       { return nbt::isString(tagType_); }
+
+    bool isByteArray() const    { return nbt::isByteArray(tagType_); }
+
+    bool isIntArray() const     { return nbt::isIntArray(tagType_); }
+
+    bool isLongArray() const    { return nbt::isLongArray(tagType_); }
+
+    bool isList() const         { return nbt::isList(tagType_); }
+
+    bool isCompound() const     { return nbt::isCompound(tagType_); }
+
+    bool isInteger() const      { return nbt::isInteger(tagType_); }
+
+    bool isFloatPoint() const   { return nbt::isFloatPoint(tagType_); }
+
+    bool isNum() const          { return nbt::isNum(tagType_); }
+
+    bool isArray() const        { return nbt::isArray(tagType_); }
+
+    bool isContainer() const    { return nbt::isContainer(tagType_); }
+
+    /// Functions of common to all tag.
+
+    /// @brief Make a copy.
+    // Usually used for add tag to list or compound. (because default is move when add tag to list or compound)
+    /// @note The copy shares the compound data with self (copy-on-write), the first change through either
+    // copies the compounds on the path being changed only. So copy a compound is O(1), and copy a list
+    // copies the items but not the compounds of them.
+    // The copies can be used by different threads at the same time, but one tag (include copy it) should
+    // be used by one thread at a time, e.g. make the copies for the worker threads in the main thread.
+    // The compounds which the non-const references of members are got from are copied instead, so the
+    // references still refer to the members of self only. (See #expose_())
+    Tag copy() const            { return Tag(*this); }
+
+    /// @brief Assign a tag to self, be equal to *this = tag;
+    Tag& assign(const Tag& tag) { *this = tag; return *this; }
+
+    /// @brief Get the hash of the type and value, include the names and values of the members
+    // but not the name of self.
+    /// @note The equal tags have same hash. (See #equals())
+    // The hash of compound shared by the copies is cached until the compound is changed.
+    // The hash is not stable across the platforms and versions, don't save it.
+    UInt64 hash() const         { return hashValue_(); }
+
+    /// @brief Check if the type and value are equal to the other's, include the names and values of
+    // the members but not the name of self.
+    /// @note The numbers are compared by bits, so NaN is equal to the NaN of same bits, but 0.0 is not
+    // equal to -0.0. The list of numbers is equal to the list of same numbers whether it is packed or not.
+    bool equals(const Tag& other) const { return isSameValue_(*this, other); }
+
+    /// @brief Check if the tag shares the compound data with the other (e.g. the copy not changed),
+    // then they are equal. (See #copy())
+    bool isSharedWith(const Tag& other) const
+    { return isCompound() && other.isCompound() && tagData_.cd && tagData_.cd == other.tagData_.cd; }
+
+    /// @brief Get the fingerprint of the tag, include its name, same as the fingerprint of the binary
+    // written by it. (See #fingerprintStream())
+    /// @param isKeyOrderIgnored If true, the compounds of same members in different order have same fingerprint.
+    UInt64 fingerprint(bool isKeyOrderIgnored = false) const
+    {
+        Vec<Byte> bin;
+        {
+            VecSink sink(bin);
+            write_(sink, EC_LITTLE_ENDIAN, false);
         }
+
+        BufferSource src(bin.data(), bin.size());
+
+        return fingerprintSource(src, EC_LITTLE_ENDIAN, isKeyOrderIgnored);
     }
 
-    /// @attention Only be called via #TT_LIST, #TT_COMPOUND.
-    Tag& getBackTag()
+    /// @brief Get the tag type.
+    TagType type() const        { return tagType_; }
+
+    /// @brief Get the name of tag.
+    String name() const
     {
-        assert(isContainer());
+        const _SharedString* name = nameRef_();
+        return name ? name->str : "";
+    }
+
+    /// @brief Get the name length of tag.
+    Int16 nameLength() const    { return static_cast<Int16>(name().size()); }
+
+    /// @brief Set the name of tag.
+    /// @note If the new name already exist in parent, cover it.
+    /// @attention Only be called via non-ListItem.
+    Tag& setName(const String& name)
+    {
+        assert(!isListItem());
     #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isContainer())
-            throw std::logic_error("Can't get back tag from non-container tag.");
+        if (isListItem())
+            throw std::logic_error("Can't set name for list element.");
     #endif
 
-        // List
-        if (isList())
-        {
-        #ifndef MCNBT_DISABLE_EXCEPTION
-            if (itemType_ == TT_END)
-                throw std::logic_error("Can't read or write a uninitialized list.");
-        #endif
+        // If the new name is empty and the old name is empty (maybe not exists), do nothing.
+        if (name.empty() && this->name().empty())
+            return *this;
 
-            if (!tagData_.ld || tagData_.ld->empty())
-                throw std::out_of_range("The back member is not exists.");
+        // If the new name is equal to the old name, do nothing.
+        String oldname = this->name();
+        if (name == oldname)
+            return *this;
 
-            return tagData_.ld->back();
+        // Why need some step above? see below.
+
+        if (!parent_)
+        {
+            _release(tagName_);
+            tagName_ = name.empty() ? nullptr : new _SharedString(name);
+
+            return *this;
         }
-        // Compound
         else
         {
-            if (!tagData_.cd || tagData_.cd->empty())
-                throw std::out_of_range("The back member is not exists.");
+            Tag* p = parent_;
+            p->detach_();
+            p->unshare_();
 
-            return tagData_.cd->data.back();
+            if (p->hasTag(name))
+                p->remove(name);
+
+            Tag& t = (*p)[oldname];
+
+            _release(t.tagName_);
+            t.tagName_ = name.empty() ? nullptr : new _SharedString(name);
+
+            size_t idx = p->tagData_.cd->idxs[oldname];
+
+            p->tagData_.cd->idxs.erase(oldname);
+            p->tagData_.cd->idxs.insert({ name, idx });
+
+            return t;
         }
     }
 
-    /// @brief Remove the element by index.
-    /// @attention Only be called via
-    // #TT_STRING, #TT_BYTE_ARRAY, #TT_INT_ARRAY, #TT_LONG_ARRAY, #TT_LIST, #TT_COMPOUND.
-    Tag& remove(size_t idx)
+    /// @brief Check if is a list element.
+    bool isListItem() const     { return parent_ && parent_->isList(); }
+
+    /// @brief Check if the parent is exists.
+    bool hasParent() const      { return parent_ != nullptr; }
+
+    /// @return The parent pointer.
+    const Tag* parent() const   { return parent_; }
+
+    /// @brief Check if is be contained in specified tag.
+    /// @param container The tag that be checked whether self is contained in it.
+    /// @note Recursive check all the parent (parent's parent) until a parent is nullptr.
+    bool isContained(const Tag& container) const
     {
-        assert(isString() || isArray() || isContainer());
+        const Tag* p = parent_;
+
+        while (p)
+        {
+            if (p == &container)
+                return true;
+            p = p->parent_;
+        }
+
+        return false;
+    }
+
+    /// @brief Functions about the list tag.
+
+    /// @brief Get the list item type.
+    /// @attention Only be called via #TT_LIST.
+    TagType listItemType() const
+    {
+        assert(isList());
     #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isString() && !isArray() && !isContainer())
-            throw std::logic_error("Can't remove element from non-string, non-array, non-container tag.");
+        if (!isList())
+            throw std::logic_error("Can't get the list item type for non-list tag.");
     #endif
 
-        if (isString())
+        return itemType_;
+    }
+
+    /// @brief Check if the list item type is be seted.
+    /// @attention Only be called via #TT_LIST.
+    bool hasSetListItemType() const
+    {
+        return listItemType() != TT_END;
+    }
+
+    /// @brief Set the tag type of list item.
+    /// @note If the list item type already be seted, cover the original list item type and remove all original items.
+    /// @attention Only be called via #TT_LIST.
+    Tag& setListItemType(TagType type)
+    {
+        assert(isList());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isList())
+            throw std::logic_error("Can't set the list item type for non-list tag.");
+    #endif
+
+        if (itemType_ != TT_END)
+            releaseList_();
+
+        itemType_ = type;
+        // The list of numbers is stored as packed array.
+        isPacked_ = nbt::isNum(type);
+
+        return *this;
+    }
+
+    /// @attention Only be called via #TT_LIST.
+    Tag& assign(size_t size, const Tag& tag)
+    {
+        assert(isList());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isList())
+            throw std::logic_error("Can't assign multiple tags to non-list tag.");
+
+        if (itemType_ == TT_END)
+            throw std::logic_error("Can't read or write a uninitialized list.");
+
+        if (tag.type() != itemType_)
+        {
+            String errmsg = "Can't assign the tag of " + getTagTypeString(tag.type());
+            errmsg += " to the list of " + getTagTypeString(itemType_);
+            throw std::logic_error(errmsg);
+        }
+    #endif
+
+        if (isPacked_)
+        {
+            removeAll();
+
+            PackedAppender_ appender{ tag.tagData_.num, size };
+            visitPacked_(appender);
+
+            return *this;
+        }
+
+        if (size == 0 && !tagData_.ld)
+            return *this;
+
+        if (!tagData_.ld)
+            tagData_.ld = new Vec<Tag>();
+
+        tagData_.ld->assign(size, tag);
+
+        return *this;
+    }
+
+    /// @brief Check if the list of numbers is stored as packed array now, then #listData() const can be called.
+    bool isPacked() const       { return isPackedList_(); }
+
+    /// @brief Get the packed array of the items of the list of numbers, for bulk read and write.
+    /// @tparam T The type of number, must be correspond to the list item type (e.g. #Int32 of #TT_INT).
+    /// @note The list of numbers is stored as packed array instead of tags, until its item is referenced by
+    // #getTag(), #getFrontTag() or #getBackTag(). This function packs it again,
+    // so the references of items got before are invalid.
+    /// @attention Only be called via #TT_LIST of #TT_BYTE, #TT_SHORT, #TT_INT, #TT_LONG, #TT_FLOAT, #TT_DOUBLE.
+    template <typename T>
+    Vec<T>& listData()
+    {
+        assert(isList() && itemType_ == _NumTagType<T>::value);
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isList() || itemType_ != _NumTagType<T>::value)
+            throw std::logic_error("Can't get the packed data of non-list tag or the list of other item type.");
+    #endif
+
+        pack_();
+
+        Vec<T>*& vec = packedVec_(static_cast<T*>(nullptr));
+        if (!vec)
+            vec = new PackedVec_<T>();
+        asPacked_(vec)->clearItems();
+
+        return *vec;
+    }
+
+    /// @overload
+    /// @note Throw if the list is not packed now (see the non-const overload).
+    template <typename T>
+    const Vec<T>& listData() const
+    {
+        assert(isList() && itemType_ == _NumTagType<T>::value);
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isList() || itemType_ != _NumTagType<T>::value)
+            throw std::logic_error("Can't get the packed data of non-list tag or the list of other item type.");
+
+        if (!isPacked_)
+            throw std::logic_error("Can't get the packed data of the list which items are referenced as tag.");
+    #endif
+
+        static const Vec<T> empty;
+        const Vec<T>* vec = const_cast<Tag*>(this)->packedVec_(static_cast<T*>(nullptr));
+
+        return vec ? *vec : empty;
+    }
+
+    /// @brief Copy the numbers of the array or the list of numbers, whether the list is packed or not.
+    /// @tparam T The type of number, must be correspond to the array or the list item type.
+    /// @param count The max count of numbers to copy.
+    /// @return The count of numbers copied.
+    /// @attention Only be called via #TT_BYTE_ARRAY, #TT_INT_ARRAY, #TT_LONG_ARRAY and #TT_LIST of numbers.
+    template <typename T>
+    size_t copyNumbers(T* dst, size_t count) const
+    {
+        constexpr TagType numType = _NumTagType<T>::value;
+        bool isArrayOfT = (isByteArray() && numType == TT_BYTE) || (isIntArray() && numType == TT_INT) ||
+                          (isLongArray() && numType == TT_LONG);
+        assert(isArrayOfT || (isList() && itemType_ == numType));
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isArrayOfT && !(isList() && itemType_ == numType))
+            throw std::logic_error("Can't copy the numbers of non-array tag or the list of other item type.");
+    #endif
+
+        if (isList() && !isPacked_)
+        {
+            size_t size = tagData_.ld ? tagData_.ld->size() : 0;
+            size_t n = count < size ? count : size;
+            for (size_t i = 0; i < n; ++i)
+                dst[i] = loadNum_<T>((*tagData_.ld)[i].tagData_.num);
+
+            return n;
+        }
+
+        const Vec<T>* vec = const_cast<Tag*>(this)->packedVec_(static_cast<T*>(nullptr));
+        size_t size = vec ? vec->size() : 0;
+        size_t n = count < size ? count : size;
+        if (n != 0)
+            std::memcpy(dst, vec->data(), n * sizeof(T));
+
+        return n;
+    }
+
+    /// @brief Append the values to the byte array or the list of byte.
+    /// @attention Only be called via #TT_BYTE_ARRAY, #TT_LIST of #TT_BYTE.
+    Tag& appendBytes(const Byte* data, size_t count)    { return appendNumbers_(data, count, TT_BYTE_ARRAY); }
+
+    /// @brief Append the values to the list of short.
+    /// @attention Only be called via #TT_LIST of #TT_SHORT.
+    Tag& appendShorts(const Int16* data, size_t count)  { return appendNumbers_(data, count, TT_END); }
+
+    /// @brief Append the values to the int array or the list of int.
+    /// @attention Only be called via #TT_INT_ARRAY, #TT_LIST of #TT_INT.
+    Tag& appendInts(const Int32* data, size_t count)    { return appendNumbers_(data, count, TT_INT_ARRAY); }
+
+    /// @brief Append the values to the long array or the list of long.
+    /// @attention Only be called via #TT_LONG_ARRAY, #TT_LIST of #TT_LONG.
+    Tag& appendLongs(const Int64* data, size_t count)   { return appendNumbers_(data, count, TT_LONG_ARRAY); }
+
+    /// @brief Append the values to the list of float.
+    /// @attention Only be called via #TT_LIST of #TT_FLOAT.
+    Tag& appendFloats(const Fp32* data, size_t count)   { return appendNumbers_(data, count, TT_END); }
+
+    /// @brief Append the values to the list of double.
+    /// @attention Only be called via #TT_LIST of #TT_DOUBLE.
+    Tag& appendDoubles(const Fp64* data, size_t count)  { return appendNumbers_(data, count, TT_END); }
+
+    /// @brief Functions about the compound tag.
+
+    /// @brief Check if the compound contains member of specified name.
+    /// @attention Only be called via #TT_COMPOUND.
+    bool hasTag(const String& name) const
+    {
+        assert(isCompound());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isCompound())
+            throw std::logic_error("Can't check tag existence for non-compound tag.");
+    #endif
+
+        if (!tagData_.cd)
+            return false;
+
+        const auto& idxs = tagData_.cd->index();
+        return idxs.find(name) != idxs.end();
+    }
+
+    /// @brief Get the index of the member by name.
+    /// @param hint The index to check first, the name is looked up only if the member at it has other name.
+    // e.g. The index found in the compound of same layout before.
+    /// @return The index, or #size() if the member is not exists.
+    /// @attention Only be called via #TT_COMPOUND.
+    size_t indexOf(const String& name, size_t hint = 0) const
+    {
+        assert(isCompound());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isCompound())
+            throw std::logic_error("Can't get the index of member for non-compound tag.");
+    #endif
+
+        if (!tagData_.cd)
+            return 0;
+
+        const CompoundData& cd = *tagData_.cd;
+        if (hint < cd.size())
+        {
+            const String* hintName = cd.data[hint].namePtr_();
+            if (hintName ? *hintName == name : name.empty())
+                return hint;
+        }
+
+        const auto& idxs = cd.index();
+        auto it = idxs.find(name);
+
+        return it != idxs.end() ? it->second : cd.size();
+    }
+
+    /// @brief Functions about the tag of containers.
+
+    /// @brief Get the length of string or size of array or tag counts of list and compound.
+    /// @attention Only be called via
+    // #TT_STRING, #TT_BYTE_ARRAY, #TT_INT_ARRAY, #TT_LONG_ARRAY, #TT_LIST, #TT_COMPOUND.
+    size_t size() const
+    {
+        assert(isString() || isArray() || isContainer());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isString() && !isArray() && !isContainer())
+            throw std::logic_error("Can't get size for non-string, non-array, non-container tag.");
+    #endif
+
+        if (isString())     return !tagData_.str ? 0 : tagData_.str->str.size();
+        if (isByteArray())  return !tagData_.bad ? 0 : tagData_.bad->size();
+        if (isIntArray())   return !tagData_.iad ? 0 : tagData_.iad->size();
+        if (isLongArray())  return !tagData_.lad ? 0 : tagData_.lad->size();
+        if (isList())       return listSize_();
+        if (isCompound())   return !tagData_.cd ? 0 : tagData_.cd->size();
+
+        return 0;
+    }
+
+    /// @brief Check if the string or array or list or compound is empty.
+    /// @attention Only be called via
+    // #TT_STRING, #TT_BYTE_ARRAY, #TT_INT_ARRAY, #TT_LONG_ARRAY, #TT_LIST, #TT_COMPOUND.
+    bool isEmpty() const { return size() == 0; }
+
+    /// @brief Reserve the space of string or array or list or compound.
+    /// @attention Only be called via
+    // #TT_STRING, #TT_BYTE_ARRAY, #TT_INT_ARRAY, #TT_LONG_ARRAY, #TT_LIST, #TT_COMPOUND.
+    void reserve(size_t size)
+    {
+        assert(isString() || isArray() || isContainer());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isString() && !isArray() && !isContainer())
+            throw std::logic_error("Can't reserve space for non-string, non-array, non-container tag.");
+    #endif
+
+        if (isString())
+        {
+            mutableString_().reserve(size);
+        }
+        else if (isByteArray())
+        {
+            if (!tagData_.bad)
+                tagData_.bad = new Vec<Byte>();
+            tagData_.bad->reserve(size);
+        }
+        else if (isIntArray())
+        {
+            if (!tagData_.iad)
+                tagData_.iad = new Vec<Int32>();
+            tagData_.iad->reserve(size);
+        }
+        else if (isLongArray())
+        {
+            if (!tagData_.lad)
+                tagData_.lad = new Vec<Int64>();
+            tagData_.lad->reserve(size);
+        }
+        else if (isPackedList_())
+        {
+            PackedReserver_ reserver{ size };
+            visitPacked_(reserver);
+        }
+        else if (isList())
+        {
+            if (!tagData_.ld)
+                tagData_.ld = new Vec<Tag>();
+            tagData_.ld->reserve(size);
+
+            // The items may be moved.
+            for (auto& var : *tagData_.ld)
+                var.parent_ = this;
+        }
+        else if (isCompound())
+        {
+            if (!tagData_.cd)
+                tagData_.cd = new CompoundData();
+
+            detach_();
+            tagData_.cd->reserve(size);
+
+            // The members may be moved.
+            for (auto& var : tagData_.cd->data)
+                var.parent_ = this;
+        }
+    }
+
+    /// @brief Functions for set value. Only be called via corresponding tag.
+
+    /// @attention Only be called via #TT_BYTE.
+    Tag& setByte(Byte value)
+    {
+        assert(isByte());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isByte())
+            throw std::logic_error("Can't set byte value for non-byte tag.");
+    #endif
+
+        tagData_.num.i8 = value;
+
+        return *this;
+    }
+
+    /// @attention Only be called via #TT_SHORT.
+    Tag& setShort(Int16 value)
+    {
+        assert(isShort());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isShort())
+            throw std::logic_error("Can't set short value for non-short tag.");
+    #endif
+
+        tagData_.num.i16 = value;
+
+        return *this;
+    }
+
+    /// @attention Only be called via #TT_INT.
+    Tag& setInt(Int32 value)
+    {
+        assert(isInt());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isInt())
+            throw std::logic_error("Can't set int value for non-int tag.");
+    #endif
+
+        tagData_.num.i32 = value;
+
+        return *this;
+    }
+
+    /// @attention Only be called via #TT_LONG.
+    Tag& setLong(Int64 value)
+    {
+        assert(isLong());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isLong())
+            throw std::logic_error("Can't set long value for non-long tag.");
+    #endif
+
+        tagData_.num.i64 = value;
+
+        return *this;
+    }
+
+    /// @attention Only be called via #TT_FLOAT.
+    Tag& setFloat(Fp32 value)
+    {
+        assert(isFloat());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isFloat())
+            throw std::logic_error("Can't set float value for non-float tag.");
+    #endif
+
+        tagData_.num.f32 = value;
+
+        return *this;
+    }
+
+    /// @attention Only be called via #TT_DOUBLE.
+    Tag& setDouble(Fp64 value)
+    {
+        assert(isDouble());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isDouble())
+            throw std::logic_error("Can't set double value for non-double tag.");
+    #endif
+
+        tagData_.num.f64 = value;
+
+        return *this;
+    }
+
+    /// @brief Fast way of set the integer value.
+    /// @attention Only be called via #TT_BYTE, #TT_SHORT, #TT_INT, #TT_LONG.
+    Tag& setInteger(Int64 value)
+    {
+        assert(isInteger());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isInteger())
+            throw std::logic_error("Can't set interger number for non-integer tag.");
+    #endif
+
+        if (isByte())           setByte(static_cast<Byte>(value));
+        else if (isShort())     setShort(static_cast<Int16>(value));
+        else if (isInt())       setInt(static_cast<Int32>(value));
+        else if (isLong())      setLong(value);
+
+        return *this;
+    }
+
+    /// @brief Fast way of set the float point value.
+    /// @attention Only be called via #TT_FLOAT, #TT_DOUBLE.
+    Tag& setFloatPoint(Fp64 value)
+    {
+        assert(isFloatPoint());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isFloatPoint())
+            throw std::logic_error("Can't set float point number value for non-float point tag.");
+    #endif
+
+        if (isFloat())
+            setFloat(static_cast<Fp32>(value));
+        else if (isDouble())
+            setDouble(value);
+
+        return *this;
+    }
+
+    /// @attention Only be called via #TT_STRING.
+    Tag& setString(const String& value)
+    {
+        assert(isString());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isString())
+            throw std::logic_error("Can't set string value for non-string tag.");
+    #endif
+
+        if (value.empty() && !tagData_.str)
+            return *this;
+
+        mutableString_() = value;
+
+        return *this;
+    }
+
+    /// @attention Only be called via #TT_BYTE_ARRAY.
+    Tag& setByteArray(const Vec<Byte>& value)
+    {
+        assert(isByteArray());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isByteArray())
+            throw std::logic_error("Can't set Byte array value for non-Byte array tag.");
+    #endif
+
+        if (value.empty() && !tagData_.bad)
+            return *this;
+
+        if (tagData_.bad)
+            *tagData_.bad = value;
+        else
+            tagData_.bad = new Vec<Byte>(value);
+
+        return *this;
+    }
+
+    /// @attention Only be called via #TT_INT_ARRAY.
+    Tag& setIntArray(const Vec<Int32>& value)
+    {
+        assert(isIntArray());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isIntArray())
+            throw std::logic_error("Can't set int array value for non-int array tag.");
+    #endif
+
+        if (value.empty() && !tagData_.iad)
+            return *this;
+
+        if (tagData_.iad)
+            *tagData_.iad = value;
+        else
+            tagData_.iad = new Vec<Int32>(value);
+
+        return *this;
+    }
+
+    /// @attention Only be called via #TT_LONG_ARRAY.
+    Tag& setLongArray(const Vec<Int64>& value)
+    {
+        assert(isLongArray());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isLongArray())
+            throw std::logic_error("Can't set long array value for non-long array tag.");
+    #endif
+
+        if (value.empty() && !tagData_.lad)
+            return *this;
+
+        if (tagData_.lad)
+            *tagData_.lad = value;
+        else
+            tagData_.lad = new Vec<Int64>(value);
+
+        return *this;
+    }
+
+    /// @attention Only be called via #TT_BYTE_ARRAY.
+    Tag& setArray(const Vec<Byte>& value) { return setByteArray(value); }
+
+    /// @overload
+    /// @attention Only be called via #TT_INT_ARRAY.
+    Tag& setArray(const Vec<Int32>& value) { return setIntArray(value); }
+
+    /// @overload
+    /// @attention Only be called via #TT_LONG_ARRAY.
+    Tag& setArray(const Vec<Int64>& value) { return setLongArray(value); }
+
+    /// @brief Add a value to the byte array.
+    /// @attention Only be called via #TT_BYTE_ARRAY.
+    Tag& addByte(Byte value)
+    {
+        assert(isByteArray());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isByteArray())
+            throw std::logic_error("Can't add byte value to non-byte array tag.");
+    #endif
+
+        if (!tagData_.bad)
+            tagData_.bad = new Vec<Byte>();
+        tagData_.bad->emplace_back(value);
+
+        return *this;
+    }
+
+    /// @brief Add a value to the int array.
+    /// @attention Only be called via #TT_INT_ARRAY.
+    Tag& addInt(Int32 value)
+    {
+        assert(isIntArray());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isIntArray())
+            throw std::logic_error("Can't add int value to non-int array tag.");
+    #endif
+
+        if (!tagData_.iad)
+            tagData_.iad = new Vec<Int32>();
+        tagData_.iad->emplace_back(value);
+
+        return *this;
+    }
+
+    /// @brief Add a value to the long array.
+    /// @attention Only be called via #TT_LONG_ARRAY.
+    Tag& addLong(Int64 value)
+    {
+        assert(isLongArray());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isLongArray())
+            throw std::logic_error("Can't add long value to non-long array tag.");
+    #endif
+
+        if (!tagData_.lad)
+            tagData_.lad = new Vec<Int64>();
+        tagData_.lad->emplace_back(value);
+
+        return *this;
+    }
+
+    /// @brief Add a tag to the list or compound.
+    /// @note Original tag will be moved to the new tag whether left-value or right-value reference,
+    // and the original tag will invalid after this operation, but you can call #copy() function to avoid this.
+    /// @attention Only be called via #TT_LIST, #TT_COMPOUND.
+    Tag& addTag(Tag&& tag)
+    {
+        assert(isContainer());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isContainer())
+            throw std::logic_error("Can't add tag to non-container tag.");
+    #endif
+
+        assert(this != &tag);
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (this == &tag)
+            throw std::logic_error("Can't add self to self.");
+    #endif
+
+        assert(!isContained(tag));
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (isContained(tag))
+            throw std::logic_error("Can't add parent to self.");
+    #endif
+
+        // List
+        if (isList())
+        {
+        #ifndef MCNBT_DISABLE_EXCEPTION
+            if (itemType_ == TT_END)
+                throw std::logic_error("Can't read or write a uninitialized list.");
+
+            if (tag.tagType_ != itemType_)
+            {
+                String errmsg = "Can't add the tag of " + getTagTypeString(tag.type());
+                errmsg += " to the list of " + getTagTypeString(itemType_);
+                throw std::logic_error(errmsg);
+            }
+        #endif
+
+            if (isPacked_)
+            {
+                PackedAppender_ appender{ tag.tagData_.num, 1 };
+                visitPacked_(appender);
+
+                return *this;
+            }
+
+            if (!tagData_.ld)
+                tagData_.ld = new Vec<Tag>();
+
+            bool needShuffle = (tagData_.ld->capacity() - tagData_.ld->size()) == 0;
+            tagData_.ld->emplace_back(std::move(tag));
+
+            if (needShuffle)
+            {
+                for (auto& var : *tagData_.ld)
+                    var.parent_ = this;
+            }
+            else
+            {
+                tagData_.ld->back().parent_ = this;
+            }
+
+            if (tagData_.ld->back().tagName_)
+            {
+                _release(tagData_.ld->back().tagName_);
+                tagData_.ld->back().tagName_ = nullptr;
+            }
+        }
+        // Compound
+        else
+        {
+            if (!tagData_.cd)
+                tagData_.cd = new CompoundData();
+
+            detach_();
+
+            if (hasTag(tag.name()))
+            {
+                tagData_.cd->data[tagData_.cd->index().at(tag.name())] = std::move(tag);
+            }
+            else
+            {
+                unshare_();
+
+                bool needShuffle = (tagData_.cd->data.capacity() - tagData_.cd->size()) == 0;
+                tagData_.cd->data.emplace_back(std::move(tag));
+                tagData_.cd->idxs.insert({ tagData_.cd->data.back().name(), tagData_.cd->data.size() - 1 });
+
+                if (needShuffle)
+                {
+                    for (auto& var : tagData_.cd->data)
+                        var.parent_ = this;
+                }
+                else
+                {
+                    tagData_.cd->data.back().parent_ = this;
+                }
+            }
+        }
+
+        return *this;
+    }
+
+    /// @overload
+    Tag& addTag(Tag& tag) { return addTag(std::move(tag)); }
+
+    /// @brief Insert a tag to the list before the item of the index.
+    /// @note Original tag will be moved like #addTag().
+    /// @attention Only be called via #TT_LIST.
+    Tag& insertTag(size_t idx, Tag&& tag)
+    {
+        assert(isList());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isList())
+            throw std::logic_error("Can't insert tag to non-list tag.");
+    #endif
+
+        size_t size = listSize_();
+        if (idx > size)
+            throw std::out_of_range("The specified index is out of range.");
+
+        if (idx == size)
+            return addTag(std::move(tag));
+
+        assert(!isContained(tag));
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (isContained(tag))
+            throw std::logic_error("Can't add parent to self.");
+
+        if (tag.tagType_ != itemType_)
+        {
+            String errmsg = "Can't add the tag of " + getTagTypeString(tag.type());
+            errmsg += " to the list of " + getTagTypeString(itemType_);
+            throw std::logic_error(errmsg);
+        }
+    #endif
+
+        if (isPacked_)
+        {
+            PackedInserter_ inserter{ idx, tag.tagData_.num };
+            visitPacked_(inserter);
+
+            return *this;
+        }
+
+        tagData_.ld->insert(tagData_.ld->begin() + idx, std::move(tag));
+        for (auto& var : *tagData_.ld)
+            var.parent_ = this;
+
+        Tag& item = (*tagData_.ld)[idx];
+        _release(item.tagName_);
+        item.tagName_ = nullptr;
+
+        return *this;
+    }
+
+    /// @overload
+    Tag& insertTag(size_t idx, Tag& tag) { return insertTag(idx, std::move(tag)); }
+
+    /// @brief Functions for get value. Only be called via corresponding tag.
+
+    /// @attention Only be called via #TT_BYTE.
+    Byte getByte() const
+    {
+        assert(isByte());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isByte())
+            throw std::logic_error("Can't get byte value for non-byte tag.");
+    #endif
+
+        return tagData_.num.i8;
+    }
+
+    /// @attention Only be called via #TT_SHORT.
+    Int16 getShort() const
+    {
+        assert(isShort());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isShort())
+            throw std::logic_error("Can't get short value for non-short tag.");
+    #endif
+
+        return tagData_.num.i16;
+    }
+
+    /// @attention Only be called via #TT_INT.
+    Int32 getInt() const
+    {
+        assert(isInt());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isInt())
+            throw std::logic_error("Can't get int value for non-int tag.");
+    #endif
+
+        return tagData_.num.i32;
+    }
+
+    /// @attention Only be called via #TT_LONG.
+    Int64 getLong() const
+    {
+        assert(isLong());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isLong())
+            throw std::logic_error("Can't get long value for non-long tag.");
+    #endif
+
+        return tagData_.num.i64;
+    }
+
+    /// @attention Only be called via #TT_FLOAT.
+    Fp32 getFloat() const
+    {
+        assert(isFloat());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isFloat())
+            throw std::logic_error("Can't get float value for non-float tag.");
+    #endif
+
+        return tagData_.num.f32;
+    }
+
+    /// @attention Only be called via #TT_DOUBLE.
+    Fp64 getDouble() const
+    {
+        assert(isDouble());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isDouble())
+            throw std::logic_error("Can't get double value for non-double tag.");
+    #endif
+
+        return tagData_.num.f64;
+    }
+
+    /// @brief Fast way of get the integer value.
+    /// @attention Only be called via #TT_BYTE, #TT_SHORT, #TT_INT, #TT_LONG.
+    Int64 getInteger() const
+    {
+        assert(isInteger());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isInteger())
+            throw std::logic_error("Can't get interger number for non-integer tag.");
+    #endif
+
+        if (isByte())           return tagData_.num.i8;
+        if (isShort())          return tagData_.num.i16;
+        if (isInt())            return tagData_.num.i32;
+        if (isLong())           return tagData_.num.i64;
+
+        return 0;
+    }
+
+    /// @brief Fast way of get the float point value.
+    /// @attention Only be called via #TT_FLOAT, #TT_DOUBLE.
+    Fp64 getFloatPoint() const
+    {
+        assert(isFloatPoint());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isFloatPoint())
+            throw std::logic_error("Can't get float point number value for non-float point tag.");
+    #endif
+
+        if (isFloat())
+            return tagData_.num.f32;
+        else
+            return tagData_.num.f64;
+
+        return 0;
+    }
+
+    /// @attention Only be called via #TT_STRING.
+    String getString() const
+    {
+        assert(isString());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isString())
+            throw std::logic_error("Can't get string value for non-string tag.");
+    #endif
+
+        return tagData_.str ? tagData_.str->str : "";
+    }
+
+    /// @attention Only be called via #TT_BYTE_ARRAY.
+    Vec<Byte> getByteArray() const
+    {
+        assert(isByteArray());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isByteArray())
+            throw std::logic_error("Can't get byte array value for non-byte array tag.");
+    #endif
+
+        return tagData_.bad ? *tagData_.bad : Vec<Byte>();
+    }
+
+    /// @attention Only be called via #TT_INT_ARRAY.
+    Vec<Int32> getIntArray() const
+    {
+        assert(isIntArray());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isIntArray())
+            throw std::logic_error("Can't get int array value for non-int array tag.");
+    #endif
+
+        return tagData_.iad ? *tagData_.iad : Vec<Int32>();
+    }
+
+    /// @attention Only be called via #TT_LONG_ARRAY.
+    Vec<Int64> getLongArray() const
+    {
+        assert(isLongArray());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isLongArray())
+            throw std::logic_error("Can't get long array value for non-long array tag.");
+    #endif
+
+        return tagData_.lad ? *tagData_.lad : Vec<Int64>();
+    }
+
+    /// @overload
+    /// @brief Get a value from the byte array by index.
+    /// @attention Only be called via #TT_BYTE_ARRAY.
+    Byte getByte(size_t idx) const
+    {
+        assert(isByteArray());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isByteArray())
+            throw std::logic_error("Can't get byte value from non-byte array tag.");
+    #endif
+
+        if (!tagData_.bad || idx >= tagData_.bad->size())
+            throw std::out_of_range("The specified index is out of range.");
+
+        return (*tagData_.bad)[idx];
+    }
+
+    /// @attention Only be called via #TT_BYTE_ARRAY.
+    Byte getFrontByte() const
+    {
+        assert(isByteArray());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isByteArray())
+            throw std::logic_error("Can't get front byte value from non-byte array tag.");
+    #endif
+
+        if (!tagData_.bad || tagData_.bad->empty())
+            throw std::out_of_range("The front member is not exists.");
+
+        return tagData_.bad->front();
+    }
+
+    /// @attention Only be called via #TT_BYTE_ARRAY.
+    Byte getBackByte() const
+    {
+        assert(isByteArray());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isByteArray())
+            throw std::logic_error("Can't get back byte value from non-byte array tag.");
+    #endif
+
+        if (!tagData_.bad || tagData_.bad->empty())
+            throw std::out_of_range("The back member is not exits.");
+
+        return tagData_.bad->back();
+    }
+
+    /// @overload
+    /// @brief Get a value from the int array by index.
+    /// @attention Only be called via #TT_INT_ARRAY.
+    Int32 getInt(size_t idx) const
+    {
+        assert(isIntArray());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isIntArray())
+            throw std::logic_error("Can't get int value from non-int array tag.");
+    #endif
+
+        if (!tagData_.iad || idx >= tagData_.iad->size())
+            throw std::out_of_range("The specified index is out of range.");
+
+        return (*tagData_.iad)[idx];
+    }
+
+    /// @attention Only be called via #TT_INT_ARRAY.
+    Int32 getFrontInt() const
+    {
+        assert(isIntArray());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isIntArray())
+            throw std::logic_error("Can't get front int value from non-int array tag.");
+    #endif
+
+        if (!tagData_.iad || tagData_.iad->empty())
+            throw std::out_of_range("The front member is not exists.");
+
+        return tagData_.iad->front();
+    }
+
+    /// @attention Only be called via #TT_INT_ARRAY.
+    Int32 getBackInt() const
+    {
+        assert(isIntArray());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isIntArray())
+            throw std::logic_error("Can't get back int value from non-int array tag.");
+    #endif
+
+        if (!tagData_.iad || tagData_.iad->empty())
+            throw std::out_of_range("The back member is not exits.");
+
+        return tagData_.iad->back();
+    }
+
+    /// @overload
+    /// @brief Get a value from long array by index.
+    /// @attention Only be called via #TT_LONG_ARRAY.
+    Int64 getLong(size_t idx) const
+    {
+        assert(isLongArray());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isLongArray())
+            throw std::logic_error("Can't get long value from non-long array tag.");
+    #endif
+
+        if (!tagData_.lad || idx >= tagData_.lad->size())
+            throw std::out_of_range("The specified index is out of range.");
+
+        return (*tagData_.lad)[idx];
+    }
+
+    /// @attention Only be called via #TT_LONG_ARRAY.
+    Int64 getFrontLong() const
+    {
+        assert(isLongArray());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isLongArray())
+            throw std::logic_error("Can't get front long value from non-long array tag.");
+    #endif
+
+        if (!tagData_.lad || tagData_.lad->empty())
+            throw std::out_of_range("The front member is not exists.");
+
+        return tagData_.lad->front();
+    }
+
+    /// @attention Only be called via #TT_LONG_ARRAY.
+    Int64 getBackLong() const
+    {
+        assert(isLongArray());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isLongArray())
+            throw std::logic_error("Can't get back long value from non-long array tag.");
+    #endif
+
+        if (!tagData_.lad || tagData_.lad->empty())
+            throw std::out_of_range("The back member is not exits.");
+
+        return tagData_.lad->back();
+    }
+
+    /// @brief Get the tag by index.
+    /// @attention Only be called via #TT_LIST, #TT_COMPOUND.
+    Tag& getTag(size_t idx)
+    {
+        unpack_();
+        detach_();
+        expose_();
+
+        return const_cast<Tag&>(static_cast<const Tag*>(this)->getTag(idx));
+    }
+
+    /// @overload
+    /// @note The shared compound is not copied by the const functions, so its members have no parent.
+    /// @note The items of the list of numbers are made as tags on demand, use #listData() for bulk read instead.
+    const Tag& getTag(size_t idx) const
+    {
+        assert(isContainer());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isContainer())
+            throw std::logic_error("Can't get tag from non-container tag.");
+    #endif
+
+        // List
+        if (isList())
+        {
+        #ifndef MCNBT_DISABLE_EXCEPTION
+            if (itemType_ == TT_END)
+                throw std::logic_error("Can't read or write a uninitialized list.");
+        #endif
+
+            if (isPacked_)
+            {
+                if (idx >= listSize_())
+                    throw std::out_of_range("The specified index is out of range.");
+
+                return packedItem_(idx);
+            }
+
+            if (!tagData_.ld || idx >= tagData_.ld->size())
+                throw std::out_of_range("The specified index is out of range.");
+
+            return (*tagData_.ld)[idx];
+        }
+        // Compound
+        else
+        {
+            if (!tagData_.cd || idx >= tagData_.cd->size())
+                throw std::out_of_range("The specified index is out of range.");
+
+            return tagData_.cd->data[idx];
+        }
+    }
+
+    /// @overload
+    /// @brief Get the tag by name.
+    /// @attention Only be called via #TT_COMPOUND.
+    Tag& getTag(const String& name)
+    {
+        detach_();
+        expose_();
+
+        return const_cast<Tag&>(static_cast<const Tag*>(this)->getTag(name));
+    }
+
+    /// @overload
+    const Tag& getTag(const String& name) const
+    {
+        assert(isCompound());
+        assert(hasTag(name));
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isCompound())
+            throw std::logic_error("Can't get tag from non-compound tag.");
+
+        if (!hasTag(name))
+            throw std::logic_error("The specified name is not exists.");
+
+        if (!tagData_.cd)
+            throw std::logic_error("The member of specified name is not exists.");
+    #endif
+
+        const auto& idxs = tagData_.cd->index();
+        auto it = idxs.find(name);
+
+        return tagData_.cd->data[it != idxs.end() ? it->second : 0];
+    }
+
+    /// @attention Only be called via #TT_LIST, #TT_COMPOUND.
+    Tag& getFrontTag()
+    {
+        unpack_();
+        detach_();
+        expose_();
+
+        return const_cast<Tag&>(static_cast<const Tag*>(this)->getFrontTag());
+    }
+
+    /// @overload
+    /// @note The items of the list of numbers are made as tags on demand, use #listData() for bulk read instead.
+    const Tag& getFrontTag() const
+    {
+        assert(isContainer());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isContainer())
+            throw std::logic_error("Can't get front tag from non-container tag.");
+    #endif
+
+        // List
+        if (isList())
+        {
+        #ifndef MCNBT_DISABLE_EXCEPTION
+            if (itemType_ == TT_END)
+                throw std::logic_error("Can't read or write a uninitialized list.");
+        #endif
+
+            if (isPacked_)
+            {
+                if (listSize_() == 0)
+                    throw std::out_of_range("The front member is not exists.");
+
+                return packedItem_(0);
+            }
+
+            if (!tagData_.ld || tagData_.ld->empty())
+                throw std::out_of_range("The front member is not exists.");
+
+            return tagData_.ld->front();
+        }
+        // Compound
+        else
+        {
+            if (!tagData_.cd || tagData_.cd->empty())
+                throw std::out_of_range("The front member is not exists.");
+
+            return tagData_.cd->data.front();
+        }
+    }
+
+    /// @attention Only be called via #TT_LIST, #TT_COMPOUND.
+    Tag& getBackTag()
+    {
+        unpack_();
+        detach_();
+        expose_();
+
+        return const_cast<Tag&>(static_cast<const Tag*>(this)->getBackTag());
+    }
+
+    /// @overload
+    /// @note The items of the list of numbers are made as tags on demand, use #listData() for bulk read instead.
+    const Tag& getBackTag() const
+    {
+        assert(isContainer());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isContainer())
+            throw std::logic_error("Can't get back tag from non-container tag.");
+    #endif
+
+        // List
+        if (isList())
+        {
+        #ifndef MCNBT_DISABLE_EXCEPTION
+            if (itemType_ == TT_END)
+                throw std::logic_error("Can't read or write a uninitialized list.");
+        #endif
+
+            if (isPacked_)
+            {
+                size_t size = listSize_();
+                if (size == 0)
+                    throw std::out_of_range("The back member is not exists.");
+
+                return packedItem_(size - 1);
+            }
+
+            if (!tagData_.ld || tagData_.ld->empty())
+                throw std::out_of_range("The back member is not exists.");
+
+            return tagData_.ld->back();
+        }
+        // Compound
+        else
+        {
+            if (!tagData_.cd || tagData_.cd->empty())
+                throw std::out_of_range("The back member is not exists.");
+
+            return tagData_.cd->data.back();
+        }
+    }
+
+    /// @brief Remove the element by index.
+    /// @attention Only be called via
+    // #TT_STRING, #TT_BYTE_ARRAY, #TT_INT_ARRAY, #TT_LONG_ARRAY, #TT_LIST, #TT_COMPOUND.
+    Tag& remove(size_t idx)
+    {
+        assert(isString() || isArray() || isContainer());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isString() && !isArray() && !isContainer())
+            throw std::logic_error("Can't remove element from non-string, non-array, non-container tag.");
+    #endif
+
+        if (isString())
+        {
+            if (!tagData_.str || idx >= tagData_.str->str.size())
+                throw std::out_of_range("The specified index is out of range.");
+
+            mutableString_().erase(idx, 1);
+        }
+        else if (isByteArray())
+        {
+            if (!tagData_.bad || idx >= tagData_.bad->size())
+                throw std::out_of_range("The specified index is out of range.");
+
+            tagData_.bad->erase(tagData_.bad->begin() + idx);
+        }
+        else if (isIntArray())
+        {
+            if (!tagData_.iad || idx >= tagData_.iad->size())
+                throw std::out_of_range("The specified index is out of range.");
+
+            tagData_.iad->erase(tagData_.iad->begin() + idx);
+        }
+        else if (isLongArray())
+        {
+            if (!tagData_.lad || idx >= tagData_.lad->size())
+                throw std::out_of_range("The specified index is out of range.");
+
+            tagData_.lad->erase(tagData_.lad->begin() + idx);
+        }
+        else if (isList())
+        {
+        #ifndef MCNBT_DISABLE_EXCEPTION
+            if (itemType_ == TT_END)
+                throw std::logic_error("Can't read or write a uninitialized list.");
+        #endif
+
+            if (idx >= listSize_())
+                throw std::out_of_range("The specified index is out of range.");
+
+            if (isPacked_)
+            {
+                PackedEraser_ eraser{ idx, idx + 1 };
+                visitPacked_(eraser);
+            }
+            else
+            {
+                tagData_.ld->erase(tagData_.ld->begin() + idx);
+            }
+        }
+        else if (isCompound())
+        {
+            if (!tagData_.cd || idx >= tagData_.cd->size())
+                throw std::out_of_range("The specified index is out of range.");
+
+            detach_();
+            unshare_();
+            tagData_.cd->idxs.erase(tagData_.cd->data[idx].name());
+            tagData_.cd->data.erase(tagData_.cd->data.begin() + idx);
+
+            for (auto& var : tagData_.cd->idxs)
+                if (var.second > idx)
+                    var.second--;
+        }
+
+        return *this;
+    }
+
+    /// @overload
+    /// @brief Remove the tag by name.
+    /// @attention Only be called via #TT_COMPOUND.
+    Tag& remove(const String& name)
+    {
+        assert(isCompound());
+        assert(hasTag(name));
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isCompound())
+            throw std::logic_error("Can't remove tag from non-compound tag.");
+
+        if (!hasTag(name))
+            throw std::logic_error("The specified name is not exists.");
+
+        if (!tagData_.cd)
+            throw std::logic_error("The member of specified name is not exists.");
+    #endif
+
+        detach_();
+        unshare_();
+        size_t idx = tagData_.cd->idxs[name];
+
+        tagData_.cd->data.erase(tagData_.cd->data.begin() + idx);
+        tagData_.cd->idxs.erase(name);
+
+        for (auto& var : tagData_.cd->idxs)
+        {
+            if (var.second > idx)
+            var.second--;
+        }
+
+        return *this;
+    }
+
+    /// @brief Remove the first element.
+    /// @attention Only be called via
+    // #TT_STRING, #TT_BYTE_ARRAY, #TT_INT_ARRAY, #TT_LONG_ARRAY, #TT_LIST, #TT_COMPOUND.
+    Tag& removeFront()
+    {
+        assert(isString() || isArray() || isContainer());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isString() && !isArray() && !isContainer())
+            throw std::logic_error("Can't remove front element from non-string, non-array, non-container tag.");
+    #endif
+
+        if (isString())
+        {
+            if (!tagData_.str || tagData_.str->str.empty())
+                throw std::out_of_range("The front member is not exists.");
+
+            mutableString_().erase(0, 1);
+        }
+        else if (isByteArray())
+        {
+            if (!tagData_.bad || tagData_.bad->empty())
+                throw std::out_of_range("The front member is not exists.");
+
+            tagData_.bad->erase(tagData_.bad->begin());
+        }
+        else if (isIntArray())
+        {
+            if (!tagData_.iad || tagData_.iad->empty())
+                throw std::out_of_range("The front member is not exists.");
+
+            tagData_.iad->erase(tagData_.iad->begin());
+        }
+        else if (isLongArray())
+        {
+            if (!tagData_.lad || tagData_.lad->empty())
+                throw std::out_of_range("The front member is not exists.");
+
+            tagData_.lad->erase(tagData_.lad->begin());
+        }
+        else if (isList())
+        {
+        #ifndef MCNBT_DISABLE_EXCEPTION
+            if (itemType_ == TT_END)
+                throw std::logic_error("Can't read or write a uninitialized list.");
+        #endif
+
+            if (listSize_() == 0)
+                throw std::out_of_range("The front member is not exists.");
+
+            if (isPacked_)
+            {
+                PackedEraser_ eraser{ 0, 1 };
+                visitPacked_(eraser);
+            }
+            else
+            {
+                tagData_.ld->erase(tagData_.ld->begin());
+            }
+        }
+        else if (isCompound())
+        {
+            if (!tagData_.cd || tagData_.cd->empty())
+                throw std::out_of_range("The front member is not exists.");
+
+            detach_();
+            unshare_();
+            tagData_.cd->idxs.erase(tagData_.cd->data.front().name());
+            tagData_.cd->data.erase(tagData_.cd->data.begin());
+
+            for (auto& var : tagData_.cd->idxs)
+                var.second--;
+        }
+
+        return *this;
+    }
+
+    /// @brief Remove the last element.
+    /// @attention Only be called via
+    // #TT_STRING, #TT_BYTE_ARRAY, #TT_INT_ARRAY, #TT_LONG_ARRAY, #TT_LIST, #TT_COMPOUND.
+    Tag& removeBack()
+    {
+        assert(isString() || isArray() || isContainer());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isString() && !isArray() && !isContainer())
+            throw std::logic_error("Can't remove back element from non-string, non-array, non-container tag.");
+    #endif
+
+        if (isString())
+        {
+            if (!tagData_.str || tagData_.str->str.empty())
+                throw std::out_of_range("The back member is not exists.");
+
+            mutableString_().pop_back();
+        }
+        else if (isByteArray())
+        {
+            if (!tagData_.bad || tagData_.bad->empty())
+                throw std::out_of_range("The back member is not exists.");
+
+            tagData_.bad->pop_back();
+        }
+        else if (isIntArray())
+        {
+            if (!tagData_.iad || tagData_.iad->empty())
+                throw std::out_of_range("The back member is not exists.");
+
+            tagData_.iad->pop_back();
+        }
+        else if (isLongArray())
+        {
+            if (!tagData_.lad || tagData_.lad->empty())
+                throw std::out_of_range("The back member is not exists.");
+
+            tagData_.lad->pop_back();
+        }
+        else if (isList())
+        {
+        #ifndef MCNBT_DISABLE_EXCEPTION
+            if (itemType_ == TT_END)
+                throw std::logic_error("Can't read or write a uninitialized list.");
+        #endif
+
+            size_t size = listSize_();
+            if (size == 0)
+                throw std::out_of_range("The back member is not exists.");
+
+            if (isPacked_)
+            {
+                PackedEraser_ eraser{ size - 1, size };
+                visitPacked_(eraser);
+            }
+            else
+            {
+                tagData_.ld->pop_back();
+            }
+        }
+        else if (isCompound())
+        {
+            if (!tagData_.cd || tagData_.cd->empty())
+                throw std::out_of_range("The back member is not exists.");
+
+            detach_();
+            unshare_();
+            tagData_.cd->idxs.erase(tagData_.cd->data.back().name());
+            tagData_.cd->data.pop_back();
+        }
+
+        return *this;
+    }
+
+    /// @brief Remove the all elements.
+    /// @attention Only be called via
+    // #TT_STRING, #TT_BYTE_ARRAY, #TT_INT_ARRAY, #TT_LONG_ARRAY, #TT_LIST, #TT_COMPOUND.
+    Tag& removeAll()
+    {
+        assert(isString() || isArray() || isContainer());
+    #ifndef MCNBT_DISABLE_EXCEPTION
+        if (!isString() && !isArray() && !isContainer())
+            throw std::logic_error("Can't remove all elements from non-string, non-array, non-container tag.");
+    #endif
+
+        if (isString())
+        {
+            if (tagData_.str)
+                mutableString_().clear();
+        }
+        else if (isByteArray())
+        {
+            if (tagData_.bad)
+                tagData_.bad->clear();
+        }
+        else if (isIntArray())
+        {
+            if (tagData_.iad)
+                tagData_.iad->clear();
+        }
+        else if (isLongArray())
+        {
+            if (tagData_.lad)
+                tagData_.lad->clear();
+        }
+        else if (isList())
+        {
+        #ifndef MCNBT_DISABLE_EXCEPTION
+            if (itemType_ == TT_END)
+                throw std::logic_error("Can't read or write a uninitialized list.");
+        #endif
+
+            size_t size = listSize_();
+
+            if (isPacked_)
+            {
+                PackedEraser_ eraser{ 0, size };
+                visitPacked_(eraser);
+            }
+            else if (tagData_.ld)
+            {
+                tagData_.ld->clear();
+            }
+        }
+        else if (isCompound())
+        {
+            if (tagData_.cd && !_isUnique(tagData_.cd->refs))
+                releaseCompound_();
+            else if (tagData_.cd)
+                tagData_.cd->clear();
+        }
+
+        return *this;
+    }
+
+    /// @brief Make the compounds of same keys in the lists (recursively) share the keys,
+    // to save the memory of lots of same names and maps.
+    /// @note The lists of compounds read from binary share the keys already.
+    // The compound has its own keys again once its keys are changed.
+    Tag& shareShapes()
+    {
+        if (isList() && !isPacked_ && tagData_.ld)
+        {
+            std::shared_ptr<const Shape> shape;
+            for (auto& var : *tagData_.ld)
+            {
+                var.shareShapes();
+
+                if (!var.isCompound() || !var.tagData_.cd || var.tagData_.cd->empty())
+                    continue;
+
+                if (var.tagData_.cd->shape)
+                {
+                    if (!shape)
+                        shape = var.tagData_.cd->shape;
+                    else if (var.tagData_.cd->shape != shape && var.isSameShape_(*shape))
+                        var.tagData_.cd->shape = shape;
+                }
+                else if (!shape)
+                {
+                    if (tagData_.ld->size() > 1)
+                        shape = var.makeShape_();
+                }
+                else if (var.isSameShape_(*shape))
+                {
+                    var.share_(shape);
+                }
+            }
+        }
+        else if (isCompound() && tagData_.cd)
+        {
+            detach_();
+            for (auto& var : tagData_.cd->data)
+                var.shareShapes();
+        }
+
+        return *this;
+    }
+
+    /// @brief Sort the members of compounds by their names and make the empty lists have item type #TT_END
+    // (as read from binary) recursively, so that the same data has same binary and SNBT however it is built.
+    /// @note The names are compared by bytes. The binary written after it is same as the canonical write.
+    // (See #FileWriteOptions::isCanonical)
+    // The compounds which share the keys share the sorted keys after it. (See #shareShapes())
+    Tag& canonicalize()
+    {
+        std::shared_ptr<const Shape> from;
+        std::shared_ptr<const Shape> to;
+        canonicalize_(from, to);
+
+        return *this;
+    }
+
+    /// @brief Intern the names and string values of the tag and its children (recursively) to the pool,
+    // so that the same strings of constructed tags are stored once. (See #StringPool)
+    /// @note The tags read from binary are interned already.
+    Tag& intern(StringPool& pool)
+    {
+        if (tagName_)
+            intern_(tagName_, pool);
+
+        if (isString() && tagData_.str)
+        {
+            intern_(tagData_.str, pool);
+        }
+        else if (isList() && !isPacked_ && tagData_.ld)
+        {
+            for (auto& var : *tagData_.ld)
+                var.intern(pool);
+        }
+        else if (isCompound() && tagData_.cd)
+        {
+            detach_();
+            for (auto& var : tagData_.cd->data)
+                var.intern(pool);
+        }
+
+        return *this;
+    }
+
+#ifdef MCNBT_ENABLE_GZIP
+    /// @brief Write the tag to output stream.
+    void write(OStream& os, Encoding enc, bool isCompressed = false) const
+    {
+        MCNBT_STATS(_StatsScope scope(SK_WRITE);)
+
+        StreamSink sink(os);
+
+        if (isCompressed)
+        {
+            gzip::CompressSink<StreamSink> csink(sink);
+            writeRoot_(csink, enc, false);
+            csink.finish();
+        }
+        else
+        {
+            writeRoot_(sink, enc, false);
+        }
+    }
+
+    /// @overload
+    void write(OStream& os, bool isBigEndian, bool isCompressed = false) const
+    {
+        write(os, getEncoding(isBigEndian), isCompressed);
+    }
+
+    /// @overload
+    void write(const String& filename, Encoding enc, bool isCompressed = false,
+               const FileWriteOptions& options = FileWriteOptions()) const
+    {
+        writeFile_(filename, enc, isCompressed, options);
+    }
+
+    /// @overload
+    void write(const String& filename, bool isBigEndian, bool isCompressed = false) const
+    {
+        write(filename, getEncoding(isBigEndian), isCompressed);
+    }
+#else
+    /// @brief Write the tag to output stream.
+    void write(OStream& os, Encoding enc) const
+    {
+        MCNBT_STATS(_StatsScope scope(SK_WRITE);)
+
+        StreamSink sink(os);
+        MCNBT_STATS(_StatsBytes<StreamSink> bytes(sink);)
+
+        write_(sink, enc, isListItem());
+    }
+
+    /// @overload
+    void write(OStream& os, bool isBigEndian) const { write(os, getEncoding(isBigEndian)); }
+
+    /// @overload
+    void write(const String& filename, Encoding enc, const FileWriteOptions& options = FileWriteOptions()) const
+    {
+        writeFile_(filename, enc, false, options);
+    }
+
+    /// @overload
+    void write(const String& filename, bool isBigEndian) const { write(filename, getEncoding(isBigEndian)); }
+#endif // MCNBT_ENABLE_GZIP
+
+    /// @brief Write the tag to any sink.
+    /// @param sink The sink, e.g. #BufferSink, #VecSink, #StreamSink, #FileSink or gzip::CompressSink.
+    // See the comment about the sink before #_readBytes().
+    /// @param isCanonical If true, write the members of compounds in the order of names, the tag is not changed.
+    // (See #canonicalize())
+    template <typename Sink>
+    void writeToSink(Sink& sink, Encoding enc, bool isCanonical = false) const { writeRoot_(sink, enc, isCanonical); }
+
+    /// @brief Get the exact size of the binary data of the tag, without serialize it.
+    size_t binarySize(Encoding enc) const { return binarySize_(enc, isListItem()); }
+
+    /// @overload
+    size_t binarySize(bool isBigEndian) const { return binarySize(getEncoding(isBigEndian)); }
+
+    /// @brief Get the estimated memory used by the tag and its children. (See #MemoryUsage)
+    MemoryUsage memoryUsage() const
+    {
+        MemoryCounter_ counter;
+        counter.usage.nodeBytes += sizeof(Tag);
+        counter.count(*this);
+
+        return counter.usage;
+    }
+
+    /// @brief Write the tag to contiguous memory directly.
+    /// @param capacity The size of the memory, throw if it is less than #binarySize().
+    /// @param isCanonical If true, write the members of compounds in the order of names. (See #writeToSink())
+    /// @return The count of written bytes.
+    size_t writeTo(char* dst, size_t capacity, Encoding enc, bool isCanonical = false) const
+    {
+        size_t size = binarySize(enc);
+        if (size > capacity)
+            throw std::runtime_error("The capacity of buffer is not enough to write the tag.");
+
+        BufferSink sink(dst);
+        writeRoot_(sink, enc, isCanonical);
+
+        return sink.pos();
+    }
+
+    /// @overload
+    /// @brief Append the binary data of the tag to the vector, with only one allocation.
+    size_t writeTo(Vec<Byte>& dst, Encoding enc, bool isCanonical = false) const
+    {
+        size_t pos = dst.size();
+        dst.resize(pos + binarySize(enc));
+
+        BufferSink sink(dst.data() + pos);
+        writeRoot_(sink, enc, isCanonical);
+
+        return sink.pos();
+    }
+
+    /// @overload
+    /// @brief Append the binary data of the tag to the string, with only one allocation.
+    size_t writeTo(String& dst, Encoding enc, bool isCanonical = false) const
+    {
+        size_t pos = dst.size();
+        dst.resize(pos + binarySize(enc));
+
+        BufferSink sink(&dst[0] + pos);
+        writeRoot_(sink, enc, isCanonical);
+
+        return sink.pos();
+    }
+
+    /// @brief Get the SNBT (The string representation of NBT).
+    /// @param isWrappedIndented If true, the output string will be wrapped and indented.
+    String toSnbt(bool isWrappedIndented = true) const { return toSnbt_(isWrappedIndented, isListItem()); }
+
+    /// @brief Operators overloading.
+
+    /// @brief Fast way of get the tag by index.
+    Tag& operator[](size_t idx)                         { return getTag(idx); }
+
+    /// @overload
+    const Tag& operator[](size_t idx) const             { return getTag(idx); }
+
+    /// @overload
+    /// @brief Fast way of get the tag by name.
+    Tag& operator[](const String& name)                 { return getTag(name); }
+
+    /// @overload
+    const Tag& operator[](const String& name) const     { return getTag(name); }
+
+    /// @brief Fast way of add the tag.
+    Tag& operator<<(Tag&& tag)              { return addTag(std::move(tag)); }
+
+    /// @overload
+    Tag& operator<<(Tag& tag)               { return addTag(tag); }
+
+    /// @brief Check if equal to the other, be equal to equals().
+    bool operator==(const Tag& other) const { return equals(other); }
+
+    bool operator!=(const Tag& other) const { return !equals(other); }
+
+private:
+    // Nums.
+    // Contains interger and float point number.
+    union Num
+    {
+        Num() : i64(0) {}
+
+        Byte    i8;
+        Int16   i16;
+        Int32   i32;
+        Int64   i64;
+        Fp32    f32;
+        Fp64    f64;
+    };
+
+    // The keys of compound in order, be shared by the compounds of same keys. (e.g. the items of list)
+    struct Shape
+    {
+        Shape() = default;
+
+        ~Shape()
+        {
+            for (auto var : keys)
+                _release(var);
+        }
+
+        Shape(const Shape&) = delete;
+        Shape& operator=(const Shape&) = delete;
+
+        Vec<_SharedString*> keys;   ///< The null key is empty name.
+        Map<String, size_t> idxs;
+        Vec<size_t> order;          ///< The indexes of keys in the order of names. (See #sortedOrder_())
+    };
+
+    // The bytes read, which are shared by the compounds read from them. (See #ReadOptions::isSpanKept)
+    struct Encoded_
+    {
+        Vec<Byte> data;
+        Encoding enc;
+    };
+
+    // A simple wrapper of std::vector<tag> and std::map<string, size_t>.
+    // If the shape is set, the keys are stored in the shape instead of #idxs and the names of members,
+    // and any change of the keys make the compound have its own keys again. (See #unshare_())
+    // The data can be shared by several tags with reference count (e.g. the copies of tag, the identical
+    // compounds read with #ReadOptions::isDedup), the members of shared data have own names and no parent,
+    // and the tag copies the data before any change. (See #detach_())
+    // The data which the non-const references of the members are got from is never shared. (See #expose_())
+    struct CompoundData
+    {
+        Vec<Tag> data;
+        Map<String, size_t> idxs;
+        std::shared_ptr<const Shape> shape;
+        _RefCount refs{ 1 };
+        bool isExposed = false;                 ///< Whether the non-const references of the members may be held.
+        mutable std::atomic<UInt64> hash{ 0 };  ///< The cached hash, only valid while the data is shared.
+        std::shared_ptr<const Encoded_> encoded;    ///< The bytes which the compound is read from, null once
+                                                    // the compound is accessed as non-const.
+        const char* span    = nullptr;              ///< The encoded members and End tag in #encoded.
+        size_t spanSize     = 0;
+
+        /// @brief Check if the members can be written by copy the bytes read.
+        bool hasSpan(Encoding enc) const { return encoded && encoded->enc == enc; }
+
+        bool empty() const          { return data.empty(); }
+
+        size_t size() const         { return data.size(); }
+
+        void reserve(size_t size)
+        {
+            data.reserve(size);
+            if (!shape)
+                idxs.reserve(size);
+        }
+
+        void clear()                { data.clear(); idxs.clear(); shape.reset(); }
+
+        /// @brief Get the map of name to index.
+        const Map<String, size_t>& index() const { return shape ? shape->idxs : idxs; }
+    };
+
+    // Value of tag.
+    // Individual tag is like key-value pair.
+    // The key is the name of tag (can be empty. e.g. All list element not has name).
+    // The value is stored in the following union.
+    union Data
+    {
+        Data() : num(Num()) {}
+
+        // Number data
+        Num             num;
+        // String data
+        _SharedString*  str;
+        // Byte Array data
+        Vec<Byte>*      bad;
+        // Int Array data
+        Vec<Int32>*     iad;
+        // Long Array data
+        Vec<Int64>*     lad;
+        // Packed data of the list of short, float and double.
+        // (The list of byte, int and long use the #bad, #iad and #lad)
+        Vec<Int16>*     sad;
+        Vec<Fp32>*      fad;
+        Vec<Fp64>*      dad;
+        // List data
+        Vec<Tag>*       ld;
+        // Compound data
+        CompoundData*   cd;
+    };
+
+    // The context of read the tag from binary.
+    struct ReadContext_
+    {
+        explicit ReadContext_(const ReadOptions& options)
+            : pool(options.pool ? *options.pool : ownPool), isDedup(options.isDedup) {}
+
+        ~ReadContext_()
+        {
+            for (auto& var : compounds)
+                releaseCompound_(var.second);
+
+            MCNBT_STATS(if (_currentStats()) *_currentStats() += stats;)
+        }
+
+        ReadContext_(const ReadContext_&) = delete;
+        ReadContext_& operator=(const ReadContext_&) = delete;
+
+        /// @brief Share the identical compound read before instead of the compound of the tag,
+        /// or record the compound if no identical one.
+        void dedup(Tag& tag, UInt64 hash)
+        {
+            CompoundData* cd = tag.tagData_.cd;
+            if (!cd)
+                return;
+
+            auto range = compounds.equal_range(hash);
+            for (auto it = range.first; it != range.second; ++it)
+            {
+                if (isSameCompound_(*it->second, *cd))
+                {
+                    tag.releaseCompound_();
+                    tag.tagData_.cd = retainCompound_(it->second);
+                    return;
+                }
+            }
+
+            // The record is not an owner, so the members keep the parent.
+            _addRef(cd->refs);
+            compounds.insert({ hash, cd });
+        }
+
+    #ifdef MCNBT_ENABLE_STATS
+        /// @brief Count the tags of the type read at the depth.
+        void count(TagType type, size_t depth, UInt64 n = 1)
+        {
+            stats.tags[type] += n;
+            if (depth > stats.maxDepth)
+                stats.maxDepth = depth;
+        }
+
+        CodecStats stats;   ///< The counts of the tags read, added to the current document at the end.
+    #endif // MCNBT_ENABLE_STATS
+
+        StringPool ownPool;
+        StringPool& pool;
+        bool isDedup;
+        std::shared_ptr<const Encoded_> encoded;    ///< The bytes read if keep the spans of compounds.
+        std::unordered_multimap<UInt64, CompoundData*> compounds;   ///< The compounds read, by the hash.
+    };
+
+    static bool isCompressed_(const char* data, size_t size)
+    {
+    #ifdef MCNBT_ENABLE_GZIP
+        return gzip::isCompressed(data, size);
+    #else
+        (void) data;
+        (void) size;
+        return false;
+    #endif // MCNBT_ENABLE_GZIP
+    }
+
+    // The handlers of the binary source, the source is uncompressed and at the begin of root tag.
+    // (See #handleRawSource_())
+
+    struct TagReader_
+    {
+        using Result = Tag;
+
+        const ReadOptions& options;
+
+        template <typename Source>
+        Tag operator()(Source& src, Encoding enc) const
+        {
+            MCNBT_STATS(_StatsScope scope(SK_READ);)
+            MCNBT_STATS(_StatsBytes<Source> bytes(src);)
+
+            ReadContext_ ctx(options);
+
+            if (!options.isSpanKept)
+                return fromSource_(src, enc, ctx);
+
+            std::shared_ptr<Encoded_> encoded = std::make_shared<Encoded_>();
+            encoded->enc = enc;
+            _readRemain(src, encoded->data);
+            ctx.encoded = encoded;
+
+            BufferSource bsrc(encoded->data.data(), encoded->data.size());
+            Tag tag = fromSource_(bsrc, enc, ctx);
+
+            // The bytes are read by chunks and may be followed by other data,
+            // so keep only the bytes of the tag instead of the whole buffer.
+            if (encoded->data.capacity() > bsrc.pos())
+            {
+                std::shared_ptr<Encoded_> trimmed = std::make_shared<Encoded_>();
+                trimmed->enc = enc;
+                trimmed->data.assign(encoded->data.begin(), encoded->data.begin() + bsrc.pos());
+                rebaseSpans_(tag, encoded.get(), trimmed);
+            }
+
+            return tag;
+        }
+    };
+
+    struct FingerprintReader_
+    {
+        using Result = UInt64;
+
+        bool isKeyOrderIgnored;
+
+        template <typename Source>
+        UInt64 operator()(Source& src, Encoding enc) const
+        {
+            Fingerprinter_<Source> fingerprinter(src, enc, isKeyOrderIgnored);
+
+            return fingerprinter.root();
+        }
+    };
+
+    /// @brief Handle the binary from input stream. (See #fromBinStream())
+    template <typename Handler>
+    static typename Handler::Result handleStream_(IStream& is, Encoding enc, size_t headerSize,
+                                                  const Handler& handler)
+    {
+        StreamSource src(is);
+        bool isCompressed = isCompressed_(src.data(), src.prefetch(2));
+
+        return handleRawSource_(src, isCompressed, enc, headerSize, handler);
+    }
+
+    /// @brief Handle the binary from file. (See #fromFile())
+    template <typename Handler>
+    static typename Handler::Result handleFile_(const String& filename, Encoding enc, size_t headerSize,
+                                                const Handler& handler)
+    {
+        _File file(filename);
+
+        Int64 size = file.size();
+        if (size < 0)
+        {
+            FileSource src(file.fd());
+            bool isCompressed = isCompressed_(src.data(), src.prefetch(2));
+
+            return handleRawSource_(src, isCompressed, enc, headerSize, handler);
+        }
+
+        if (static_cast<UInt64>(size) > static_cast<UInt64>(SIZE_MAX))
+            throw std::runtime_error("The file is too large: " + filename);
+
+        _FileContent content(file, static_cast<size_t>(size));
+        BufferSource src(content.data(), content.size());
+
+        return handleRawSource_(src, isCompressed_(content.data(), content.size()), enc, headerSize, handler);
+    }
+
+    /// @brief Handle the binary from the source of the raw content of stream or file.
+    /// @param isCompressed     Whether the content is compressed, it is decompressed while reading if true.
+    /// @param headerSize       The size of need discard data from begin of the (decompressed) content.
+    template <typename Handler, typename Source>
+    static typename Handler::Result handleRawSource_(Source& src, bool isCompressed, Encoding enc,
+                                                     size_t headerSize, const Handler& handler)
+    {
+    #ifdef MCNBT_ENABLE_GZIP
+        if (isCompressed)
+        {
+            gzip::DecompressSource<Source> dsrc(src);
+            dsrc.skip(headerSize);
+
+            return handler(dsrc, enc);
+        }
+    #else
+        (void) isCompressed;
+    #endif // MCNBT_ENABLE_GZIP
+
+        src.skip(headerSize);
+
+        return handler(src, enc);
+    }
+
+    // Compute the fingerprint while reading the binary, without construct the tags. (See #fingerprintSource())
+    // The hashes of values are combined like #hashValue_(), but the numbers of arrays and lists are hashed as
+    // little endian, so that the fingerprint is same on all platforms.
+    template <typename Source>
+    class Fingerprinter_
+    {
+    public:
+        Fingerprinter_(Source& src, Encoding enc, bool isKeyOrderIgnored)
+            : src_(src), enc_(enc), isKeyOrderIgnored_(isKeyOrderIgnored) {}
+
+        /// @brief Get the fingerprint of the root tag, include its name.
+        UInt64 root()
+        {
+            int type = src_.get();
+            if (type == std::char_traits<char>::eof())
+                throw std::runtime_error("Unexpected end of data.");
+
+            if (type == TT_END)
+                return TT_END;
+
+            UInt64 name = string_();
+
+            return _hashMix(name, value_(static_cast<TagType>(type), 0));
+        }
+
+    private:
+        /// @brief Read a string and get its hash, 0 if it is empty.
+        UInt64 string_()
+        {
+            _readString(src_, enc_, str_);
+
+            return str_.empty() ? 0 : _hashBytes(str_.data(), str_.size());
+        }
+
+        UInt64 value_(TagType type, size_t depth)
+        {
+            if (depth > _MAX_NESTING_DEPTH)
+                throw std::runtime_error("The nesting depth of tag is too deep.");
+
+            bool isBigEndian = enc_ == EC_BIG_ENDIAN;
+            switch (type)
+            {
+                case TT_BYTE:       return _hashMix(type, static_cast<UChar>(_readNum<Byte>(src_, false)));
+                case TT_SHORT:      return _hashMix(type, _readNum<UInt16>(src_, isBigEndian));
+                case TT_INT:        return _hashMix(type, static_cast<UInt32>(_readInt32(src_, enc_)));
+                case TT_LONG:       return _hashMix(type, static_cast<UInt64>(_readInt64(src_, enc_)));
+                case TT_FLOAT:      return _hashMix(type, _readNum<UInt32>(src_, isBigEndian));
+                case TT_DOUBLE:     return _hashMix(type, _readNum<UInt64>(src_, isBigEndian));
+                case TT_STRING:     return _hashMix(type, string_());
+                case TT_BYTE_ARRAY: return numbers_<Byte>(type, _readSize(src_, enc_));
+                case TT_INT_ARRAY:  return numbers_<Int32>(type, _readSize(src_, enc_));
+                case TT_LONG_ARRAY: return numbers_<Int64>(type, _readSize(src_, enc_));
+                case TT_LIST:
+                {
+                    TagType itemType = static_cast<TagType>(_readNum<Byte>(src_, false));
+                    size_t size = _readSize(src_, enc_);
+
+                    UInt64 hash = _hashMix(type, itemType);
+                    switch (itemType)
+                    {
+                        case TT_BYTE:   return numbers_<Byte>(hash, size);
+                        case TT_SHORT:  return numbers_<Int16>(hash, size);
+                        case TT_INT:    return numbers_<Int32>(hash, size);
+                        case TT_LONG:   return numbers_<Int64>(hash, size);
+                        case TT_FLOAT:  return numbers_<Fp32>(hash, size);
+                        case TT_DOUBLE: return numbers_<Fp64>(hash, size);
+                        default:        break;
+                    }
+
+                    hash = _hashMix(hash, size);
+                    for (size_t i = 0; i < size; ++i)
+                        hash = _hashMix(hash, value_(itemType, depth + 1));
+
+                    return hash;
+                }
+                case TT_COMPOUND:
+                {
+                    UInt64 hash = type;
+                    UInt64 sum = 0;
+                    size_t count = 0;
+                    for (;;)
+                    {
+                        int next = src_.get();
+                        if (next == std::char_traits<char>::eof() || next == TT_END)
+                            break;
+
+                        UInt64 name = string_();
+                        UInt64 member = _hashMix(name, value_(static_cast<TagType>(next), depth + 1));
+
+                        // The sum is independent of the order.
+                        if (isKeyOrderIgnored_)
+                            sum += member;
+                        else
+                            hash = _hashMix(hash, member);
+                        ++count;
+                    }
+
+                    return isKeyOrderIgnored_ ? _hashMix(_hashMix(hash, count), sum) : hash;
+                }
+                default:
+                    throw std::runtime_error("Invalid tag type.");
+            }
+        }
+
+        /// @brief Read the numbers of array or list and hash them with their count chunk by chunk.
+        template <typename T>
+        UInt64 numbers_(UInt64 hash, size_t count)
+        {
+            constexpr size_t chunk = (64 << 10) / sizeof(T);
+
+            Vec<T>& buffer = buffer_(static_cast<T*>(nullptr));
+            hash = _hashMix(hash, count);
+            while (count != 0)
+            {
+                size_t n = count < chunk ? count : chunk;
+                buffer.clear();
+                _readNumbers(src_, n, buffer, enc_);
+
+                char* p = reinterpret_cast<char*>(buffer.data());
+                if (sizeof(T) != 1 && _isBigEndian())
+                    _reverseEach(p, p, n, sizeof(T));
+                hash = _hashBytes(p, n * sizeof(T), hash);
+
+                count -= n;
+            }
+
+            return hash;
+        }
+
+        // The reused buffers of numbers.
+        Vec<Byte>& buffer_(Byte*)       { return bytes_; }
+        Vec<Int16>& buffer_(Int16*)     { return shorts_; }
+        Vec<Int32>& buffer_(Int32*)     { return ints_; }
+        Vec<Int64>& buffer_(Int64*)     { return longs_; }
+        Vec<Fp32>& buffer_(Fp32*)       { return floats_; }
+        Vec<Fp64>& buffer_(Fp64*)       { return doubles_; }
+
+        Source& src_;
+        Encoding enc_;
+        bool isKeyOrderIgnored_;
+        String str_;
+        Vec<Byte> bytes_;
+        Vec<Int16> shorts_;
+        Vec<Int32> ints_;
+        Vec<Int64> longs_;
+        Vec<Fp32> floats_;
+        Vec<Fp64> doubles_;
+    };
+
+    /// @brief Get the root tag (with its type and name) from a binary source.
+    template <typename Source>
+    static Tag fromSource_(Source& src, Encoding enc, ReadContext_& ctx)
+    {
+        Tag tag;
+
+        int type = src.get();
+        if (type == std::char_traits<char>::eof())
+            throw std::runtime_error("Unexpected end of data.");
+        tag.tagType_ = static_cast<TagType>(type);
+
+        if (tag.tagType_ == TT_END)
+            return tag;
+
+        _readString(src, enc, ctx.pool.buffer_());
+        tag.tagName_ = ctx.pool.intern_();
+
+        readValue_(tag, src, enc, ctx, 0);
+
+        return tag;
+    }
+
+    /// @brief Read the value of the tag which type is set.
+    /// @return The hash of the value if the context is to dedup, else 0.
+    template <typename Source>
+    static UInt64 readValue_(Tag& tag, Source& src, Encoding enc, ReadContext_& ctx, size_t depth)
+    {
+        if (depth > _MAX_NESTING_DEPTH)
+            throw std::runtime_error("The nesting depth of tag is too deep.");
+
+        MCNBT_STATS(ctx.count(tag.tagType_, depth);)
+
+        switch (tag.tagType_)
+        {
+            case TT_BYTE:
+                tag.tagData_.num.i8 = _readNum<Byte>(src, false);
+                break;
+            case TT_SHORT:
+                tag.tagData_.num.i16 = _readNum<Int16>(src, enc == EC_BIG_ENDIAN);
+                break;
+            case TT_INT:
+                tag.tagData_.num.i32 = _readInt32(src, enc);
+                break;
+            case TT_LONG:
+                tag.tagData_.num.i64 = _readInt64(src, enc);
+                break;
+            case TT_FLOAT:
+                tag.tagData_.num.f32 = _readNum<Fp32>(src, enc == EC_BIG_ENDIAN);
+                break;
+            case TT_DOUBLE:
+                tag.tagData_.num.f64 = _readNum<Fp64>(src, enc == EC_BIG_ENDIAN);
+                break;
+            case TT_STRING:
+                _readString(src, enc, ctx.pool.buffer_());
+                tag.tagData_.str = ctx.pool.intern_();
+                // Same as #leafHash_(), but the hash of interned string is ready.
+                if (!ctx.isDedup)
+                    return 0;
+                return _hashMix(TT_STRING, tag.tagData_.str ? tag.tagData_.str->hash : 0);
+            case TT_BYTE_ARRAY:
+            {
+                size_t dsize = _readSize(src, enc);
+
+                if (dsize != 0)
+                {
+                    tag.tagData_.bad = new Vec<Byte>();
+                    _readFixedArray(src, dsize, *tag.tagData_.bad, false);
+                }
+                break;
+            }
+            case TT_INT_ARRAY:
+            {
+                size_t dsize = _readSize(src, enc);
+
+                if (dsize != 0)
+                {
+                    tag.tagData_.iad = new Vec<Int32>();
+                    _readIntegers(src, dsize, *tag.tagData_.iad, enc);
+                }
+                break;
+            }
+            case TT_LONG_ARRAY:
+            {
+                size_t dsize = _readSize(src, enc);
+
+                if (dsize != 0)
+                {
+                    tag.tagData_.lad = new Vec<Int64>();
+                    _readIntegers(src, dsize, *tag.tagData_.lad, enc);
+                }
+                break;
+            }
+            case TT_LIST:
+            {
+                tag.itemType_ = static_cast<TagType>(_readNum<Byte>(src, false));
+                size_t dsize = _readSize(src, enc);
+
+                if (nbt::isNum(tag.itemType_))
+                {
+                    tag.isPacked_ = true;
+
+                    if (dsize != 0)
+                    {
+                        MCNBT_STATS(ctx.count(tag.itemType_, depth + 1, dsize);)
+                        PackedReader_<Source> reader{ src, dsize, enc };
+                        tag.visitPacked_(reader);
+                    }
+                }
+                else if (tag.itemType_ == TT_COMPOUND && dsize != 0)
+                {
+                    return readCompoundList_(tag, src, enc, ctx, dsize, depth);
+                }
+                else if (dsize != 0)
+                {
+                    tag.tagData_.ld = new Vec<Tag>();
+                    // Don't trust the size before the items are read.
+                    tag.tagData_.ld->reserve(dsize < 4096 ? dsize : 4096);
+
+                    UInt64 hash = _hashMix(TT_LIST, tag.itemType_);
+                    for (size_t i = 0; i < dsize; ++i)
+                    {
+                        Tag item(tag.itemType_);
+                        hash = _hashMix(hash, readValue_(item, src, enc, ctx, depth + 1));
+                        tag.addTag(std::move(item));
+                    }
+
+                    return ctx.isDedup ? hash : 0;
+                }
+                break;
+            }
+            case TT_COMPOUND:
+            {
+                UInt64 hash = readCompound_(tag, src, enc, ctx, depth, nullptr);
+                if (ctx.isDedup)
+                    ctx.dedup(tag, hash);
+
+                return hash;
+            }
+            default:
+                throw std::runtime_error("Invalid tag type.");
+        }
+
+        return ctx.isDedup ? tag.leafHash_() : 0;
+    }
+
+    /// @brief Read the items of the list of compounds.
+    // The items share the keys of the first non-empty item if they have same keys.
+    /// @return The hash of the list if the context is to dedup, else 0.
+    template <typename Source>
+    static UInt64 readCompoundList_(Tag& tag, Source& src, Encoding enc, ReadContext_& ctx, size_t count,
+                                    size_t depth)
+    {
+        if (depth + 1 > _MAX_NESTING_DEPTH)
+            throw std::runtime_error("The nesting depth of tag is too deep.");
+
+        tag.tagData_.ld = new Vec<Tag>();
+        // Don't trust the size before the items are read.
+        tag.tagData_.ld->reserve(count < 4096 ? count : 4096);
+
+        UInt64 hash = _hashMix(TT_LIST, TT_COMPOUND);
+        std::shared_ptr<const Shape> shape;
+        for (size_t i = 0; i < count; ++i)
+        {
+            Tag item(TT_COMPOUND);
+            MCNBT_STATS(ctx.count(TT_COMPOUND, depth + 1);)
+            UInt64 itemHash = readCompound_(item, src, enc, ctx, depth + 1, shape);
+
+            if (!shape && count > 1 && item.tagData_.cd && !item.tagData_.cd->empty())
+                shape = item.makeShape_();
+
+            if (ctx.isDedup)
+            {
+                ctx.dedup(item, itemHash);
+                hash = _hashMix(hash, itemHash);
+            }
+
+            tag.addTag(std::move(item));
+        }
+
+        return ctx.isDedup ? hash : 0;
+    }
+
+    // Get the pointer to the current position of the source of the bytes read. (See #ReadOptions::isSpanKept)
+    static const char* spanPos_(const BufferSource& src) { return src.data(); }
+
+    template <typename Source>
+    static const char* spanPos_(const Source&) { return nullptr; }
+
+    /// @brief Point the spans of the compounds read from the bytes to the same bytes in other place.
+    static void rebaseSpans_(Tag& tag, const Encoded_* from, const std::shared_ptr<const Encoded_>& to)
+    {
+        Vec<Tag>* tags = nullptr;
+
+        if (tag.isList() && !tag.isPacked_)
+        {
+            tags = tag.tagData_.ld;
+        }
+        else if (tag.isCompound() && tag.tagData_.cd)
+        {
+            CompoundData* cd = tag.tagData_.cd;
+            // The data shared by the identical compounds is rebased once.
+            if (cd->encoded == to)
+                return;
+
+            if (cd->encoded.get() == from)
+            {
+                cd->span = to->data.data() + (cd->span - from->data.data());
+                cd->encoded = to;
+            }
+
+            tags = &cd->data;
+        }
+
+        if (tags)
+            for (auto& var : *tags)
+                rebaseSpans_(var, from, to);
+    }
+
+    /// @brief Read the members of compound until End tag.
+    /// @param shape If not null, the compound shares it while the keys of members are same as it,
+    // else (or once a key diverges) the compound has its own keys.
+    /// @return The hash of the compound if the context is to dedup, else 0.
+    template <typename Source>
+    static UInt64 readCompound_(Tag& tag, Source& src, Encoding enc, ReadContext_& ctx, size_t depth,
+                                const std::shared_ptr<const Shape>& shape)
+    {
+        if (shape)
+        {
+            tag.tagData_.cd = new CompoundData();
+            tag.tagData_.cd->shape = shape;
+            tag.tagData_.cd->data.reserve(shape->keys.size());
+        }
+
+        const char* span = ctx.encoded ? spanPos_(src) : nullptr;
+        const char* spanEnd = nullptr;
+
+        UInt64 hash = TT_COMPOUND;
+        for (;;)
+        {
+            int next = src.peek();
+            if (next == std::char_traits<char>::eof())
+                break;
+
+            if (next == TT_END)
+            {
+                // Give up End tag and move source point to next Byte.
+                src.get();
+                spanEnd = span ? spanPos_(src) : nullptr;
+                break;
+            }
+
+            Tag member;
+            member.tagType_ = static_cast<TagType>(src.get());
+            _readString(src, enc, ctx.pool.buffer_());
+            _SharedString* name = ctx.pool.intern_();
+
+            bool isShared = tag.tagData_.cd && tag.tagData_.cd->shape;
+            if (isShared)
+            {
+                size_t idx = tag.tagData_.cd->size();
+                if (idx >= shape->keys.size() || !_isEqual(name, shape->keys[idx]))
+                {
+                    tag.unshare_();
+                    isShared = false;
+                }
+            }
+
+            if (ctx.isDedup)
+                hash = _hashMix(hash, name ? name->hash : 0);
+
+            if (isShared)
+                _release(name);
+            else
+                member.tagName_ = name;
+
+            UInt64 memberHash = readValue_(member, src, enc, ctx, depth + 1);
+            if (ctx.isDedup)
+                hash = _hashMix(hash, memberHash);
+
+            if (isShared)
+            {
+                // The capacity is enough, so the members are not moved.
+                tag.tagData_.cd->data.emplace_back(std::move(member));
+                tag.tagData_.cd->data.back().parent_ = &tag;
+            }
+            else
+            {
+                tag.addTag(std::move(member));
+            }
+        }
+
+        if (tag.tagData_.cd && tag.tagData_.cd->shape && tag.tagData_.cd->size() != shape->keys.size())
+            tag.unshare_();
+
+        // Keep the span only if the compound is ended by End tag.
+        if (spanEnd && tag.tagData_.cd)
+        {
+            tag.tagData_.cd->encoded = ctx.encoded;
+            tag.tagData_.cd->span = span;
+            tag.tagData_.cd->spanSize = static_cast<size_t>(spanEnd - span);
+        }
+
+        return ctx.isDedup ? hash : 0;
+    }
+
+    /// @brief Write the tag to file through a large buffer.
+    void writeFile_(const String& filename, Encoding enc, bool isCompressed, const FileWriteOptions& options) const
+    {
+        // The temporary file of atomic write has a unique name, so the writes of same file don't conflict.
+        String path;
+        std::unique_ptr<_File> file;
+        if (options.isAtomic)
+            file.reset(new _File(filename, options.isDirect, path));
+        else
+            file.reset(new _File(filename, options.isDirect));
+
+        // The document includes the end of Gzip stream and the flush.
+        MCNBT_STATS(_StatsScope scope(SK_WRITE);)
+
+        try
+        {
+            if (options.isAtomic)
+                file->copyMode(filename);
+
+            {
+                FileSink sink(file->fd(), options.bufferSize, file->isDirect());
+
+            #ifdef MCNBT_ENABLE_GZIP
+                if (isCompressed)
+                {
+                    gzip::CompressSink<FileSink> csink(sink);
+                    csink.write(options.header.data(), options.header.size());
+                    writeRoot_(csink, enc, options.isCanonical);
+                    csink.finish();
+                }
+                else
+            #else
+                (void) isCompressed;
+            #endif // MCNBT_ENABLE_GZIP
+                {
+                    sink.write(options.header.data(), options.header.size());
+                    writeRoot_(sink, enc, options.isCanonical);
+                }
+
+                sink.flush();
+            }
+
+            if (options.isSync)
+                file->sync();
+
+            file->close();
+        }
+        catch (...)
+        {
+            file.reset();
+            if (options.isAtomic)
+                std::remove(path.c_str());
+            throw;
+        }
+
+        if (options.isAtomic)
+        {
+        #ifdef _WIN32
+            std::remove(filename.c_str());
+        #endif // _WIN32
+            if (std::rename(path.c_str(), filename.c_str()) != 0)
+            {
+                std::remove(path.c_str());
+                throw std::runtime_error("Failed to rename file: " + path + " to " + filename);
+            }
+        }
+    }
+
+    /// @todo
+    static Tag fromSnbt_(IStream& snbtSs, TagType parentType);
+
+    /// @brief Write the tag (as root) to the sink.
+    /// @param isCanonical If true, write the members of compounds in the order of names.
+    template <typename Sink>
+    void writeRoot_(Sink& os, Encoding enc, bool isCanonical) const
+    {
+        MCNBT_STATS(_StatsScope scope(SK_WRITE);)
+        MCNBT_STATS(_StatsBytes<Sink> bytes(os);)
+
+        if (!isCanonical)
+        {
+            write_(os, enc, isListItem());
+            return;
+        }
+
+        Vec<const Tag*> sorted;
+        write_(os, enc, isListItem(), &sorted);
+    }
+
+    /// @brief Write the tag to the sink.
+    /// @param os The output stream or any sink has the member functions put(char) and write(const char*, n).
+    /// @param sorted If not null, write the members of compounds in the order of names, it is the stack of
+    // the sorted members of the compounds being written.
+    template <typename Sink>
+    void write_(Sink& os, Encoding enc, bool isListItem, Vec<const Tag*>* sorted = nullptr) const
+    {
+        MCNBT_STATS(if (_currentStats()) ++_currentStats()->tags[tagType_];)
+
+        if (!isListItem)
+        {
+            os.put(static_cast<Byte>(tagType_));
+
+            const String* name = namePtr_();
+            if (!name || name->empty())
+            {
+                _writeStringLength(0, os, enc);
+            }
+            else
+            {
+                _writeStringLength(name->size(), os, enc);
+                os.write(name->c_str(), name->size());
+            }
+        }
+
+        switch (tagType_)
+        {
+            case TT_END:
+                os.put(TT_END);
+                break;
+            case TT_BYTE:
+                os.put(tagData_.num.i8);
+                break;
+            case TT_SHORT:
+                _num2bytes<Int16>(tagData_.num.i16, os, enc == EC_BIG_ENDIAN);
+                break;
+            case TT_INT:
+                _writeInt32(tagData_.num.i32, os, enc);
+                break;
+            case TT_LONG:
+                _writeInt64(tagData_.num.i64, os, enc);
+                break;
+            case TT_FLOAT:
+                _num2bytes<Fp32>(tagData_.num.f32, os, enc == EC_BIG_ENDIAN);
+                break;
+            case TT_DOUBLE:
+                _num2bytes<Fp64>(tagData_.num.f64, os, enc == EC_BIG_ENDIAN);
+                break;
+            case TT_STRING:
+            {
+                if (!tagData_.str || tagData_.str->str.empty())
+                {
+                    _writeStringLength(0, os, enc);
+                    break;
+                }
+
+                _writeStringLength(tagData_.str->str.size(), os, enc);
+                os.write(tagData_.str->str.c_str(), tagData_.str->str.size());
+
+                break;
+            }
+            case TT_BYTE_ARRAY:
+            {
+                if (!tagData_.bad || tagData_.bad->empty())
+                {
+                    _writeInt32(0, os, enc);
+                    break;
+                }
+
+                _writeInt32(static_cast<Int32>(tagData_.bad->size()), os, enc);
+                os.write(tagData_.bad->data(), tagData_.bad->size());
+
+                break;
+            }
+            case TT_INT_ARRAY:
+            {
+                if (!tagData_.iad || tagData_.iad->empty())
+                {
+                    _writeInt32(0, os, enc);
+                    break;
+                }
+
+                _writeInt32(static_cast<Int32>(tagData_.iad->size()), os, enc);
+                _writeIntegers(tagData_.iad->data(), tagData_.iad->size(), os, enc);
+
+                break;
+            }
+            case TT_LONG_ARRAY:
+            {
+                if (!tagData_.lad || tagData_.lad->empty())
+                {
+                    _writeInt32(0, os, enc);
+                    break;
+                }
+
+                _writeInt32(static_cast<Int32>(tagData_.lad->size()), os, enc);
+                _writeIntegers(tagData_.lad->data(), tagData_.lad->size(), os, enc);
+
+                break;
+            }
+            case TT_LIST:
+            {
+                size_t count = listSize_();
+                if (count == 0)
+                {
+                    os.put(static_cast<Byte>(TT_END));
+                    _writeInt32(0, os, enc);
+                    break;
+                }
+
+                os.put(static_cast<Byte>(itemType_));
+                _writeInt32(static_cast<Int32>(count), os, enc);
+
+                if (isPacked_)
+                {
+                    MCNBT_STATS(if (_currentStats()) _currentStats()->tags[itemType_] += count;)
+                    PackedWriter_<Sink> writer{ os, enc };
+                    visitPacked_(writer);
+                    break;
+                }
+
+                if (itemType_ == TT_COMPOUND && !sorted)
+                {
+                    writeCompoundItems_(os, enc);
+                    break;
+                }
+
+                for (const auto& var : *tagData_.ld)
+                    var.write_(os, enc, true, sorted);
+
+                break;
+            }
+            case TT_COMPOUND:
+            {
+                if (!tagData_.cd || tagData_.cd->data.empty())
+                {
+                    os.put(TT_END);
+                    break;
+                }
+
+                const CompoundData& cd = *tagData_.cd;
+                if (!sorted && cd.hasSpan(enc))
+                {
+                    // The span includes the End tag.
+                    os.write(cd.span, cd.spanSize);
+                    break;
+                }
+
+                if (!sorted)
+                {
+                    for (const auto& var : cd.data)
+                        var.write_(os, enc, false);
+                }
+                else if (cd.shape && cd.shape->order.size() == cd.size())
+                {
+                    // The order is computed once for the compounds which share the shape.
+                    for (size_t idx : cd.shape->order)
+                        cd.data[idx].write_(os, enc, false, sorted);
+                }
+                else
+                {
+                    // Sort the members on the top of stack, the nested compounds use the space above them.
+                    size_t begin = sorted->size();
+                    for (const auto& var : cd.data)
+                        sorted->emplace_back(&var);
+                    std::sort(sorted->begin() + begin, sorted->end(), [](const Tag* lhs, const Tag* rhs)
+                    { return isNameLess_(lhs->nameRef_(), rhs->nameRef_()); });
+
+                    size_t end = sorted->size();
+                    for (size_t i = begin; i < end; ++i)
+                        (*sorted)[i]->write_(os, enc, false, sorted);
+
+                    sorted->resize(begin);
+                }
+
+                os.put(TT_END);
+
+                break;
+            }
+            default:
+                throw std::runtime_error("Invalid tag type.");
+        }
+    }
+
+    /// @brief Write the items of the list of compounds, the adjacent spans of the items are written at once.
+    // (See #ReadOptions::isSpanKept)
+    template <typename Sink>
+    void writeCompoundItems_(Sink& os, Encoding enc) const
+    {
+        const char* run = nullptr;
+        size_t runSize = 0;
+
+        for (const auto& var : *tagData_.ld)
+        {
+            const CompoundData* cd = var.tagData_.cd;
+            if (cd && cd->hasSpan(enc))
+            {
+                if (run && run + runSize == cd->span)
+                {
+                    runSize += cd->spanSize;
+                    continue;
+                }
+
+                if (run)
+                    os.write(run, runSize);
+
+                run = cd->span;
+                runSize = cd->spanSize;
+                continue;
+            }
+
+            if (run)
+            {
+                os.write(run, runSize);
+                run = nullptr;
+            }
+
+            var.write_(os, enc, true);
+        }
+
+        if (run)
+            os.write(run, runSize);
+    }
+
+    /// @brief Get the size of the bytes written by #write_().
+    size_t binarySize_(Encoding enc, bool isListItem) const
+    {
+        size_t size = 0;
+
+        if (!isListItem)
+        {
+            const String* name = namePtr_();
+            size_t nameLen = name ? name->size() : 0;
+            size += 1 + _stringLengthSize(nameLen, enc) + nameLen;
+        }
+
+        switch (tagType_)
+        {
+            case TT_END:        return size + 1;
+            case TT_BYTE:       return size + sizeof(Byte);
+            case TT_SHORT:      return size + sizeof(Int16);
+            case TT_INT:        return size + _int32Size(tagData_.num.i32, enc);
+            case TT_LONG:       return size + _int64Size(tagData_.num.i64, enc);
+            case TT_FLOAT:      return size + sizeof(Fp32);
+            case TT_DOUBLE:     return size + sizeof(Fp64);
+            case TT_STRING:
+            {
+                size_t len = tagData_.str ? tagData_.str->str.size() : 0;
+                return size + _stringLengthSize(len, enc) + len;
+            }
+            case TT_BYTE_ARRAY:
+            {
+                size_t count = tagData_.bad ? tagData_.bad->size() : 0;
+                return size + _int32Size(static_cast<Int32>(count), enc) + count;
+            }
+            case TT_INT_ARRAY:
+            {
+                size_t count = tagData_.iad ? tagData_.iad->size() : 0;
+                size += _int32Size(static_cast<Int32>(count), enc);
+
+                if (enc != EC_NETWORK)
+                    return size + count * sizeof(Int32);
+
+                for (size_t i = 0; i < count; ++i)
+                    size += _int32Size((*tagData_.iad)[i], enc);
+                return size;
+            }
+            case TT_LONG_ARRAY:
+            {
+                size_t count = tagData_.lad ? tagData_.lad->size() : 0;
+                size += _int32Size(static_cast<Int32>(count), enc);
+
+                if (enc != EC_NETWORK)
+                    return size + count * sizeof(Int64);
+
+                for (size_t i = 0; i < count; ++i)
+                    size += _int64Size((*tagData_.lad)[i], enc);
+                return size;
+            }
+            case TT_LIST:
+            {
+                size_t count = listSize_();
+                size += 1 + _int32Size(static_cast<Int32>(count), enc);
+
+                if (isPacked_)
+                {
+                    PackedSizer_ sizer{ enc, 0 };
+                    visitPacked_(sizer);
+                    return size + sizer.size;
+                }
+
+                for (size_t i = 0; i < count; ++i)
+                    size += (*tagData_.ld)[i].binarySize_(enc, true);
+                return size;
+            }
+            case TT_COMPOUND:
+            {
+                if (tagData_.cd && tagData_.cd->hasSpan(enc))
+                    return size + tagData_.cd->spanSize;
+
+                if (tagData_.cd)
+                {
+                    for (const auto& var : tagData_.cd->data)
+                        size += var.binarySize_(enc, false);
+                }
+                return size + 1;
+            }
+            default:
+                throw std::runtime_error("Invalid tag type.");
+        }
+    }
+
+    /// @param indentCount The count of indents of the tag, that is its depth in the tag being converted.
+    String toSnbt_(bool isWrappedIndented, bool isListItem, size_t indentCount = 0) const
+    {
+        String inheritedIndentStr(indentCount * _SNBT_INDENT_WIDTH, ' ');
+        String key = isWrappedIndented ? inheritedIndentStr : "";
+
+        if (!isListItem && !name().empty())
+            key += name() + (isWrappedIndented ? ": " : ":");
+
+        switch (type())
+        {
+            case TT_END:        return "";
+            case TT_BYTE:       return key + std::to_string(static_cast<int>(tagData_.num.i8)) + 'b';
+            case TT_SHORT:      return key + std::to_string(tagData_.num.i16) + 's';
+            case TT_INT:        return key + std::to_string(tagData_.num.i32);
+            case TT_LONG:       return key + std::to_string(tagData_.num.i64) + 'l';
+            case TT_FLOAT:      return key + std::to_string(tagData_.num.f32) + 'f';
+            case TT_DOUBLE:     return key + std::to_string(tagData_.num.f64) + 'd';
+            case TT_STRING:     return key + '"' + (tagData_.str ? tagData_.str->str : "") + '"';
+            case TT_BYTE_ARRAY:
+            {
+                if (!tagData_.bad || tagData_.bad->empty())
+                    return key + "[B;]";
+
+                // If has indent add the newline character and indent string.
+                String snbt = key + '[';
+                snbt += isWrappedIndented ? ('\n' + inheritedIndentStr + _SNBT_INDENT_STR) : "";
+                snbt += "B;";
+
+                for (const auto& var : *tagData_.bad)
+                {
+                    snbt += isWrappedIndented ? ('\n' + inheritedIndentStr + _SNBT_INDENT_STR) : "";
+                    snbt += std::to_string(static_cast<int>(var)) + "b,";
+                }
+
+                if (snbt.back() == ',')
+                    snbt.pop_back();
+
+                snbt += isWrappedIndented ? ('\n' + inheritedIndentStr) : "";
+                snbt += ']';
+
+                return snbt;
+            }
+            case TT_INT_ARRAY:
+            {
+                if (!tagData_.iad || tagData_.iad->empty())
+                    return key + "[I;]";
+
+                // If has indent add the newline character and indent string.
+                String snbt = key + '[';
+                snbt += isWrappedIndented ? ('\n' + inheritedIndentStr + _SNBT_INDENT_STR) : "";
+                snbt += "I;";
+
+                for (const auto& var : *tagData_.iad)
+                {
+                    snbt += isWrappedIndented ? ('\n' + inheritedIndentStr + _SNBT_INDENT_STR) : "";
+                    snbt += std::to_string(var) + ",";
+                }
+
+                if (snbt.back() == ',')
+                    snbt.pop_back();
+
+                snbt += isWrappedIndented ? ('\n' + inheritedIndentStr) : "";
+                snbt += ']';
+
+                return snbt;
+            }
+            case TT_LONG_ARRAY:
+            {
+                if (!tagData_.lad || tagData_.lad->empty())
+                    return key + "[L;]";
+
+                // If has indent add the newline character and indent string.
+                String snbt = key + '[';
+                snbt += isWrappedIndented ? ('\n' + inheritedIndentStr + _SNBT_INDENT_STR) : "";
+                snbt += "L;";
+
+                for (const auto& var : *tagData_.lad)
+                {
+                    snbt += isWrappedIndented ? ('\n' + inheritedIndentStr + _SNBT_INDENT_STR) : "";
+                    snbt += std::to_string(var) + "l,";
+                }
+
+                if (snbt.back() == ',')
+                    snbt.pop_back();
+
+                snbt += isWrappedIndented ? ('\n' + inheritedIndentStr) : "";
+                snbt += ']';
+
+                return snbt;
+            }
+            case TT_LIST:
+            {
+                if (listSize_() == 0)
+                    return key + "[]";
+
+                String snbt = key + '[';
+
+                if (isPacked_)
+                {
+                    PackedSnbtWriter_ writer{ itemType_, isWrappedIndented, indentCount + 1, snbt };
+                    visitPacked_(writer);
+                }
+                else
+                {
+                    for (const auto& var : *tagData_.ld)
+                    {
+                        snbt += isWrappedIndented ? "\n" : "";
+                        snbt += var.toSnbt_(isWrappedIndented, true, indentCount + 1) + ",";
+                    }
+                }
+
+                if (snbt.back() == ',')
+                    snbt.pop_back();
+
+                snbt += isWrappedIndented ? ('\n' + inheritedIndentStr) : "";
+                snbt += ']';
+
+                return snbt;
+            }
+            case TT_COMPOUND:
+            {
+                if (!tagData_.cd || tagData_.cd->data.empty())
+                    return key + "{}";
+
+                String snbt = key + "{";
+
+                for (const auto& var : tagData_.cd->data)
+                {
+                    snbt += isWrappedIndented ? "\n" : "";
+                    snbt += var.toSnbt_(isWrappedIndented, false, indentCount + 1) + ",";
+                }
+
+                if (snbt.back() == ',')
+                    snbt.pop_back();
+
+                snbt += isWrappedIndented ? ('\n' + inheritedIndentStr) : "";
+                snbt += '}';
+
+                return snbt;
+            }
+            default:
+                throw std::runtime_error("Invalid tag type.");
+        }
+    }
+
+    // Functions about the packed list.
+    // The list of numbers stores the items as packed array (e.g. Vec<Int32> for the list of int) instead of tags,
+    // and the items are converted to tags only when they are referenced as tag. (See #unpack_())
+
+    bool isPackedList_() const  { return isList() && isPacked_; }
+
+    // Get the pointer of packed array by the type of number.
+    Vec<Byte>*& packedVec_(Byte*)   { return tagData_.bad; }
+    Vec<Int16>*& packedVec_(Int16*) { return tagData_.sad; }
+    Vec<Int32>*& packedVec_(Int32*) { return tagData_.iad; }
+    Vec<Int64>*& packedVec_(Int64*) { return tagData_.lad; }
+    Vec<Fp32>*& packedVec_(Fp32*)   { return tagData_.fad; }
+    Vec<Fp64>*& packedVec_(Fp64*)   { return tagData_.dad; }
+
+    /// @brief The packed array, with the items made as tags for the const references of them, which are kept until
+    // the array is changed or the list is unpacked. (See #packedItem_())
+    template <typename T>
+    struct PackedVec_ : Vec<T>
+    {
+        mutable std::atomic<Vec<Tag>*> items{ nullptr };
+
+        PackedVec_() = default;
+        explicit PackedVec_(const Vec<T>& other) : Vec<T>(other) {}
+        ~PackedVec_() { delete items.load(std::memory_order_relaxed); }
+
+        /// @brief Remove the items made, must be called before any change of the array.
+        void clearItems() { delete items.exchange(nullptr, std::memory_order_relaxed); }
+    };
+
+    /// @brief Get the packed array of list as #PackedVec_, all of them are allocated as it.
+    template <typename T>
+    static PackedVec_<T>* asPacked_(Vec<T>* vec) { return static_cast<PackedVec_<T>*>(vec); }
+
+    template <typename T>
+    static const PackedVec_<T>* asPacked_(const Vec<T>* vec) { return static_cast<const PackedVec_<T>*>(vec); }
+
+    /// @brief Call the visitor with the pointer of packed array correspond to the list item type.
+    /// @param visitor Has the member function template `void operator()(Vec<T>*& vec)`.
+    template <typename Visitor>
+    void visitPacked_(Visitor& visitor)
+    {
+        switch (itemType_)
+        {
+            case TT_BYTE:       visitor(tagData_.bad); break;
+            case TT_SHORT:      visitor(tagData_.sad); break;
+            case TT_INT:        visitor(tagData_.iad); break;
+            case TT_LONG:       visitor(tagData_.lad); break;
+            case TT_FLOAT:      visitor(tagData_.fad); break;
+            case TT_DOUBLE:     visitor(tagData_.dad); break;
+            default:            break;
+        }
+    }
+
+    /// @overload
+    /// @param visitor Has the member function template `void operator()(const Vec<T>* vec)`.
+    template <typename Visitor>
+    void visitPacked_(Visitor& visitor) const
+    {
+        switch (itemType_)
+        {
+            case TT_BYTE:       visitor(static_cast<const Vec<Byte>*>(tagData_.bad)); break;
+            case TT_SHORT:      visitor(static_cast<const Vec<Int16>*>(tagData_.sad)); break;
+            case TT_INT:        visitor(static_cast<const Vec<Int32>*>(tagData_.iad)); break;
+            case TT_LONG:       visitor(static_cast<const Vec<Int64>*>(tagData_.lad)); break;
+            case TT_FLOAT:      visitor(static_cast<const Vec<Fp32>*>(tagData_.fad)); break;
+            case TT_DOUBLE:     visitor(static_cast<const Vec<Fp64>*>(tagData_.dad)); break;
+            default:            break;
+        }
+    }
+
+    // Get or set the number value as the specified type.
+    // All members of #Num start at the same address, so it is same as access the corresponding member.
+
+    template <typename T>
+    static T loadNum_(const Num& num)
+    {
+        T value;
+        std::memcpy(&value, static_cast<const void*>(&num), sizeof(T));
+        return value;
+    }
+
+    template <typename T>
+    static void storeNum_(Num& num, T value) { std::memcpy(static_cast<void*>(&num), &value, sizeof(T)); }
+
+    // The visitors of packed array.
+
+    struct PackedReleaser_
+    {
+        template <typename T>
+        void operator()(Vec<T>*& vec) { delete asPacked_(vec); vec = nullptr; }
+    };
+
+    struct PackedCopier_
+    {
+        Tag& dst;
+
+        template <typename T>
+        void operator()(const Vec<T>* vec)
+        { if (vec) dst.packedVec_(static_cast<T*>(nullptr)) = new PackedVec_<T>(*vec); }
+    };
+
+    // Make the items (if not made) and get the item by index.
+    struct PackedItemGetter_
+    {
+        const Tag& list;
+        size_t idx;
+        const Tag* item;
+
+        template <typename T>
+        void operator()(const Vec<T>* vec)
+        {
+            if (!vec || idx >= vec->size())
+                return;
+
+            const PackedVec_<T>* packed = asPacked_(vec);
+            Vec<Tag>* items = packed->items.load(std::memory_order_acquire);
+            if (!items)
+            {
+                Vec<Tag>* made = new Vec<Tag>();
+                made->reserve(vec->size());
+                for (const auto& var : *vec)
+                {
+                    made->emplace_back(list.itemType_);
+                    storeNum_(made->back().tagData_.num, var);
+                    made->back().parent_ = const_cast<Tag*>(&list);
+                }
+
+                // The items may be made by other thread at the same time, use the first one.
+                if (packed->items.compare_exchange_strong(items, made, std::memory_order_acq_rel))
+                    items = made;
+                else
+                    delete made;
+            }
+
+            item = &(*items)[idx];
+        }
+    };
+
+    struct PackedReparenter_
+    {
+        Tag& list;
+
+        template <typename T>
+        void operator()(Vec<T>*& vec)
         {
-            if (!tagData_.str || idx >= tagData_.str->size())
-                throw std::out_of_range("The specified index is out of range.");
+            Vec<Tag>* items = vec ? asPacked_(vec)->items.load(std::memory_order_relaxed) : nullptr;
+            if (!items)
+                return;
 
-            tagData_.str->erase(tagData_.str->begin() + idx);
+            for (auto& var : *items)
+                var.parent_ = &list;
         }
-        else if (isByteArray())
+    };
+
+    // Count the memory used by the tags, the data shared by pointers is counted once.
+    struct MemoryCounter_
+    {
+        MemoryUsage usage;
+        std::unordered_set<const void*> counted;
+
+        /// @brief Count the children of tag, the tag object itself is counted by its parent.
+        void count(const Tag& tag)
         {
-            if (!tagData_.bad || idx >= tagData_.bad->size())
-                throw std::out_of_range("The specified index is out of range.");
+            ++usage.tagCount;
+            countString(tag.tagName_, usage.nameBytes);
 
-            tagData_.bad->erase(tagData_.bad->begin() + idx);
+            if (tag.isString())
+            {
+                countString(tag.tagData_.str, usage.payloadBytes);
+            }
+            else if (tag.isByteArray())
+            {
+                (*this)(static_cast<const Vec<Byte>*>(tag.tagData_.bad));
+            }
+            else if (tag.isIntArray())
+            {
+                (*this)(static_cast<const Vec<Int32>*>(tag.tagData_.iad));
+            }
+            else if (tag.isLongArray())
+            {
+                (*this)(static_cast<const Vec<Int64>*>(tag.tagData_.lad));
+            }
+            else if (tag.isList() && tag.isPacked_)
+            {
+                tag.visitPacked_(*this);
+
+                PackedCounter_ counter{ 0 };
+                tag.visitPacked_(counter);
+                usage.tagCount += counter.count;
+            }
+            else if (tag.isList() && tag.tagData_.ld)
+            {
+                countTags(*tag.tagData_.ld);
+            }
+            else if (tag.isCompound() && tag.tagData_.cd)
+            {
+                const CompoundData* cd = tag.tagData_.cd;
+                if (!counted.insert(cd).second)
+                {
+                    ++usage.sharedCount;
+                    return;
+                }
+
+                usage.containerBytes += sizeof(CompoundData);
+                countTags(cd->data);
+                countMap(cd->idxs);
+
+                if (cd->shape && counted.insert(cd->shape.get()).second)
+                {
+                    const Shape& shape = *cd->shape;
+                    usage.containerBytes += sizeof(Shape) + shape.keys.capacity() * sizeof(_SharedString*);
+                    for (auto var : shape.keys)
+                        countString(var, usage.nameBytes);
+                    countMap(shape.idxs);
+                    usage.indexBytes += shape.order.capacity() * sizeof(size_t);
+                }
+
+                if (cd->encoded && counted.insert(cd->encoded.get()).second)
+                    usage.keptBytes += sizeof(Encoded_) + cd->encoded->data.capacity();
+            }
         }
-        else if (isIntArray())
-        {
-            if (!tagData_.iad || idx >= tagData_.iad->size())
-                throw std::out_of_range("The specified index is out of range.");
 
-            tagData_.iad->erase(tagData_.iad->begin() + idx);
+        void countTags(const Vec<Tag>& tags)
+        {
+            usage.nodeBytes += tags.size() * sizeof(Tag);
+            usage.containerBytes += sizeof(Vec<Tag>) + (tags.capacity() - tags.size()) * sizeof(Tag);
+            for (const auto& var : tags)
+                count(var);
         }
-        else if (isLongArray())
+
+        void countString(const _SharedString* str, size_t& bytes)
         {
-            if (!tagData_.lad || idx >= tagData_.lad->size())
-                throw std::out_of_range("The specified index is out of range.");
+            if (!str)
+                return;
 
-            tagData_.lad->erase(tagData_.lad->begin() + idx);
+            if (!counted.insert(str).second)
+            {
+                ++usage.sharedCount;
+                return;
+            }
+
+            bytes += sizeof(_SharedString) + heapSize(str->str);
         }
-        else if (isList())
-        {
-        #ifndef MCNBT_DISABLE_EXCEPTION
-            if (itemType_ == TT_END)
-                throw std::logic_error("Can't read or write a uninitialized list.");
-        #endif
 
-            if (!tagData_.ld || idx >= tagData_.ld->size())
-                throw std::out_of_range("The specified index is out of range.");
+        void countMap(const Map<String, size_t>& map)
+        {
+            usage.indexBytes += map.bucket_count() * sizeof(void*);
+            usage.indexBytes += map.size() * (sizeof(void*) + sizeof(Map<String, size_t>::value_type) + sizeof(size_t));
+            for (const auto& var : map)
+                usage.indexBytes += heapSize(var.first);
+        }
 
-            tagData_.ld->erase(tagData_.ld->begin() + idx);
+        /// @brief Get the size of the buffer of the string out of the object (the short strings are in the object).
+        static size_t heapSize(const String& str)
+        {
+            static const size_t inplaceCapacity = String().capacity();
+            return str.capacity() > inplaceCapacity ? str.capacity() + 1 : 0;
         }
-        else if (isCompound())
+
+        /// @brief Count the packed vector. (See #visitPacked_())
+        template <typename T>
+        void operator()(const Vec<T>* vec)
         {
-            if (!tagData_.cd || idx >= tagData_.cd->size())
-                throw std::out_of_range("The specified index is out of range.");
+            if (!vec)
+                return;
 
-            tagData_.cd->idxs.erase(tagData_.cd->data[idx].name());
-            tagData_.cd->data.erase(tagData_.cd->data.begin() + idx);
+            usage.payloadBytes += vec->size() * sizeof(T);
+            usage.containerBytes += sizeof(PackedVec_<T>) + (vec->capacity() - vec->size()) * sizeof(T);
 
-            for (auto& var : tagData_.cd->idxs)
-                if (var.second > idx)
-                    var.second--;
+            // The items made for the const references.
+            const Vec<Tag>* items = asPacked_(vec)->items.load(std::memory_order_acquire);
+            if (items)
+            {
+                usage.nodeBytes += items->size() * sizeof(Tag);
+                usage.containerBytes += sizeof(Vec<Tag>) + (items->capacity() - items->size()) * sizeof(Tag);
+            }
         }
+    };
 
-        return *this;
-    }
-
-    /// @overload
-    /// @brief Remove the tag by name.
-    /// @attention Only be called via #TT_COMPOUND.
-    Tag& remove(const String& name)
+    struct PackedCounter_
     {
-        assert(isCompound());
-        assert(hasTag(name));
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isCompound())
-            throw std::logic_error("Can't remove tag from non-compound tag.");
+        size_t count;
 
-        if (!hasTag(name))
-            throw std::logic_error("The specified name is not exists.");
+        template <typename T>
+        void operator()(const Vec<T>* vec) { count = vec ? vec->size() : 0; }
+    };
 
-        if (!tagData_.cd)
-            throw std::logic_error("The member of specified name is not exists.");
-    #endif
+    struct PackedReserver_
+    {
+        size_t size;
 
-        size_t idx = tagData_.cd->idxs[name];
+        template <typename T>
+        void operator()(Vec<T>*& vec)
+        {
+            if (!vec)
+                vec = new PackedVec_<T>();
+            vec->reserve(size);
+        }
+    };
 
-        tagData_.cd->data.erase(tagData_.cd->data.begin() + idx);
-        tagData_.cd->idxs.erase(name);
+    struct PackedAppender_
+    {
+        Num num;
+        size_t count;
 
-        for (auto& var : tagData_.cd->idxs)
+        template <typename T>
+        void operator()(Vec<T>*& vec)
         {
-            if (var.second > idx)
-            var.second--;
+            if (!vec)
+                vec = new PackedVec_<T>();
+            asPacked_(vec)->clearItems();
+            vec->insert(vec->end(), count, loadNum_<T>(num));
         }
+    };
 
-        return *this;
-    }
-
-    /// @brief Remove the first element.
-    /// @attention Only be called via
-    // #TT_STRING, #TT_BYTE_ARRAY, #TT_INT_ARRAY, #TT_LONG_ARRAY, #TT_LIST, #TT_COMPOUND.
-    Tag& removeFront()
+    struct PackedInserter_
     {
-        assert(isString() || isArray() || isContainer());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isString() && !isArray() && !isContainer())
-            throw std::logic_error("Can't remove front element from non-string, non-array, non-container tag.");
-    #endif
+        size_t idx;
+        Num num;
 
-        if (isString())
+        template <typename T>
+        void operator()(Vec<T>*& vec)
         {
-            if (!tagData_.str || tagData_.str->empty())
-                throw std::out_of_range("The front member is not exists.");
-
-            tagData_.str->erase(tagData_.str->begin());
+            if (!vec)
+                vec = new PackedVec_<T>();
+            asPacked_(vec)->clearItems();
+            vec->insert(vec->begin() + idx, loadNum_<T>(num));
         }
-        else if (isByteArray())
-        {
-            if (!tagData_.bad || tagData_.bad->empty())
-                throw std::out_of_range("The front member is not exists.");
+    };
 
-            tagData_.bad->erase(tagData_.bad->begin());
-        }
-        else if (isIntArray())
-        {
-            if (!tagData_.iad || tagData_.iad->empty())
-                throw std::out_of_range("The front member is not exists.");
+    struct PackedEraser_
+    {
+        size_t first;
+        size_t last;
 
-            tagData_.iad->erase(tagData_.iad->begin());
-        }
-        else if (isLongArray())
+        template <typename T>
+        void operator()(Vec<T>*& vec)
         {
-            if (!tagData_.lad || tagData_.lad->empty())
-                throw std::out_of_range("The front member is not exists.");
+            if (!vec)
+                return;
 
-            tagData_.lad->erase(tagData_.lad->begin());
+            asPacked_(vec)->clearItems();
+            vec->erase(vec->begin() + first, vec->begin() + last);
         }
-        else if (isList())
-        {
-        #ifndef MCNBT_DISABLE_EXCEPTION
-            if (itemType_ == TT_END)
-                throw std::logic_error("Can't read or write a uninitialized list.");
-        #endif
+    };
 
-            if (!tagData_.ld || tagData_.ld->empty())
-                throw std::out_of_range("The front member is not exists.");
+    template <typename Source>
+    struct PackedReader_
+    {
+        Source& src;
+        size_t count;
+        Encoding enc;
 
-            tagData_.ld->erase(tagData_.ld->begin());
-        }
-        else if (isCompound())
+        template <typename T>
+        void operator()(Vec<T>*& vec)
         {
-            if (!tagData_.cd || tagData_.cd->empty())
-                throw std::out_of_range("The front member is not exists.");
+            vec = new PackedVec_<T>();
+            _readNumbers(src, count, *vec, enc);
+        }
+    };
 
-            tagData_.cd->idxs.erase(tagData_.cd->data.front().name());
-            tagData_.cd->data.erase(tagData_.cd->data.begin());
+    template <typename Sink>
+    struct PackedWriter_
+    {
+        Sink& os;
+        Encoding enc;
 
-            for (auto& var : tagData_.cd->idxs)
-                var.second--;
-        }
+        template <typename T>
+        void operator()(const Vec<T>* vec) { if (vec) _writeNumbers(vec->data(), vec->size(), os, enc); }
+    };
 
-        return *this;
-    }
+    struct PackedSizer_
+    {
+        Encoding enc;
+        size_t size;
 
-    /// @brief Remove the last element.
-    /// @attention Only be called via
-    // #TT_STRING, #TT_BYTE_ARRAY, #TT_INT_ARRAY, #TT_LONG_ARRAY, #TT_LIST, #TT_COMPOUND.
-    Tag& removeBack()
+        template <typename T>
+        void operator()(const Vec<T>* vec) { size = vec ? _numbersSize(vec->data(), vec->size(), enc) : 0; }
+    };
+
+    struct PackedSnbtWriter_
     {
-        assert(isString() || isArray() || isContainer());
-    #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isString() && !isArray() && !isContainer())
-            throw std::logic_error("Can't remove back element from non-string, non-array, non-container tag.");
-    #endif
+        TagType itemType;
+        bool isWrappedIndented;
+        size_t indentCount;
+        String& snbt;
 
-        if (isString())
+        template <typename T>
+        void operator()(const Vec<T>* vec)
         {
-            if (!tagData_.str || tagData_.str->empty())
-                throw std::out_of_range("The back member is not exists.");
+            if (!vec)
+                return;
 
-            tagData_.str->pop_back();
+            Tag item(itemType);
+            for (const auto& var : *vec)
+            {
+                storeNum_(item.tagData_.num, var);
+                snbt += isWrappedIndented ? "\n" : "";
+                snbt += item.toSnbt_(isWrappedIndented, true, indentCount) + ",";
+            }
         }
-        else if (isByteArray())
-        {
-            if (!tagData_.bad || tagData_.bad->empty())
-                throw std::out_of_range("The back member is not exists.");
+    };
 
-            tagData_.bad->pop_back();
-        }
-        else if (isIntArray())
+    struct PackedUnpacker_
+    {
+        Tag& list;
+
+        template <typename T>
+        void operator()(Vec<T>*& vec)
         {
-            if (!tagData_.iad || tagData_.iad->empty())
-                throw std::out_of_range("The back member is not exists.");
+            Vec<Tag>* ld = new Vec<Tag>();
 
-            tagData_.iad->pop_back();
+            if (vec)
+            {
+                ld->reserve(vec->size());
+                for (const auto& var : *vec)
+                {
+                    ld->emplace_back(list.itemType_);
+                    storeNum_(ld->back().tagData_.num, var);
+                    ld->back().parent_ = &list;
+                }
+
+                delete asPacked_(vec);
+            }
+
+            list.tagData_.ld = ld;
         }
-        else if (isLongArray())
+    };
+
+    struct PackedPacker_
+    {
+        Tag& list;
+
+        template <typename T>
+        void operator()(Vec<T>*& vec)
         {
-            if (!tagData_.lad || tagData_.lad->empty())
-                throw std::out_of_range("The back member is not exists.");
+            Vec<Tag>* ld = list.tagData_.ld;
+            Vec<T>* packed = new PackedVec_<T>();
 
-            tagData_.lad->pop_back();
+            if (ld)
+            {
+                packed->reserve(ld->size());
+                for (const auto& var : *ld)
+                    packed->emplace_back(loadNum_<T>(var.tagData_.num));
+
+                delete ld;
+            }
+
+            vec = packed;
         }
-        else if (isList())
+    };
+
+    /// @brief Get the count of list items.
+    size_t listSize_() const
+    {
+        if (isPacked_)
         {
-        #ifndef MCNBT_DISABLE_EXCEPTION
-            if (itemType_ == TT_END)
-                throw std::logic_error("Can't read or write a uninitialized list.");
-        #endif
+            PackedCounter_ counter{ 0 };
+            visitPacked_(counter);
+            return counter.count;
+        }
 
-            if (!tagData_.ld || tagData_.ld->empty())
-                throw std::out_of_range("The back member is not exists.");
+        return tagData_.ld ? tagData_.ld->size() : 0;
+    }
+
+    /// @brief Get the item of the packed list as tag without unpack it, for the const references of items.
+    /// @note The items are made once and kept until the list is changed, they can be got by several threads at
+    // the same time, like the other const functions. (See #PackedVec_)
+    const Tag& packedItem_(size_t idx) const
+    {
+        PackedItemGetter_ getter{ *this, idx, nullptr };
+        visitPacked_(getter);
+
+        return *getter.item;
+    }
+
+    /// @brief Convert the packed array to the tags, so that the items can be referenced as tag.
+    void unpack_()
+    {
+        if (!isPackedList_())
+            return;
+
+        PackedUnpacker_ unpacker{ *this };
+        visitPacked_(unpacker);
+        isPacked_ = false;
+    }
+
+    /// @brief Convert the list of numbers to packed array if it is not packed.
+    void pack_()
+    {
+        if (!isList() || isPacked_ || !nbt::isNum(itemType_))
+            return;
+
+        PackedPacker_ packer{ *this };
+        visitPacked_(packer);
+        isPacked_ = true;
+    }
 
-            tagData_.ld->pop_back();
+    /// @brief Release the list items, whether it is packed or not.
+    void releaseList_()
+    {
+        if (isPacked_)
+        {
+            PackedReleaser_ releaser;
+            visitPacked_(releaser);
         }
-        else if (isCompound())
+        else
         {
-            if (!tagData_.cd || tagData_.cd->empty())
-                throw std::out_of_range("The back member is not exists.");
-
-            tagData_.cd->idxs.erase(tagData_.cd->data.back().name());
-            tagData_.cd->data.pop_back();
+            delete tagData_.ld;
         }
 
-        return *this;
+        tagData_.ld = nullptr;
     }
 
-    /// @brief Remove the all elements.
-    /// @attention Only be called via
-    // #TT_STRING, #TT_BYTE_ARRAY, #TT_INT_ARRAY, #TT_LONG_ARRAY, #TT_LIST, #TT_COMPOUND.
-    Tag& removeAll()
+    /// @brief Append the numbers to the array or the list of numbers.
+    /// @param arrayType The type of array can be appended to, #TT_END if none.
+    template <typename T>
+    Tag& appendNumbers_(const T* data, size_t count, TagType arrayType)
     {
-        assert(isString() || isArray() || isContainer());
+        bool isValid = (arrayType != TT_END && tagType_ == arrayType) ||
+                       (isList() && itemType_ == _NumTagType<T>::value);
+        assert(isValid);
     #ifndef MCNBT_DISABLE_EXCEPTION
-        if (!isString() && !isArray() && !isContainer())
-            throw std::logic_error("Can't remove all elements from non-string, non-array, non-container tag.");
+        if (!isValid)
+        {
+            String errmsg = "Can't append the values of " + getTagTypeString(_NumTagType<T>::value);
+            errmsg += " to the " + getTagTypeString(tagType_);
+            throw std::logic_error(errmsg);
+        }
     #endif
 
-        if (isString())
+        pack_();
+
+        Vec<T>*& vec = packedVec_(static_cast<T*>(nullptr));
+        if (!vec)
+            vec = isList() ? new PackedVec_<T>() : new Vec<T>();
+        else if (isList())
+            asPacked_(vec)->clearItems();
+        vec->insert(vec->end(), data, data + count);
+
+        return *this;
+    }
+
+    /// @brief Copy the type and value of the other, but not the name and parent.
+    /// @note The compound data is shared instead of copied unless it is exposed. (See #detach_() and #expose_())
+    void copyData_(const Tag& other)
+    {
+        tagType_ = other.tagType_;
+        itemType_ = other.itemType_;
+        isPacked_ = other.isPacked_;
+
+        if (other.isNum())                                      tagData_.num = other.tagData_.num;
+        else if (other.isString() && other.tagData_.str)        tagData_.str = _retain(other.tagData_.str);
+        else if (other.isByteArray() && other.tagData_.bad)     tagData_.bad = new Vec<Byte>(*other.tagData_.bad);
+        else if (other.isIntArray() && other.tagData_.iad)      tagData_.iad = new Vec<Int32>(*other.tagData_.iad);
+        else if (other.isLongArray() && other.tagData_.lad)     tagData_.lad = new Vec<Int64>(*other.tagData_.lad);
+        else if (other.isPackedList_())
         {
-            if (tagData_.str)
-                tagData_.str->clear();
+            PackedCopier_ copier{ *this };
+            other.visitPacked_(copier);
         }
-        else if (isByteArray())
+        else if (other.isList() && other.tagData_.ld)
         {
-            if (tagData_.bad)
-                tagData_.bad->clear();
+            tagData_.ld = new Vec<Tag>();
+            tagData_.ld->reserve(other.tagData_.ld->size());
+
+            for (const auto& var : *other.tagData_.ld)
+            {
+                tagData_.ld->emplace_back();
+                tagData_.ld->back().copyData_(var);
+                tagData_.ld->back().parent_ = this;
+            }
         }
-        else if (isIntArray())
+        else if (other.isCompound() && other.tagData_.cd)
         {
-            if (tagData_.iad)
-                tagData_.iad->clear();
+            if (other.tagData_.cd->isExposed)
+            {
+                tagData_.cd = copyCompound_(*other.tagData_.cd);
+                for (auto& var : tagData_.cd->data)
+                    var.parent_ = this;
+            }
+            else
+            {
+                tagData_.cd = retainCompound_(other.tagData_.cd);
+            }
         }
-        else if (isLongArray())
+    }
+
+    /// @brief Move the type and value of the other to self, but not the name and parent.
+    /// @note The value of self must be released before.
+    void takeData_(Tag& other)
+    {
+        tagType_    = other.tagType_;
+        itemType_   = other.itemType_;
+        isPacked_   = other.isPacked_;
+        tagData_    = other.tagData_;
+
+        if (isList() && !isPacked_ && tagData_.ld)
         {
-            if (tagData_.lad)
-                tagData_.lad->clear();
+            for (auto& var : *tagData_.ld)
+                var.parent_ = this;
         }
-        else if (isList())
+        else if (isPackedList_())
         {
-        #ifndef MCNBT_DISABLE_EXCEPTION
-            if (itemType_ == TT_END)
-                throw std::logic_error("Can't read or write a uninitialized list.");
-        #endif
-
-            if (tagData_.ld)
-                tagData_.ld->clear();
+            PackedReparenter_ reparenter{ *this };
+            visitPacked_(reparenter);
         }
-        else if (isCompound())
+        else if (isCompound() && tagData_.cd)
         {
-            if (tagData_.cd)
-                tagData_.cd->clear();
+            // The members of shared data have no parent.
+            if (!tagData_.cd->empty() && tagData_.cd->data.front().parent_)
+            {
+                for (auto& var : tagData_.cd->data)
+                    var.parent_ = this;
+            }
         }
 
-        return *this;
+        other.tagData_.str = nullptr;
     }
 
-#ifdef MCNBT_ENABLE_GZIP
-    /// @brief Write the tag to output stream.
-    void write(OStream& os, bool isBigEndian, bool isCompressed = false) const
+    // Functions about the shape of compound. (See #Shape)
+
+    /// @brief Get the pointer to the name, nullptr if no name. (See #nameRef_())
+    const String* namePtr_() const
     {
-        if (isCompressed)
+        const _SharedString* name = nameRef_();
+        return name ? &name->str : nullptr;
+    }
+
+    /// @brief Get the name, from the shape of parent if self has no own name.
+    /// @return nullptr if no name.
+    _SharedString* nameRef_() const
+    {
+        if (tagName_)
+            return tagName_;
+
+        if (parent_ && parent_->isCompound() && parent_->tagData_.cd && parent_->tagData_.cd->shape)
         {
-            SStream ss;
-            write_(ss, isBigEndian, isListItem());
-            os << gzip::compress(ss.str());
+            const CompoundData& cd = *parent_->tagData_.cd;
+            return cd.shape->keys[static_cast<size_t>(this - cd.data.data())];
         }
-        else
+
+        return nullptr;
+    }
+
+    /// @brief Check if the keys of the compound are same as the shape in same order.
+    bool isSameShape_(const Shape& shape) const
+    {
+        if (!tagData_.cd || tagData_.cd->size() != shape.keys.size())
+            return false;
+
+        for (size_t i = 0; i < shape.keys.size(); ++i)
         {
-            write_(os, isBigEndian, isListItem());
+            if (!_isEqual(tagData_.cd->data[i].nameRef_(), shape.keys[i]))
+                return false;
         }
+
+        return true;
     }
 
-    /// @overload
-    void write(const String& filename, bool isBigEndian, bool isCompressed = false) const
+    /// @brief Create the shape from the keys of the compound, and share it.
+    std::shared_ptr<const Shape> makeShape_()
     {
-        OFStream ofs(filename, std::ios_base::binary);
+        std::shared_ptr<Shape> shape = std::make_shared<Shape>();
+        shape->keys.reserve(tagData_.cd->size());
+        for (const auto& var : tagData_.cd->data)
+            shape->keys.emplace_back(_retain(var.nameRef_()));
+        shape->idxs = tagData_.cd->index();
+        shape->order = sortedOrder_(shape->keys);
 
-        if (ofs.is_open())
-            write(ofs, isBigEndian, isCompressed);
-        else
-            throw std::runtime_error("Failed to open file: " + filename);
+        share_(shape);
 
-        ofs.close();
+        return shape;
     }
-#else
-    /// @brief Write the tag to output stream.
-    void write(OStream& os, bool isBigEndian) const { write_(os, isBigEndian, isListItem()); }
 
-    /// @overload
-    void write(const String& filename, bool isBigEndian) const
+    /// @brief Share the shape, the keys of the compound must be same as the shape. (See #isSameShape_())
+    void share_(const std::shared_ptr<const Shape>& shape)
     {
-        OFStream ofs(filename, std::ios_base::binary);
+        CompoundData& cd = *tagData_.cd;
 
-        if (ofs.is_open())
-            write(ofs, isBigEndian);
-        else
-            throw std::runtime_error("Failed to open file: " + filename);
+        for (auto& var : cd.data)
+        {
+            _release(var.tagName_);
+            var.tagName_ = nullptr;
+        }
 
-        ofs.close();
+        Map<String, size_t>().swap(cd.idxs);
+        cd.shape = shape;
     }
-#endif // MCNBT_ENABLE_GZIP
-
-    /// @brief Get the SNBT (The string representation of NBT).
-    /// @param isWrappedIndented If true, the output string will be wrapped and indented.
-    String toSnbt(bool isWrappedIndented = true) const { return toSnbt_(isWrappedIndented, isListItem()); }
 
-    /// @brief Operators overloading.
+    /// @brief Make the compound has its own keys again if it shares the shape.
+    /// @note Must be called before any change of the keys.
+    void unshare_()
+    {
+        if (!isCompound() || !tagData_.cd || !tagData_.cd->shape)
+            return;
 
-    /// @brief Fast way of get the tag by index.
-    Tag& operator[](size_t idx)             { return getTag(idx); }
+        CompoundData& cd = *tagData_.cd;
+        std::shared_ptr<const Shape> shape = std::move(cd.shape);
 
-    /// @overload
-    /// @brief Fast way of get the tag by name.
-    Tag& operator[](const String& name)     { return getTag(name); }
+        cd.idxs = shape->idxs;
+        for (size_t i = 0; i < cd.data.size(); ++i)
+        {
+            if (!cd.data[i].tagName_)
+                cd.data[i].tagName_ = _retain(shape->keys[i]);
+        }
 
-    /// @brief Fast way of add the tag.
-    Tag& operator<<(Tag&& tag)              { return addTag(std::move(tag)); }
+        // The compound being read may has less members than the shape.
+        if (cd.data.size() != shape->keys.size())
+        {
+            cd.idxs.clear();
+            for (size_t i = 0; i < cd.data.size(); ++i)
+                cd.idxs.insert({ shape->keys[i] ? shape->keys[i]->str : String(), i });
+        }
+    }
 
-    /// @overload
-    Tag& operator<<(Tag& tag)               { return addTag(tag); }
+    // Functions about the order of names. (See #canonicalize())
 
-private:
-    // Nums.
-    // Contains interger and float point number.
-    union Num
+    /// @brief Check if the name is less than the other by bytes. (nullptr is empty name)
+    static bool isNameLess_(const _SharedString* lhs, const _SharedString* rhs)
     {
-        Num() : i64(0) {}
+        if (!rhs || rhs->str.empty())
+            return false;
 
-        Byte    i8;
-        Int16   i16;
-        Int32   i32;
-        Int64   i64;
-        Fp32    f32;
-        Fp64    f64;
-    };
+        return !lhs || lhs->str < rhs->str;
+    }
 
-    // A simple wrapper of std::vector<tag> and std::map<string, size_t>.
-    struct CompoundData
+    /// @brief Get the indexes of the names in the order of names.
+    static Vec<size_t> sortedOrder_(const Vec<_SharedString*>& names)
     {
-        Vec<Tag> data;
-        Map<String, size_t> idxs;
+        Vec<size_t> order(names.size());
+        for (size_t i = 0; i < order.size(); ++i)
+            order[i] = i;
 
-        bool empty() const          { return data.empty(); }
+        std::sort(order.begin(), order.end(), [&names](size_t lhs, size_t rhs)
+        { return isNameLess_(names[lhs], names[rhs]); });
 
-        size_t size() const         { return data.size(); }
+        return order;
+    }
 
-        void reserve(size_t size)   { data.reserve(size); idxs.reserve(size); }
+    static bool isSortedOrder_(const Vec<size_t>& order)
+    {
+        for (size_t i = 0; i < order.size(); ++i)
+        {
+            if (order[i] != i)
+                return false;
+        }
 
-        void clear()                { data.clear(); idxs.clear(); }
-    };
+        return true;
+    }
 
-    // Value of tag.
-    // Individual tag is like key-value pair.
-    // The key is the name of tag (can be empty. e.g. All list element not has name).
-    // The value is stored in the following union.
-    union Data
+    /// @brief Create the shape of the keys of the shape in the order of names.
+    static std::shared_ptr<const Shape> sortedShape_(const Shape& shape)
     {
-        Data() : num(Num()) {}
+        std::shared_ptr<Shape> sorted = std::make_shared<Shape>();
+        sorted->keys.reserve(shape.keys.size());
+        sorted->order.reserve(shape.keys.size());
+        for (size_t i = 0; i < shape.order.size(); ++i)
+        {
+            _SharedString* key = shape.keys[shape.order[i]];
+            sorted->keys.emplace_back(_retain(key));
+            sorted->idxs.insert({ key ? key->str : String(), i });
+            sorted->order.emplace_back(i);
+        }
 
-        // Number data
-        Num             num;
-        // String data
-        String*         str;
-        // Byte Array data
-        Vec<Byte>*      bad;
-        // Int Array data
-        Vec<Int32>*     iad;
-        // Long Array data
-        Vec<Int64>*     lad;
-        // List data
-        Vec<Tag>*       ld;
-        // Compound data
-        CompoundData*   cd;
-    };
+        return sorted;
+    }
 
-    /// @brief Get the tag from a binary input stream.
-    /// @param isListItem       Whether the parent is a List tag.
-    /// @param parentType       If the parameter #isListItem is false, ignore this.
-    // Else this must be set to same as the element tag type of parent List.
-    static Tag fromBinStream_(IStream& is, bool isBigEndian, bool isListItem, TagType parentType = TT_END)
+    /// @brief Canonicalize the tag recursively. (See #canonicalize())
+    /// @param from, to The shape of the last compound with shape and its sorted shape, so that the items of list
+    // which share the shape share the sorted shape.
+    void canonicalize_(std::shared_ptr<const Shape>& from, std::shared_ptr<const Shape>& to)
     {
-        Tag tag;
+        if (isList())
+        {
+            if (listSize_() == 0)
+            {
+                releaseList_();
+                isPacked_ = false;
+                itemType_ = TT_END;
+            }
+            else if (!isPacked_)
+            {
+                std::shared_ptr<const Shape> itemFrom;
+                std::shared_ptr<const Shape> itemTo;
+                for (auto& var : *tagData_.ld)
+                    var.canonicalize_(itemFrom, itemTo);
+            }
 
-        // Get the tag type.
-        // If the parent is a List, that is this tag is a list element, get the tag type from parent.
-        // Else get the tag type from stream.
-        if (isListItem)
-            tag.tagType_ = parentType;
-        else
-            tag.tagType_ = static_cast<TagType>(is.get());
+            return;
+        }
 
-        if (tag.tagType_ == TT_END)
-            return tag;
+        if (!isCompound() || !tagData_.cd)
+            return;
 
-        // Get the tag name (key).
-        // If the tag not is a list element obtain the name from stream.
-        if (!isListItem)
+        detach_();
+
+        CompoundData& cd = *tagData_.cd;
+        {
+            std::shared_ptr<const Shape> memberFrom;
+            std::shared_ptr<const Shape> memberTo;
+            for (auto& var : cd.data)
+                var.canonicalize_(memberFrom, memberTo);
+        }
+
+        if (cd.shape && cd.shape->order.size() == cd.size())
         {
-            Int16 nameLen = _bytes2num<Int16>(is, isBigEndian);
-            if (nameLen != 0)
+            if (cd.shape != from)
             {
-                Byte* bytes = new Byte[nameLen];
+                from = cd.shape;
+                to = isSortedOrder_(from->order) ? from : sortedShape_(*from);
+            }
 
-                is.read(bytes, nameLen);
-                tag.tagName_ = new String();
-                tag.tagName_->assign(bytes, static_cast<size_t>(is.gcount()));
+            if (cd.shape == to)
+                return;
 
-                delete[] bytes;
-            }
+            // The members have their own names after moved.
+            reorder_(from->order);
+            share_(to);
+
+            return;
         }
 
-        // Get the tag dat (value).
-        switch (tag.tagType_)
+        unshare_();
+
+        Vec<_SharedString*> names;
+        names.reserve(cd.size());
+        for (const auto& var : cd.data)
+            names.emplace_back(var.tagName_);
+
+        Vec<size_t> order = sortedOrder_(names);
+        if (isSortedOrder_(order))
+            return;
+
+        reorder_(order);
+        for (size_t i = 0; i < cd.size(); ++i)
         {
-            case TT_BYTE:
-                tag.tagData_.num.i8 = _bytes2num<Byte>(is, isBigEndian);
-                break;
-            case TT_SHORT:
-                tag.tagData_.num.i16 = _bytes2num<Int16>(is, isBigEndian);
-                break;
-            case TT_INT:
-                tag.tagData_.num.i32 = _bytes2num<Int32>(is, isBigEndian);
-                break;
-            case TT_LONG:
-                tag.tagData_.num.i64 = _bytes2num<Int64>(is, isBigEndian);
-                break;
-            case TT_FLOAT:
-                tag.tagData_.num.f32 = _bytes2num<Fp32>(is, isBigEndian);
-                break;
-            case TT_DOUBLE:
-                tag.tagData_.num.f64 = _bytes2num<Fp64>(is, isBigEndian);
-                break;
-            case TT_STRING:
-            {
-                Int16 strlen = _bytes2num<Int16>(is, isBigEndian);
+            const String* name = cd.data[i].namePtr_();
+            cd.idxs[name ? *name : String()] = i;
+        }
+    }
 
-                if (strlen != 0)
-                {
-                    Byte* bytes = new Byte[strlen];
+    /// @brief Move the members of compound to the order, and be the parent of them.
+    void reorder_(const Vec<size_t>& order)
+    {
+        CompoundData& cd = *tagData_.cd;
 
-                    is.read(bytes, strlen);
-                    tag.tagData_.str = new String();
-                    tag.tagData_.str->assign(bytes, static_cast<size_t>(is.gcount()));
+        Vec<Tag> data;
+        data.reserve(order.size());
+        for (size_t idx : order)
+            data.emplace_back(std::move(cd.data[idx]));
 
-                    delete[] bytes;
-                }
-                break;
-            }
-            case TT_BYTE_ARRAY:
-            {
-                Int32 dsize = _bytes2num<Int32>(is, isBigEndian);
+        cd.data.swap(data);
+        for (auto& var : cd.data)
+            var.parent_ = this;
+    }
 
-                if (dsize != 0)
-                {
-                    tag.tagData_.bad = new Vec<Byte>();
-                    tag.tagData_.bad->reserve(dsize);
+    // Functions about the shared compound data. (See #CompoundData)
 
-                    for (Int32 i = 0; i < dsize; ++i)
-                        tag.addByte(_bytes2num<Byte>(is, isBigEndian));
-                }
-                break;
-            }
-            case TT_INT_ARRAY:
-            {
-                Int32 dsize = _bytes2num<Int32>(is, isBigEndian);
+    /// @brief Add a tag owner to the compound data.
+    static CompoundData* retainCompound_(CompoundData* cd)
+    {
+        if (!cd->data.empty() && cd->data.front().parent_)
+            orphanMembers_(*cd);
 
-                if (dsize != 0)
-                {
-                    tag.tagData_.iad = new Vec<Int32>();
-                    tag.tagData_.iad->reserve(dsize);
+        // The data may be changed while it is not shared.
+        if (_isUnique(cd->refs))
+            cd->hash.store(0, std::memory_order_relaxed);
 
-                    for (Int32 i = 0; i < dsize; ++i)
-                        tag.addInt(_bytes2num<Int32>(is, isBigEndian));
-                }
-                break;
-            }
-            case TT_LONG_ARRAY:
-            {
-                Int32 dsize = _bytes2num<Int32>(is, isBigEndian);
+        _addRef(cd->refs);
+        return cd;
+    }
 
-                if (dsize != 0)
-                {
-                    tag.tagData_.lad = new Vec<Int64>();
-                    tag.tagData_.lad->reserve(dsize);
+    /// @brief Remove a owner (or the record of #ReadContext_) from the compound data, delete it if no owner.
+    static void releaseCompound_(CompoundData* cd)
+    {
+        if (_subRef(cd->refs))
+            delete cd;
+    }
 
-                    for (Int32 i = 0; i < dsize; ++i)
-                        tag.addLong(_bytes2num<Int64>(is, isBigEndian));
-                }
-                break;
-            }
-            case TT_LIST:
-            {
-                tag.itemType_ = static_cast<TagType>(is.get());
-                Int32 dsize = _bytes2num<Int32>(is, isBigEndian);
+    /// @brief Release the compound data of self.
+    void releaseCompound_()
+    {
+        CompoundData* cd = tagData_.cd;
+        tagData_.cd = nullptr;
 
-                if (dsize != 0)
-                {
-                    tag.tagData_.ld = new Vec<Tag>();
-                    tag.tagData_.ld->reserve(dsize);
+        if (!_isUnique(cd->refs) && !cd->data.empty() && cd->data.front().parent_ == this)
+            orphanMembers_(*cd);
 
-                    for (Int32 i = 0; i < dsize; ++i)
-                        tag.addTag(fromBinStream_(is, isBigEndian, true, tag.itemType_));
-                }
-                break;
-            }
-            case TT_COMPOUND:
-            {
-                while (!is.eof()) {
-                    if (is.peek() == TT_END)
-                    {
-                        // Give up End tag and move stream point to next Byte.
-                        is.get();
-                        break;
-                    }
+        releaseCompound_(cd);
+    }
 
-                    tag.addTag(fromBinStream_(is, isBigEndian, false));
-                }
-                break;
-            }
-            default:
-                throw std::runtime_error("Invalid tag type.");
+    /// @brief Make the members have no parent, so that the data can be shared by several tags.
+    static void orphanMembers_(CompoundData& cd)
+    {
+        for (size_t i = 0; i < cd.data.size(); ++i)
+        {
+            Tag& var = cd.data[i];
+            // The name can't be got from the shape of parent any more.
+            if (!var.tagName_ && cd.shape)
+                var.tagName_ = _retain(cd.shape->keys[i]);
+            var.parent_ = nullptr;
+        }
+    }
+
+    /// @brief Make the compound has its own data if the data is shared, and be the parent of the members.
+    /// @note Must be called before any change of the compound or its members (include get the non-const
+    // reference of member). The members which are compound share the data still, so only the path being
+    // changed is copied.
+    void detach_()
+    {
+        if (!isCompound() || !tagData_.cd)
+            return;
+
+        CompoundData* cd = tagData_.cd;
+        if (!_isUnique(cd->refs))
+        {
+            CompoundData* copy = copyCompound_(*cd);
+            releaseCompound_();
+            tagData_.cd = copy;
+            cd = copy;
+        }
+        else if (cd->encoded)
+        {
+            cd->encoded.reset();
+            cd->span = nullptr;
+            cd->spanSize = 0;
         }
 
-        return tag;
+        if (!cd->data.empty() && cd->data.front().parent_ != this)
+        {
+            for (auto& var : cd->data)
+                var.parent_ = this;
+        }
     }
 
-    /// @todo
-    static Tag fromSnbt_(IStream& snbtSs, TagType parentType);
+    /// @brief Mark the compound data as the non-const references of its members may be held (e.g. got via
+    // operator[]), then the copies of self copy the data instead of share it, else the changes through the
+    // references would be seen by the copies. The mark is kept as the references can't be tracked.
+    void expose_()
+    {
+        if (isCompound() && tagData_.cd)
+            tagData_.cd->isExposed = true;
+    }
 
-    void write_(OStream& os, bool isBigEndian, bool isListItem) const
+    /// @brief Copy the compound data, the members which are compound share the data still unless it is exposed.
+    /// @note The copy has no span and no parent of members, as it may be changed.
+    static CompoundData* copyCompound_(const CompoundData& cd)
     {
-        if (!isListItem)
+        CompoundData* copy = new CompoundData();
+        copy->idxs = cd.idxs;
+        copy->shape = cd.shape;
+        copy->data.reserve(cd.size());
+
+        for (const auto& var : cd.data)
         {
-            os.put(static_cast<Byte>(tagType_));
+            copy->data.emplace_back();
 
-            if (!tagName_ || tagName_->empty())
-            {
-                _num2bytes<Int16>(static_cast<Int16>(0), os, isBigEndian);
-            }
-            else
-            {
-                _num2bytes<Int16>(static_cast<Int16>(tagName_->size()), os, isBigEndian);
-                os.write(tagName_->c_str(), tagName_->size());
-            }
+            Tag& tag = copy->data.back();
+            tag.copyData_(var);
+            tag.tagName_ = _retain(var.tagName_);
         }
 
-        switch (tagType_)
-        {
-            case TT_END:
-                os.put(TT_END);
-                break;
-            case TT_BYTE:
-                os.put(tagData_.num.i8);
-                break;
-            case TT_SHORT:
-                _num2bytes<Int16>(tagData_.num.i16, os, isBigEndian);
-                break;
-            case TT_INT:
-                _num2bytes<Int32>(tagData_.num.i32, os, isBigEndian);
-                break;
-            case TT_LONG:
-                _num2bytes<Int64>(tagData_.num.i64, os, isBigEndian);
-                break;
-            case TT_FLOAT:
-                _num2bytes<Fp32>(tagData_.num.f32, os, isBigEndian);
-                break;
-            case TT_DOUBLE:
-                _num2bytes<Fp64>(tagData_.num.f64, os, isBigEndian);
-                break;
-            case TT_STRING:
-            {
-                if (!tagData_.str || tagData_.str->empty())
-                {
-                    _num2bytes<Int16>(static_cast<Int16>(0), os, isBigEndian);
-                    break;
-                }
-
-                _num2bytes<Int16>(static_cast<Int16>(tagData_.str->size()), os, isBigEndian);
-                os.write(tagData_.str->c_str(), tagData_.str->size());
+        return copy;
+    }
 
-                break;
-            }
-            case TT_BYTE_ARRAY:
-            {
-                if (!tagData_.bad || tagData_.bad->empty())
-                {
-                    _num2bytes<Int32>(static_cast<Int32>(0), os, isBigEndian);
-                    break;
-                }
+    // Functions about the hash and comparison of value.
 
-                _num2bytes<Int32>(static_cast<Int32>(tagData_.bad->size()), os, isBigEndian);
+    template <typename T>
+    static UInt64 hashVec_(const Vec<T>* vec, UInt64 seed)
+    { return vec ? _hashBytes(vec->data(), vec->size() * sizeof(T), seed) : _hashBytes(nullptr, 0, seed); }
 
-                for (const auto& var : *tagData_.bad)
-                    os.put(var);
+    template <typename T>
+    static bool isSameVec_(const Vec<T>* lhs, const Vec<T>* rhs)
+    {
+        size_t size = lhs ? lhs->size() : 0;
+        if (size != (rhs ? rhs->size() : 0))
+            return false;
 
-                break;
-            }
-            case TT_INT_ARRAY:
-            {
-                if (!tagData_.iad || tagData_.iad->empty())
-                {
-                    _num2bytes<Int32>(static_cast<Int32>(0), os, isBigEndian);
-                    break;
-                }
+        return size == 0 || std::memcmp(lhs->data(), rhs->data(), size * sizeof(T)) == 0;
+    }
 
-                _num2bytes<Int32>(static_cast<Int32>(tagData_.iad->size()), os, isBigEndian);
+    struct PackedHasher_
+    {
+        UInt64 hash;
 
-                for (const auto& var : *tagData_.iad)
-                    _num2bytes<Int32>(var, os, isBigEndian);
+        template <typename T>
+        void operator()(const Vec<T>* vec) { hash = hashVec_(vec, hash); }
+    };
 
-                break;
-            }
-            case TT_LONG_ARRAY:
-            {
-                if (!tagData_.lad || tagData_.lad->empty())
-                {
-                    _num2bytes<Int32>(static_cast<Int32>(0), os, isBigEndian);
-                    break;
-                }
+    struct PackedComparer_
+    {
+        const Tag& other;
+        bool isSame;
 
-                _num2bytes<Int32>(static_cast<Int32>(tagData_.lad->size()), os, isBigEndian);
+        template <typename T>
+        void operator()(const Vec<T>* vec)
+        { isSame = isSameVec_(vec, const_cast<Tag&>(other).packedVec_(static_cast<T*>(nullptr))); }
+    };
 
-                for (const auto& var : *tagData_.lad)
-                    _num2bytes<Int64>(var, os, isBigEndian);
+    /// @brief Get the hash of the value of the tag which is not container, or is empty or packed list.
+    // The hash of the other container is combined by the hashes of its items. (See #hashValue_())
+    UInt64 leafHash_() const
+    {
+        UInt64 hash = tagType_;
 
-                break;
-            }
+        switch (tagType_)
+        {
+            case TT_BYTE:       return _hashMix(hash, static_cast<UChar>(tagData_.num.i8));
+            case TT_SHORT:      return _hashMix(hash, static_cast<UInt16>(tagData_.num.i16));
+            case TT_INT:        return _hashMix(hash, static_cast<UInt32>(tagData_.num.i32));
+            case TT_LONG:       return _hashMix(hash, static_cast<UInt64>(tagData_.num.i64));
+            case TT_FLOAT:      return _hashMix(hash, loadNum_<UInt32>(tagData_.num));
+            case TT_DOUBLE:     return _hashMix(hash, loadNum_<UInt64>(tagData_.num));
+            case TT_STRING:     return _hashMix(hash, _hashString(tagData_.str));
+            case TT_BYTE_ARRAY: return hashVec_(tagData_.bad, hash);
+            case TT_INT_ARRAY:  return hashVec_(tagData_.iad, hash);
+            case TT_LONG_ARRAY: return hashVec_(tagData_.lad, hash);
             case TT_LIST:
             {
-                if (!tagData_.ld || tagData_.ld->empty())
-                {
-                    os.put(static_cast<Byte>(TT_END));
-                    _num2bytes<Int32>(static_cast<Int32>(0), os, isBigEndian);
-                    break;
-                }
-
-                os.put(static_cast<Byte>(itemType_));
-                _num2bytes<Int32>(static_cast<Int32>(tagData_.ld->size()), os, isBigEndian);
-
-                for (const auto& var : *tagData_.ld)
-                    var.write_(os, isBigEndian, true);
-
-                break;
-            }
-            case TT_COMPOUND:
-            {
-                if (!tagData_.cd || tagData_.cd->data.empty())
-                {
-                    os.put(TT_END);
-                    break;
-                }
-
-                for (const auto& var : tagData_.cd->data)
-                    var.write_(os, isBigEndian, false);
-
-                os.put(TT_END);
-
-                break;
+                PackedHasher_ hasher{ _hashMix(hash, itemType_) };
+                if (isPacked_)
+                    visitPacked_(hasher);
+                return hasher.hash;
             }
-            default:
-                throw std::runtime_error("Invalid tag type.");
+            case TT_COMPOUND:   return hash;
+            default:            return hash;
         }
     }
 
-    String toSnbt_(bool isWrappedIndented, bool isListItem) const
+    /// @brief Get the hash of the type and value. (See #hash())
+    // Same as the hash computed while reading. (See #readValue_())
+    UInt64 hashValue_() const
     {
-        static size_t indentCount = 0;
-
-        String inheritedIndentStr(indentCount * _SNBT_INDENT_WIDTH, ' ');
-        String key = isWrappedIndented ? inheritedIndentStr : "";
-
-        if (!isListItem && !name().empty())
-            key += name() + (isWrappedIndented ? ": " : ":");
-
-        switch (type())
+        if (isList() && !isPacked_)
         {
-            case TT_END:        return "";
-            case TT_BYTE:       return key + std::to_string(static_cast<int>(tagData_.num.i8)) + 'b';
-            case TT_SHORT:      return key + std::to_string(tagData_.num.i16) + 's';
-            case TT_INT:        return key + std::to_string(tagData_.num.i32);
-            case TT_LONG:       return key + std::to_string(tagData_.num.i64) + 'l';
-            case TT_FLOAT:      return key + std::to_string(tagData_.num.f32) + 'f';
-            case TT_DOUBLE:     return key + std::to_string(tagData_.num.f64) + 'd';
-            case TT_STRING:     return key + '"' + (tagData_.str ? *tagData_.str : "") + '"';
-            case TT_BYTE_ARRAY:
+            // The hash of list of numbers is the hash of the packed array.
+            if (nbt::isNum(itemType_))
             {
-                if (!tagData_.bad || tagData_.bad->empty())
-                    return key + "[B;]";
+                Tag packed;
+                packed.copyData_(*this);
+                packed.pack_();
+                return packed.leafHash_();
+            }
 
-                // If has indent add the newline character and indent string.
-                String snbt = key + '[';
-                snbt += isWrappedIndented ? ('\n' + inheritedIndentStr + _SNBT_INDENT_STR) : "";
-                snbt += "B;";
+            UInt64 hash = _hashMix(TT_LIST, itemType_);
+            if (tagData_.ld)
+            {
+                for (const auto& var : *tagData_.ld)
+                    hash = _hashMix(hash, var.hashValue_());
+            }
+            return hash;
+        }
 
-                for (const auto& var : *tagData_.bad)
-                {
-                    snbt += isWrappedIndented ? ('\n' + inheritedIndentStr + _SNBT_INDENT_STR) : "";
-                    snbt += std::to_string(static_cast<int>(var)) + "b,";
-                }
+        if (isCompound() && tagData_.cd)
+            return hashCompound_(*tagData_.cd);
 
-                if (snbt.back() == ',')
-                    snbt.pop_back();
+        return leafHash_();
+    }
 
-                snbt += isWrappedIndented ? ('\n' + inheritedIndentStr) : "";
-                snbt += ']';
+    /// @brief Get the hash of the keys and values of the members, use the cached hash if the data is shared.
+    static UInt64 hashCompound_(const CompoundData& cd)
+    {
+        UInt64 hash = cachedHash_(cd);
+        if (hash != 0)
+            return hash;
 
-                return snbt;
-            }
-            case TT_INT_ARRAY:
-            {
-                if (!tagData_.iad || tagData_.iad->empty())
-                    return key + "[I;]";
+        hash = TT_COMPOUND;
+        for (const auto& var : cd.data)
+        {
+            hash = _hashMix(hash, _hashString(var.nameRef_()));
+            hash = _hashMix(hash, var.hashValue_());
+        }
 
-                // If has indent add the newline character and indent string.
-                String snbt = key + '[';
-                snbt += isWrappedIndented ? ('\n' + inheritedIndentStr + _SNBT_INDENT_STR) : "";
-                snbt += "I;";
+        // Only the shared data is immutable.
+        if (!_isUnique(cd.refs))
+            cd.hash.store(hash, std::memory_order_relaxed);
 
-                for (const auto& var : *tagData_.iad)
-                {
-                    snbt += isWrappedIndented ? ('\n' + inheritedIndentStr + _SNBT_INDENT_STR) : "";
-                    snbt += std::to_string(var) + ",";
-                }
+        return hash;
+    }
 
-                if (snbt.back() == ',')
-                    snbt.pop_back();
+    /// @brief Get the cached hash of the compound data, 0 if no cached hash.
+    static UInt64 cachedHash_(const CompoundData& cd)
+    { return _isUnique(cd.refs) ? 0 : cd.hash.load(std::memory_order_relaxed); }
 
-                snbt += isWrappedIndented ? ('\n' + inheritedIndentStr) : "";
-                snbt += ']';
+    /// @brief Check if the keys and values of the members of two compounds are same in same order.
+    static bool isSameCompound_(const CompoundData& lhs, const CompoundData& rhs)
+    {
+        if (&lhs == &rhs)
+            return true;
 
-                return snbt;
-            }
-            case TT_LONG_ARRAY:
-            {
-                if (!tagData_.lad || tagData_.lad->empty())
-                    return key + "[L;]";
+        if (lhs.size() != rhs.size())
+            return false;
 
-                // If has indent add the newline character and indent string.
-                String snbt = key + '[';
-                snbt += isWrappedIndented ? ('\n' + inheritedIndentStr + _SNBT_INDENT_STR) : "";
-                snbt += "L;";
+        UInt64 lhash = cachedHash_(lhs);
+        UInt64 rhash = cachedHash_(rhs);
+        if (lhash != 0 && rhash != 0 && lhash != rhash)
+            return false;
 
-                for (const auto& var : *tagData_.lad)
-                {
-                    snbt += isWrappedIndented ? ('\n' + inheritedIndentStr + _SNBT_INDENT_STR) : "";
-                    snbt += std::to_string(var) + "l,";
-                }
+        for (size_t i = 0; i < lhs.size(); ++i)
+        {
+            if (!_isEqual(lhs.data[i].nameRef_(), rhs.data[i].nameRef_()) ||
+                !isSameValue_(lhs.data[i], rhs.data[i]))
+                return false;
+        }
 
-                if (snbt.back() == ',')
-                    snbt.pop_back();
+        return true;
+    }
 
-                snbt += isWrappedIndented ? ('\n' + inheritedIndentStr) : "";
-                snbt += ']';
+    /// @brief Check if the types and values (not names) of two tags are same, the numbers are compared by bits.
+    static bool isSameValue_(const Tag& lhs, const Tag& rhs)
+    {
+        if (lhs.tagType_ != rhs.tagType_)
+            return false;
 
-                return snbt;
-            }
+        switch (lhs.tagType_)
+        {
+            case TT_BYTE:       return lhs.tagData_.num.i8 == rhs.tagData_.num.i8;
+            case TT_SHORT:      return lhs.tagData_.num.i16 == rhs.tagData_.num.i16;
+            case TT_INT:        return lhs.tagData_.num.i32 == rhs.tagData_.num.i32;
+            case TT_LONG:       return lhs.tagData_.num.i64 == rhs.tagData_.num.i64;
+            case TT_FLOAT:      return loadNum_<UInt32>(lhs.tagData_.num) == loadNum_<UInt32>(rhs.tagData_.num);
+            case TT_DOUBLE:     return loadNum_<UInt64>(lhs.tagData_.num) == loadNum_<UInt64>(rhs.tagData_.num);
+            case TT_STRING:     return _isEqual(lhs.tagData_.str, rhs.tagData_.str);
+            case TT_BYTE_ARRAY: return isSameVec_(lhs.tagData_.bad, rhs.tagData_.bad);
+            case TT_INT_ARRAY:  return isSameVec_(lhs.tagData_.iad, rhs.tagData_.iad);
+            case TT_LONG_ARRAY: return isSameVec_(lhs.tagData_.lad, rhs.tagData_.lad);
             case TT_LIST:
             {
-                if (!tagData_.ld || tagData_.ld->empty())
-                    return key + "[]";
+                if (lhs.itemType_ != rhs.itemType_ || lhs.listSize_() != rhs.listSize_())
+                    return false;
 
-                String snbt = key + '[';
-
-                indentCount++;
-                for (const auto& var : *tagData_.ld)
+                if (lhs.isPacked_ || rhs.isPacked_)
                 {
-                    snbt += isWrappedIndented ? "\n" : "";
-                    snbt += var.toSnbt_(isWrappedIndented, true) + ",";
-                }
-                indentCount--;
-
-                if (snbt.back() == ',')
-                    snbt.pop_back();
+                    // Compare the packed arrays.
+                    Tag packed;
+                    const Tag* l = &lhs;
+                    const Tag* r = &rhs;
+                    if (!l->isPacked_ || !r->isPacked_)
+                    {
+                        packed.copyData_(l->isPacked_ ? *r : *l);
+                        packed.pack_();
+                        (l->isPacked_ ? r : l) = &packed;
+                    }
 
-                snbt += isWrappedIndented ? ('\n' + inheritedIndentStr) : "";
-                snbt += ']';
+                    PackedComparer_ comparer{ *r, false };
+                    l->visitPacked_(comparer);
+                    return comparer.isSame;
+                }
 
-                return snbt;
+                for (size_t i = 0; i < lhs.listSize_(); ++i)
+                {
+                    if (!isSameValue_((*lhs.tagData_.ld)[i], (*rhs.tagData_.ld)[i]))
+                        return false;
+                }
+                return true;
             }
             case TT_COMPOUND:
             {
-                if (!tagData_.cd || tagData_.cd->data.empty())
-                    return key + "{}";
-
-                String snbt = key + "{";
-
-                indentCount++;
-                for (const auto& var : tagData_.cd->data)
-                {
-                    snbt += isWrappedIndented ? "\n" : "";
-                    snbt += var.toSnbt_(isWrappedIndented, false) + ",";
-                }
-                indentCount--;
-
-                if (snbt.back() == ',')
-                    snbt.pop_back();
-
-                snbt += isWrappedIndented ? ('\n' + inheritedIndentStr) : "";
-                snbt += '}';
-
-                return snbt;
+                const CompoundData* l = lhs.tagData_.cd;
+                const CompoundData* r = rhs.tagData_.cd;
+                if (!l || !r)
+                    return (l ? l->size() : 0) == (r ? r->size() : 0);
+                return isSameCompound_(*l, *r);
             }
             default:
-                throw std::runtime_error("Invalid tag type.");
+                return true;
         }
     }
 
@@ -2438,25 +6670,54 @@ private:
     // (e.g. tag name and tag value.)
     void release_()
     {
-        if (isString() && tagData_.str)             delete tagData_.str;
+        if (isString())                             _release(tagData_.str);
         else if (isByteArray() && tagData_.bad)     delete tagData_.bad;
         else if (isIntArray() && tagData_.iad)      delete tagData_.iad;
         else if (isLongArray() && tagData_.lad)     delete tagData_.lad;
-        else if (isList() && tagData_.ld)           delete tagData_.ld;
-        else if (isCompound() && tagData_.cd)       delete tagData_.cd;
+        else if (isList())                          releaseList_();
+        else if (isCompound() && tagData_.cd)       releaseCompound_();
         tagData_.str = nullptr;
+        isPacked_ = false;
 
-        if (tagName_)
+        _release(tagName_);
+        tagName_ = nullptr;
+    }
+
+    /// @brief Replace the string with the same string in pool.
+    static void intern_(_SharedString*& str, StringPool& pool)
+    {
+        _SharedString* interned = pool.intern_(str);
+        _release(str);
+        str = interned;
+    }
+
+    /// @brief Get the string value to modify, copy it first if it is shared.
+    String& mutableString_()
+    {
+        if (!tagData_.str)
         {
-            delete tagName_;
-            tagName_ = nullptr;
+            tagData_.str = new _SharedString(String());
+        }
+        else if (_isShared(tagData_.str))
+        {
+            _SharedString* str = new _SharedString(tagData_.str->str);
+            _release(tagData_.str);
+            tagData_.str = str;
+        }
+        else
+        {
+            // The string will be changed.
+            tagData_.str->hash = 0;
         }
+
+        return tagData_.str->str;
     }
 
     TagType tagType_    = TT_END;
     TagType itemType_   = TT_END;    ///< Tag type of the list items. Just usefull for list tag.
+    bool isPacked_      = false;     ///< Whether the list items are stored as packed array of numbers.
     Data tagData_;
-    String* tagName_    = nullptr;
+    _SharedString* tagName_ = nullptr;
     Tag* parent_        = nullptr;
 };
 
@@ -2577,4 +6838,16 @@ inline Tag gCompound(const String& name = "")
 
 } // namespace nbt
 
+namespace std
+{
+
+/// @brief The hash of tag, so that the tag can be the key of unordered containers. (See #nbt::Tag::hash())
+template <>
+struct hash<nbt::Tag>
+{
+    size_t operator()(const nbt::Tag& tag) const { return static_cast<size_t>(tag.hash()); }
+};
+
+} // namespace std
+
 #endif // !MCNBT_MCNBT_HPP
@@ -0,0 +1,904 @@
+#ifndef MCNBT_PATCH_HPP
+#define MCNBT_PATCH_HPP
+
+#include <cstring>
+#include <unordered_map>
+
+#include "mcnbt.hpp"
+
+namespace nbt
+{
+
+// The structural diff of two tag trees, and apply it to the tag.
+// Only the subtrees which are not equal are walked, they are found by the hashes of subtrees (each tag is hashed
+// once), and the unchanged copies (see Tag::copy()) are skipped in O(1), so the diff is linear time.
+
+enum PatchOpType : Byte
+{
+    PO_SET              = 1,    ///< Set the value of the target.
+    PO_INSERT           = 2,    ///< Insert the member #PatchOp::key to the target compound.
+    PO_REMOVE           = 3,    ///< Remove the member #PatchOp::key from the target compound.
+    PO_SPLICE           = 4,    ///< Replace #PatchOp::count items of the target list from #PatchOp::index
+                                // with the items of the value (a list).
+    PO_REPLACE_RANGE    = 5     ///< Replace #PatchOp::count numbers of the target array or list of numbers
+                                // from #PatchOp::index with the numbers of the value (a list of numbers).
+};
+
+/// @brief The step of the path from the root to the target, the member name of compound or the item index of list.
+struct PatchStep
+{
+    PatchStep(const String& name) : name(name) {}
+
+    PatchStep(const char* name) : name(name) {}
+
+    PatchStep(size_t index) : index(index), isIndex(true) {}
+
+    PatchStep(int index) : index(static_cast<size_t>(index)), isIndex(true) {}
+
+    String name;
+    size_t index    = 0;
+    bool isIndex    = false;
+};
+
+struct PatchOp
+{
+    PatchOpType type    = PO_SET;
+    Vec<PatchStep> path;            ///< The path from the root to the target.
+    String key;                     ///< The member name of #PO_INSERT and #PO_REMOVE.
+    size_t index        = 0;        ///< The first index of #PO_SPLICE and #PO_REPLACE_RANGE.
+    size_t count        = 0;        ///< The count of the removed items of #PO_SPLICE and #PO_REPLACE_RANGE.
+    Tag value;                      ///< The value of #PO_SET, #PO_INSERT, #PO_SPLICE and #PO_REPLACE_RANGE.
+};
+
+/// @brief The ordered operations which change a tag to another. (See #diff() and #apply())
+class Patch
+{
+public:
+    bool isEmpty() const                { return ops_.empty(); }
+
+    size_t size() const                 { return ops_.size(); }
+
+    const Vec<PatchOp>& ops() const     { return ops_; }
+
+    void add(PatchOp&& op)              { ops_.emplace_back(std::move(op)); }
+
+    /// @brief Get the tag of the patch, for write it as the binary NBT (or SNBT).
+    // {ops: [{op: 1b, path: [I; 0, -1], names: ["name"], key: "", index: 0, count: 0, value: ...}]}
+    // The item of "path" is the item index of list, or -1 for the next name of "names".
+    /// @note The fields which not used by the operation type are omitted.
+    Tag toTag() const
+    {
+        Tag tag = gCompound();
+        Tag ops = gList(TT_COMPOUND, "ops");
+
+        for (const auto& op : ops_)
+        {
+            Tag opTag = gCompound();
+            opTag << gByte(op.type, "op");
+
+            Vec<Int32> path;
+            Tag names = gList(TT_STRING, "names");
+            for (const auto& step : op.path)
+            {
+                if (step.isIndex)
+                {
+                    path.push_back(static_cast<Int32>(step.index));
+                }
+                else
+                {
+                    path.push_back(-1);
+                    names << gString(step.name);
+                }
+            }
+            opTag << gIntArray(path, "path");
+            if (!names.isEmpty())
+                opTag << names;
+
+            if (op.type == PO_INSERT || op.type == PO_REMOVE)
+                opTag << gString(op.key, "key");
+
+            if (op.type == PO_SPLICE || op.type == PO_REPLACE_RANGE)
+            {
+                opTag << gInt(static_cast<Int32>(op.index), "index");
+                opTag << gInt(static_cast<Int32>(op.count), "count");
+            }
+
+            if (op.type != PO_REMOVE)
+                opTag << op.value.copy().setName("value");
+
+            ops << opTag;
+        }
+
+        tag << ops;
+
+        return tag;
+    }
+
+    /// @brief Get the patch from the tag which is got by #toTag().
+    static Patch fromTag(const Tag& tag)
+    {
+        if (!tag.isCompound() || !tag.hasTag("ops") || tag["ops"].type() != TT_LIST)
+            throw std::runtime_error("Invalid patch.");
+
+        const Tag& ops = tag["ops"];
+        if (!ops.isEmpty() && ops.listItemType() != TT_COMPOUND)
+            throw std::runtime_error("Invalid patch.");
+
+        Patch patch;
+        for (size_t i = 0; i < ops.size(); ++i)
+        {
+            const Tag& opTag = ops[i];
+            if (!hasField_(opTag, "op", TT_BYTE) || !hasField_(opTag, "path", TT_INT_ARRAY))
+                throw std::runtime_error("Invalid patch.");
+
+            PatchOp op;
+            Byte type = opTag["op"].getByte();
+            if (type < PO_SET || type > PO_REPLACE_RANGE)
+                throw std::runtime_error("Invalid patch.");
+            op.type = static_cast<PatchOpType>(type);
+
+            const Tag* names = opTag.hasTag("names") ? &opTag["names"] : nullptr;
+            size_t nameIdx = 0;
+            for (Int32 step : opTag["path"].getIntArray())
+            {
+                if (step >= 0)
+                {
+                    op.path.emplace_back(static_cast<size_t>(step));
+                    continue;
+                }
+
+                if (!names || !names->isList() || nameIdx >= names->size() ||
+                    names->listItemType() != TT_STRING)
+                    throw std::runtime_error("Invalid patch.");
+                op.path.emplace_back((*names)[nameIdx++].getString());
+            }
+
+            if (op.type == PO_INSERT || op.type == PO_REMOVE)
+            {
+                if (!hasField_(opTag, "key", TT_STRING))
+                    throw std::runtime_error("Invalid patch.");
+                op.key = opTag["key"].getString();
+            }
+
+            if (op.type == PO_SPLICE || op.type == PO_REPLACE_RANGE)
+            {
+                if (!hasField_(opTag, "index", TT_INT) || !hasField_(opTag, "count", TT_INT) ||
+                    opTag["index"].getInt() < 0 || opTag["count"].getInt() < 0)
+                    throw std::runtime_error("Invalid patch.");
+                op.index = static_cast<size_t>(opTag["index"].getInt());
+                op.count = static_cast<size_t>(opTag["count"].getInt());
+            }
+
+            if (op.type != PO_REMOVE)
+            {
+                if (!opTag.hasTag("value"))
+                    throw std::runtime_error("Invalid patch.");
+                op.value = opTag["value"].copy();
+            }
+
+            patch.add(std::move(op));
+        }
+
+        return patch;
+    }
+
+private:
+    static bool hasField_(const Tag& tag, const String& name, TagType type)
+    { return tag.hasTag(name) && tag[name].type() == type; }
+
+    Vec<PatchOp> ops_;
+};
+
+inline Vec<Byte> _getArray(const Tag& tag, Byte*)      { return tag.getByteArray(); }
+inline Vec<Int32> _getArray(const Tag& tag, Int32*)    { return tag.getIntArray(); }
+inline Vec<Int64> _getArray(const Tag& tag, Int64*)    { return tag.getLongArray(); }
+
+// The arrays of other numbers are not exist.
+template <typename T>
+inline Vec<T> _getArray(const Tag&, T*)                { return Vec<T>(); }
+
+inline void _setArray(Tag& tag, const Vec<Byte>& value)     { tag.setByteArray(value); }
+inline void _setArray(Tag& tag, const Vec<Int32>& value)    { tag.setIntArray(value); }
+inline void _setArray(Tag& tag, const Vec<Int64>& value)    { tag.setLongArray(value); }
+
+template <typename T>
+inline void _setArray(Tag&, const Vec<T>&) {}
+
+/// @brief The numbers of the array or the list of numbers, the packed array of list is read in place.
+template <typename T>
+struct _Numbers
+{
+    Vec<T> copied;              ///< The copy of the numbers which are not stored as packed array.
+    const T* data = nullptr;
+    size_t size = 0;
+
+    explicit _Numbers(const Tag& tag)
+    {
+        if (tag.isList() && tag.isPacked())
+        {
+            const Vec<T>& vec = tag.listData<T>();
+            data = vec.data();
+            size = vec.size();
+            return;
+        }
+
+        copied.resize(tag.size());
+        size = tag.copyNumbers(copied.data(), copied.size());
+        data = copied.data();
+    }
+};
+
+/// @brief Generate the patch from a tag to another.
+class _Differ
+{
+public:
+    Patch run(const Tag& from, const Tag& to)
+    {
+        // The trees are compared once before hash them, which is faster if they are equal, and stops at the first
+        // difference if not.
+        if (!from.equals(to))
+            diff(from, to);
+
+        Patch patch;
+        for (auto& op : ops_)
+            patch.add(std::move(op));
+
+        return patch;
+    }
+
+private:
+    // The max distance of the list items which are searched for the resync after the items are inserted or removed.
+    static constexpr size_t kLookahead = 16;
+
+    // The unchanged copies share the compound data (see Tag::copy()) and are skipped in O(1), the others are
+    // compared by the hashes of subtrees first, so the changed subtrees are not compared deeply, and the same
+    // subtrees are compared once (to be sure they are not the collision of hashes) then skipped.
+    bool isEqual(const Tag& lhs, const Tag& rhs)
+    { return lhs.isSharedWith(rhs) || (hashOf(lhs) == hashOf(rhs) && lhs.equals(rhs)); }
+
+    // Get the hash of the tag, which is same for the equal tags (see Tag::equals()). The hashes of the members and
+    // items are got while computing it, and the hashes of containers are kept, so each tag is hashed once or twice.
+    UInt64 hashOf(const Tag& tag)
+    {
+        // The string, array and list of numbers.
+        if (!tag.isCompound() && (!tag.isList() || isNum(tag.listItemType())))
+            return tag.hash();
+
+        auto it = hashes_.find(&tag);
+        if (it != hashes_.end())
+            return it->second;
+
+        UInt64 hash = 0;
+        if (tag.isCompound())
+        {
+            hash = TT_COMPOUND;
+            for (size_t i = 0; i < tag.size(); ++i)
+            {
+                const Tag& member = tag[i];
+                String name = member.name();
+                hash = _hashMix(hash, _hashBytes(name.data(), name.size()));
+                hash = _hashMix(hash, hashOf(member));
+            }
+        }
+        else
+        {
+            hash = _hashMix(TT_LIST, tag.listItemType());
+            for (size_t i = 0; i < tag.size(); ++i)
+                hash = _hashMix(hash, hashOf(tag[i]));
+        }
+
+        hashes_.emplace(&tag, hash);
+        return hash;
+    }
+
+    PatchOp& emit(PatchOpType type)
+    {
+        PatchOp op;
+        op.type = type;
+        op.path = path_;
+        ops_.emplace_back(std::move(op));
+
+        return ops_.back();
+    }
+
+    void diff(const Tag& from, const Tag& to)
+    {
+        if (isEqual(from, to))
+            return;
+
+        if (from.type() != to.type() || (from.isList() && from.listItemType() != to.listItemType()))
+        {
+            emit(PO_SET).value = to.copy();
+            return;
+        }
+
+        switch (to.type())
+        {
+            case TT_COMPOUND:
+                compound(from, to);
+                break;
+            case TT_LIST:
+                switch (to.listItemType())
+                {
+                    case TT_BYTE:   numbers<Byte>(from, to);    break;
+                    case TT_SHORT:  numbers<Int16>(from, to);   break;
+                    case TT_INT:    numbers<Int32>(from, to);   break;
+                    case TT_LONG:   numbers<Int64>(from, to);   break;
+                    case TT_FLOAT:  numbers<Fp32>(from, to);    break;
+                    case TT_DOUBLE: numbers<Fp64>(from, to);    break;
+                    default:        list(from, to);             break;
+                }
+                break;
+            case TT_BYTE_ARRAY:
+                numbers<Byte>(from, to);
+                break;
+            case TT_INT_ARRAY:
+                numbers<Int32>(from, to);
+                break;
+            case TT_LONG_ARRAY:
+                numbers<Int64>(from, to);
+                break;
+            default:
+                emit(PO_SET).value = to.copy();
+                break;
+        }
+    }
+
+    // The removed members are removed first, the common members keep the order of the source and are diffed
+    // in place, the new members are inserted to the back. If the order of the target can't be kept by this way,
+    // the members since the first one out of the order are removed and inserted to the back again.
+    void compound(const Tag& from, const Tag& to)
+    {
+        Vec<String> commons;
+        for (size_t i = 0; i < from.size(); ++i)
+        {
+            String name = from[i].name();
+            if (to.hasTag(name))
+                commons.emplace_back(std::move(name));
+            else
+                emit(PO_REMOVE).key = std::move(name);
+        }
+
+        size_t k = 0;
+        bool isAppending = false;
+        for (size_t i = 0; i < to.size(); ++i)
+        {
+            const Tag& member = to[i];
+            String name = member.name();
+
+            if (!isAppending && k < commons.size() && commons[k] == name)
+            {
+                ++k;
+                path_.emplace_back(name);
+                diff(from[name], member);
+                path_.pop_back();
+                continue;
+            }
+
+            isAppending = true;
+            if (from.hasTag(name))
+                emit(PO_REMOVE).key = name;
+
+            PatchOp& op = emit(PO_INSERT);
+            op.key = name;
+            op.value = member.copy();
+        }
+    }
+
+    void list(const Tag& from, const Tag& to)
+    {
+        size_t fend = from.size();
+        size_t tend = to.size();
+        while (fend > 0 && tend > 0 && isEqual(from[fend - 1], to[tend - 1]))
+        {
+            --fend;
+            --tend;
+        }
+
+        size_t i = 0;
+        size_t j = 0;
+        while (i < fend && j < tend)
+        {
+            if (isEqual(from[i], to[j]))
+            {
+                ++i;
+                ++j;
+                continue;
+            }
+
+            // Find the nearest items which are equal, that is some items are removed or inserted.
+            size_t removed = 0;
+            size_t inserted = 0;
+            for (size_t d = 1; d <= kLookahead; ++d)
+            {
+                if (i + d < fend && isEqual(from[i + d], to[j]))
+                {
+                    removed = d;
+                    break;
+                }
+
+                if (j + d < tend && isEqual(from[i], to[j + d]))
+                {
+                    inserted = d;
+                    break;
+                }
+            }
+
+            if (removed != 0 || inserted != 0)
+            {
+                splice(to, j, removed, inserted);
+                i += removed;
+                j += inserted;
+                continue;
+            }
+
+            path_.emplace_back(j);
+            diff(from[i], to[j]);
+            path_.pop_back();
+
+            ++i;
+            ++j;
+        }
+
+        if (i < fend || j < tend)
+            splice(to, j, fend - i, tend - j);
+    }
+
+    // The items of the list after the index j are same as the source, the target is got by this.
+    void splice(const Tag& to, size_t j, size_t removed, size_t inserted)
+    {
+        PatchOp& op = emit(PO_SPLICE);
+        op.index = j;
+        op.count = removed;
+        op.value = gList(to.listItemType());
+
+        for (size_t k = j; k < j + inserted; ++k)
+            op.value << to[k].copy();
+    }
+
+    // Replace the range between the common prefix and suffix.
+    template <typename T>
+    void numbers(const Tag& from, const Tag& to)
+    {
+        _Numbers<T> lhs(from);
+        _Numbers<T> rhs(to);
+
+        size_t prefix = 0;
+        size_t maxPrefix = std::min(lhs.size, rhs.size);
+        while (prefix < maxPrefix && std::memcmp(&lhs.data[prefix], &rhs.data[prefix], sizeof(T)) == 0)
+            ++prefix;
+
+        size_t suffix = 0;
+        size_t maxSuffix = maxPrefix - prefix;
+        while (suffix < maxSuffix &&
+               std::memcmp(&lhs.data[lhs.size - suffix - 1], &rhs.data[rhs.size - suffix - 1], sizeof(T)) == 0)
+            ++suffix;
+
+        PatchOp& op = emit(PO_REPLACE_RANGE);
+        op.index = prefix;
+        op.count = lhs.size - prefix - suffix;
+        op.value = gList(_NumTagType<T>::value);
+        op.value.listData<T>().assign(rhs.data + prefix, rhs.data + rhs.size - suffix);
+    }
+
+    Vec<PatchOp> ops_;
+    Vec<PatchStep> path_;
+    std::unordered_map<const Tag*, UInt64> hashes_;
+};
+
+/// @brief Generate the patch which changes the tag #from to the tag #to, see #apply().
+/// @note The name of the root is not compared.
+inline Patch diff(const Tag& from, const Tag& to)
+{ return _Differ().run(from, to); }
+
+/// @brief Apply the operations of patch to the tag in order.
+class _PatchApplier
+{
+public:
+    explicit _PatchApplier(Tag& root) : root_(root) {}
+
+    void run(const PatchOp& op)
+    {
+        Tag& target = resolve(op.path);
+
+        switch (op.type)
+        {
+            case PO_SET:
+            {
+                Tag value = op.value.copy();
+                if (!target.isListItem())
+                    value.setName(target.name());
+                else if (value.type() != target.type())
+                    fail();
+                target = std::move(value);
+                break;
+            }
+            case PO_INSERT:
+                if (!target.isCompound() || target.hasTag(op.key))
+                    fail();
+                target.addTag(op.value.copy().setName(op.key));
+                break;
+            case PO_REMOVE:
+                if (!target.isCompound() || !target.hasTag(op.key))
+                    fail();
+                target.remove(op.key);
+                break;
+            case PO_SPLICE:
+                splice(target, op);
+                break;
+            case PO_REPLACE_RANGE:
+                replaceRange(target, op);
+                break;
+            default:
+                fail();
+        }
+    }
+
+private:
+    static void fail()
+    { throw std::runtime_error("The patch does not match the tag."); }
+
+    Tag& resolve(const Vec<PatchStep>& path)
+    {
+        Tag* tag = &root_;
+        for (const auto& step : path)
+        {
+            if (step.isIndex)
+            {
+                if (!tag->isList() || step.index >= tag->size())
+                    fail();
+                tag = &(*tag)[step.index];
+            }
+            else
+            {
+                if (!tag->isCompound() || !tag->hasTag(step.name))
+                    fail();
+                tag = &(*tag)[step.name];
+            }
+        }
+
+        return *tag;
+    }
+
+    static void splice(Tag& target, const PatchOp& op)
+    {
+        if (!target.isList() || !op.value.isList() || op.index + op.count > target.size())
+            fail();
+
+        for (size_t i = 0; i < op.count; ++i)
+            target.remove(op.index);
+
+        if (op.value.isEmpty())
+            return;
+
+        if (op.value.listItemType() != target.listItemType())
+            fail();
+
+        Tag items = op.value.copy();
+        for (size_t i = 0; i < items.size(); ++i)
+            target.insertTag(op.index + i, items[i]);
+    }
+
+    static void replaceRange(Tag& target, const PatchOp& op)
+    {
+        TagType type = target.isList() ? target.listItemType() : target.type();
+
+        switch (type)
+        {
+            case TT_BYTE:
+            case TT_BYTE_ARRAY:     replaceRange<Byte>(target, op);     break;
+            case TT_SHORT:          replaceRange<Int16>(target, op);    break;
+            case TT_INT:
+            case TT_INT_ARRAY:      replaceRange<Int32>(target, op);    break;
+            case TT_LONG:
+            case TT_LONG_ARRAY:     replaceRange<Int64>(target, op);    break;
+            case TT_FLOAT:          replaceRange<Fp32>(target, op);     break;
+            case TT_DOUBLE:         replaceRange<Fp64>(target, op);     break;
+            default:                fail();
+        }
+    }
+
+    template <typename T>
+    static void replaceRange(Tag& target, const PatchOp& op)
+    {
+        if (!op.value.isList() || (!op.value.isEmpty() && op.value.listItemType() != _NumTagType<T>::value))
+            fail();
+
+        Tag value = op.value.copy();
+        Vec<T> numbers;
+        if (!value.isEmpty())
+            numbers = value.listData<T>();
+
+        if (target.isList())
+        {
+            Vec<T>& vec = target.listData<T>();
+            replace(vec, op, numbers);
+        }
+        else
+        {
+            Vec<T> vec = _getArray(target, static_cast<T*>(nullptr));
+            replace(vec, op, numbers);
+            _setArray(target, vec);
+        }
+    }
+
+    template <typename T>
+    static void replace(Vec<T>& vec, const PatchOp& op, const Vec<T>& numbers)
+    {
+        if (op.index + op.count > vec.size())
+            fail();
+
+        vec.erase(vec.begin() + op.index, vec.begin() + op.index + op.count);
+        vec.insert(vec.begin() + op.index, numbers.begin(), numbers.end());
+    }
+
+    Tag& root_;
+};
+
+/// @brief Apply the patch to the tag (e.g. the patch of #diff() to the tag #from, then the tag is equal to #to).
+/// @note Throw std::runtime_error if the patch does not match the tag, the operations applied before are kept.
+inline void apply(Tag& tag, const Patch& patch)
+{
+    _PatchApplier applier(tag);
+    for (const auto& op : patch.ops())
+        applier.run(op);
+}
+
+// Set a value in the binary NBT file by the path, in place if the size of the encoded value is unchanged
+// (e.g. the fixed width numbers and the strings of same length), so only the bytes of the value are written.
+
+/// @brief Find the encoded value of the path in the binary NBT by walk the binary layout, without read the tags.
+class _ValueLocator
+{
+public:
+    _ValueLocator(const char* data, size_t size, Encoding enc) : src_(data, size), enc_(enc) {}
+
+    /// @brief Find the value, throw if the path is not found.
+    /// @param[out] type The type of the value.
+    /// @param[out] size The size of the encoded value.
+    /// @return The offset of the encoded value from the begin of data.
+    size_t run(const Vec<PatchStep>& path, TagType& type, size_t& size)
+    {
+        type = static_cast<TagType>(src_.get());
+        if (type == TT_END || static_cast<int>(type) == std::char_traits<char>::eof())
+            throw std::runtime_error("Unexpected end of data.");
+        src_.skip(_readStringLength(src_, enc_));
+
+        for (const auto& step : path)
+            type = step.isIndex ? item(type, step.index) : member(type, step.name);
+
+        size_t offset = src_.pos();
+        _skipValue(src_, type, enc_);
+        size = src_.pos() - offset;
+
+        return offset;
+    }
+
+private:
+    static void notFound()
+    { throw std::runtime_error("The path is not found."); }
+
+    // Move to the value of the member, return its type.
+    TagType member(TagType type, const String& name)
+    {
+        if (type != TT_COMPOUND)
+            notFound();
+
+        for (;;)
+        {
+            int memberType = src_.get();
+            if (memberType == std::char_traits<char>::eof())
+                throw std::runtime_error("Unexpected end of data.");
+
+            if (memberType == TT_END)
+                notFound();
+
+            size_t len = _readStringLength(src_, enc_);
+            const char* memberName = src_.take(len);
+            if (len == name.size() && std::memcmp(memberName, name.data(), len) == 0)
+                return static_cast<TagType>(memberType);
+
+            _skipValue(src_, static_cast<TagType>(memberType), enc_, 1);
+        }
+    }
+
+    // Move to the value of the list item, return its type.
+    TagType item(TagType type, size_t index)
+    {
+        if (type != TT_LIST)
+            notFound();
+
+        TagType itemType = static_cast<TagType>(src_.get());
+        if (index >= _readSize(src_, enc_))
+            notFound();
+
+        if (isNum(itemType))
+        {
+            _skipNumbers(src_, itemType, index, enc_);
+        }
+        else
+        {
+            for (size_t i = 0; i < index; ++i)
+                _skipValue(src_, itemType, enc_, 1);
+        }
+
+        return itemType;
+    }
+
+    BufferSource src_;
+    Encoding enc_;
+};
+
+/// @brief Get the encoded value of the tag, without type and name.
+inline String _encodeValue(const Tag& value, Encoding enc)
+{
+    Tag tag = value.copy();
+    if (!tag.isListItem())
+        tag.setName("");
+
+    Vec<Byte> bin;
+    {
+        VecSink sink(bin);
+        tag.writeToSink(sink, enc);
+    }
+
+    // The type and the length of empty name.
+    size_t headerSize = enc == EC_NETWORK ? 2 : 3;
+
+    return String(bin.data() + headerSize, bin.size() - headerSize);
+}
+
+/// @brief Get the offset of the value of the path in the binary NBT, and check the type of it.
+/// @param headerSize   The size of the header before the root tag, which is included in the offset.
+/// @param[out] oldSize The size of the encoded value.
+inline size_t _locateValue(const char* data, size_t size, Encoding enc, size_t headerSize, const Vec<PatchStep>& path,
+                           const Tag& value, size_t& oldSize)
+{
+    if (headerSize > size)
+        throw std::runtime_error("Unexpected end of data.");
+
+    TagType type = TT_END;
+    _ValueLocator locator(data + headerSize, size - headerSize, enc);
+    size_t offset = headerSize + locator.run(path, type, oldSize);
+
+    if (type != value.type())
+        throw std::runtime_error("Can't set the value of " + getTagTypeString(value.type()) +
+                                 " to the tag of " + getTagTypeString(type));
+
+    return offset;
+}
+
+/// @brief Set the value of the path in the binary NBT file in place, without read the tags and rewrite the file.
+/// @param path         The path from the root, e.g. { "Data", "Player", "XpLevel" } or { "Pos", 1 }.
+/// @param value        The new value, which type must be same as the old one.
+/// @param headerSize   The size of the header before the root tag. (See #Tag::fromFile())
+/// @return false if the file is compressed or the size of the encoded value is changed, then the file is not changed.
+/// @note Throw if the path is not found or the type is not same.
+inline bool patchFileInPlace(const String& filename, Encoding enc, const Vec<PatchStep>& path, const Tag& value,
+                             size_t headerSize = 0)
+{
+    // The value is written through the file mapped, so a file replaced in the meantime is not patched.
+    _File file(filename, std::ios::in | std::ios::out);
+
+    size_t offset = 0;
+    String bin;
+    {
+        Int64 size = file.size();
+        if (size < 0)
+            throw std::runtime_error("Not a regular file: " + filename);
+
+        _FileContent content(file, static_cast<size_t>(size));
+
+    #ifdef MCNBT_ENABLE_GZIP
+        if (gzip::isCompressed(content.data(), content.size()))
+            return false;
+    #endif // MCNBT_ENABLE_GZIP
+
+        size_t oldSize = 0;
+        offset = _locateValue(content.data(), content.size(), enc, headerSize, path, value, oldSize);
+
+        bin = _encodeValue(value, enc);
+        if (bin.size() != oldSize)
+            return false;
+
+        // Unchanged.
+        if (std::memcmp(content.data() + offset, bin.data(), bin.size()) == 0)
+            return true;
+    }
+
+    _writeFdAt(file.fd(), bin.data(), bin.size(), static_cast<Int64>(offset));
+    file.close();
+
+    return true;
+}
+
+/// @brief Set the value of the path in the binary NBT file, in place if possible (see #patchFileInPlace()),
+// else read the tag, set the value and write the whole file again (compressed if it was compressed).
+/// @note The file is read once, and rewritten atomically, i.e. it is either the old one or the new one whenever
+// it fails.
+/// @note If the header ends with the size of the data after it (little endian Int32, e.g. level.dat of
+// bedrock edition), the size is updated.
+/// @note Throw if the path is not found or the type is not same, as #patchFileInPlace().
+inline void patchFile(const String& filename, Encoding enc, const Vec<PatchStep>& path, const Tag& value,
+                      size_t headerSize = 0)
+{
+    _File file(filename, std::ios::in | std::ios::out);
+
+    Int64 fileSize = file.size();
+    if (fileSize < 0)
+        throw std::runtime_error("Not a regular file: " + filename);
+
+    bool isCompressed = false;
+    FileWriteOptions options;
+    options.isAtomic = true;
+
+    size_t offset = 0;
+    String bin;
+    bool isInPlace = false;
+    bool isSizeField = false;   // Whether the header ends with the size of the root tag.
+    Tag tag;
+    {
+        _FileContent content(file, static_cast<size_t>(fileSize));
+        const char* data = content.data();
+        size_t size = content.size();
+
+    #ifdef MCNBT_ENABLE_GZIP
+        String decompressed;
+        isCompressed = gzip::isCompressed(data, size);
+        if (isCompressed)
+        {
+            decompressed = gzip::decompress(data, size);
+            data = decompressed.data();
+            size = decompressed.size();
+        }
+    #endif // MCNBT_ENABLE_GZIP
+
+        size_t oldSize = 0;
+        offset = _locateValue(data, size, enc, headerSize, path, value, oldSize);
+
+        bin = _encodeValue(value, enc);
+        // Unchanged.
+        if (bin.size() == oldSize && std::memcmp(data + offset, bin.data(), bin.size()) == 0)
+            return;
+
+        isInPlace = !isCompressed && bin.size() == oldSize;
+        if (!isInPlace)
+        {
+            options.header.assign(data, headerSize);
+
+            BufferSource src(data + headerSize, size - headerSize);
+            tag = Tag::fromSource(src, enc);
+
+            isSizeField = headerSize >= 4 &&
+                static_cast<UInt32>(_loadNum<Int32>(&options.header[headerSize - 4], false)) == src.pos();
+        }
+    }
+
+    if (isInPlace)
+    {
+        _writeFdAt(file.fd(), bin.data(), bin.size(), static_cast<Int64>(offset));
+        file.close();
+        return;
+    }
+
+    Patch patch;
+    PatchOp op;
+    op.path = path;
+    op.value = value.copy();
+    patch.add(std::move(op));
+    apply(tag, patch);
+
+    if (isSizeField)
+        _storeNum<Int32>(static_cast<Int32>(tag.binarySize(enc)), &options.header[headerSize - 4], false);
+
+    file.close();
+#ifdef MCNBT_ENABLE_GZIP
+    tag.write(filename, enc, isCompressed, options);
+#else
+    tag.write(filename, enc, options);
+#endif // MCNBT_ENABLE_GZIP
+}
+
+} // namespace nbt
+
+#endif // !MCNBT_PATCH_HPP
@@ -0,0 +1,594 @@
+#ifndef MCNBT_PATH_HPP
+#define MCNBT_PATH_HPP
+
+#include <cstring>
+#include <cstdlib>  // strtoll(), strtod()
+
+#include "mcnbt.hpp"
+
+namespace nbt
+{
+
+// The path of tags, e.g. `structure.palette.default.block_palette[*].name`.
+// The path is parsed once and can be reused for many tags, each member step caches the index of member found last
+// time, so the lookups in the tags of same layout are not hashed.
+//
+// The syntax:
+// - `name`         The member of compound, the name can be quoted by "" or '' if it contains `.`, `[`, `]` or quote.
+// - `*`            All members of compound.
+// - `[n]`          The item of list or the member of compound by index, the negative index is counted from the end.
+// - `[*]`          All items of list or all members of compound.
+// - `[key=value]`  The compound items of list (or the compound members of compound) which member #key is equal to
+//                  the value, the value is a number, or a string (which can be quoted).
+// The steps are separated by `.`, except the steps start with `[`. The empty path selects the root itself.
+
+class TagPath
+{
+public:
+    /// @brief Parse the path, throw std::runtime_error if the syntax is invalid.
+    explicit TagPath(const String& path) : str_(path) { compile_(); }
+
+    /// @brief Get the text of path.
+    const String& str() const   { return str_; }
+
+    /// @brief Get the count of steps.
+    size_t size() const         { return steps_.size(); }
+
+    /// @brief Get all the tags of the path from the tag in order.
+    /// @note The compounds in the path are copied if they are shared. (See #Tag::getTag())
+    Vec<Tag*> select(Tag& tag) const
+    {
+        Vec<Tag*> rslt;
+        select_(tag, 0, rslt, false);
+        return rslt;
+    }
+
+    /// @overload
+    Vec<const Tag*> select(const Tag& tag) const
+    {
+        Vec<const Tag*> rslt;
+        select_(tag, 0, rslt, false);
+        return rslt;
+    }
+
+    /// @brief Get the first tag of the path from the tag, nullptr if not found.
+    Tag* first(Tag& tag) const
+    {
+        Vec<Tag*> rslt;
+        select_(tag, 0, rslt, true);
+        return rslt.empty() ? nullptr : rslt.front();
+    }
+
+    /// @overload
+    const Tag* first(const Tag& tag) const
+    {
+        Vec<const Tag*> rslt;
+        select_(tag, 0, rslt, true);
+        return rslt.empty() ? nullptr : rslt.front();
+    }
+
+    /// @brief Get the first tag of the path from the tag, throw std::out_of_range if not found.
+    Tag& get(Tag& tag) const
+    {
+        Tag* rslt = first(tag);
+        if (!rslt)
+            throw std::out_of_range("The path is not found: " + str_);
+
+        return *rslt;
+    }
+
+    /// @overload
+    const Tag& get(const Tag& tag) const
+    {
+        const Tag* rslt = first(tag);
+        if (!rslt)
+            throw std::out_of_range("The path is not found: " + str_);
+
+        return *rslt;
+    }
+
+    /// @brief Get the copies of all the tags of the path from the binary NBT, only the selected tags are read,
+    // the others are skipped by walk the binary layout.
+    /// @param data     The uncompressed binary NBT which starts from the root tag. (without header)
+    /// @param options  The options about the memory of the tags read. (See #ReadOptions)
+    Vec<Tag> selectBinary(const char* data, size_t size, Encoding enc, const ReadOptions& options = ReadOptions()) const
+    {
+        Vec<Tag> rslt;
+        BufferSource src(data, size);
+
+        int type = src.get();
+        if (type == std::char_traits<char>::eof())
+            throw std::runtime_error("Unexpected end of data.");
+
+        if (type == TT_END)
+            return rslt;
+
+        size_t len = src.readStringLength(enc);
+        const char* name = src.take(len);
+        walk_(src, enc, static_cast<TagType>(type), name, len, 0, options, rslt);
+
+        return rslt;
+    }
+
+    /// @brief Get the copies of all the tags of the path from the nbt file. (See #selectBinary())
+    /// @param headerSize The size of the header before the root tag. (See #Tag::fromFile())
+    /// @note The uncompressed file is mapped to memory and walked directly, the compressed file is decompressed
+    // to memory first.
+    Vec<Tag> selectFile(const String& filename, Encoding enc, size_t headerSize = 0,
+                        const ReadOptions& options = ReadOptions()) const
+    {
+        _File file(filename);
+
+        Vec<Byte> bin;
+        Int64 size = file.size();
+        if (size < 0)
+        {
+            FileSource src(file.fd());
+            _readRemain(src, bin);
+            return selectContent_(bin.data(), bin.size(), enc, headerSize, options);
+        }
+
+        if (static_cast<UInt64>(size) > static_cast<UInt64>(SIZE_MAX))
+            throw std::runtime_error("The file is too large: " + filename);
+
+        _FileContent content(file, static_cast<size_t>(size));
+        return selectContent_(content.data(), content.size(), enc, headerSize, options);
+    }
+
+private:
+    enum StepType_ : Byte
+    {
+        ST_MEMBER,      ///< `name`
+        ST_ANY_MEMBER,  ///< `*`
+        ST_INDEX,       ///< `[n]`
+        ST_ANY_ITEM,    ///< `[*]`
+        ST_FILTER       ///< `[key=value]`
+    };
+
+    struct Step_
+    {
+        explicit Step_(StepType_ type) : type(type) {}
+
+        Step_(const Step_& other)
+            : type(other.type), name(other.name), index(other.index), value(other.value.copy()),
+              hint(other.hint.load(std::memory_order_relaxed)) {}
+
+        Step_& operator=(const Step_& other)
+        {
+            type = other.type;
+            name = other.name;
+            index = other.index;
+            value = other.value.copy();
+            hint.store(other.hint.load(std::memory_order_relaxed), std::memory_order_relaxed);
+            return *this;
+        }
+
+        StepType_ type;
+        String name;                            ///< The member name of #ST_MEMBER, or the key of #ST_FILTER.
+        Int64 index = 0;                        ///< The index of #ST_INDEX.
+        Tag value;                              ///< The value of #ST_FILTER. (String, Long or Double)
+        mutable std::atomic<size_t> hint{ 0 };  ///< The index of the member #name found last time.
+    };
+
+    void invalid_() const { throw std::runtime_error("Invalid path: " + str_); }
+
+    /// @brief Select from the content of file which may be compressed.
+    Vec<Tag> selectContent_(const char* data, size_t size, Encoding enc, size_t headerSize,
+                            const ReadOptions& options) const
+    {
+        Vec<Byte> bin;
+    #ifdef MCNBT_ENABLE_GZIP
+        if (gzip::isCompressed(data, size))
+        {
+            BufferSource src(data, size);
+            gzip::DecompressSource<BufferSource> dsrc(src);
+            _readRemain(dsrc, bin);
+
+            data = bin.data();
+            size = bin.size();
+        }
+    #endif // MCNBT_ENABLE_GZIP
+
+        if (headerSize > size)
+            throw std::runtime_error("Unexpected end of data.");
+
+        return selectBinary(data + headerSize, size - headerSize, enc, options);
+    }
+
+    // Parse functions.
+
+    void compile_()
+    {
+        size_t pos = 0;
+        while (pos < str_.size())
+        {
+            if (str_[pos] == '[')
+            {
+                compileBracket_(pos);
+                continue;
+            }
+
+            if (!steps_.empty())
+            {
+                if (str_[pos] != '.')
+                    invalid_();
+                ++pos;
+            }
+
+            if (pos < str_.size() && str_[pos] == '*')
+            {
+                steps_.push_back(Step_(ST_ANY_MEMBER));
+                ++pos;
+                continue;
+            }
+
+            Step_ step(ST_MEMBER);
+            if (!compileName_(pos, ".[", step.name))
+                invalid_();
+            steps_.push_back(step);
+        }
+    }
+
+    // `[n]`, `[*]` or `[key=value]`, the #pos is at `[` and is moved over `]`.
+    void compileBracket_(size_t& pos)
+    {
+        size_t end = ++pos;
+        if (end < str_.size() && str_[end] == '*')
+        {
+            if (++end >= str_.size() || str_[end] != ']')
+                invalid_();
+
+            steps_.push_back(Step_(ST_ANY_ITEM));
+            pos = end + 1;
+            return;
+        }
+
+        if (end < str_.size() && (str_[end] == '-' || (str_[end] >= '0' && str_[end] <= '9')))
+        {
+            String literal;
+            if (!compileName_(pos, "]", literal) || pos >= str_.size())
+                invalid_();
+
+            Step_ step(ST_INDEX);
+            char* numEnd = nullptr;
+            step.index = std::strtoll(literal.c_str(), &numEnd, 10);
+            if (*numEnd != '\0')
+                invalid_();
+
+            steps_.push_back(step);
+            ++pos;
+            return;
+        }
+
+        Step_ step(ST_FILTER);
+        if (!compileName_(pos, "=]", step.name) || pos >= str_.size() || str_[pos] != '=')
+            invalid_();
+        ++pos;
+
+        bool isQuoted = pos < str_.size() && (str_[pos] == '"' || str_[pos] == '\'');
+        String literal;
+        if (!compileName_(pos, "]", literal) || pos >= str_.size())
+            invalid_();
+        ++pos;
+
+        step.value = isQuoted ? gString(literal) : compileLiteral_(literal);
+        steps_.push_back(step);
+    }
+
+    /// @brief Parse the quoted string, or the unquoted string until any of the #stops.
+    /// @return false if the unquoted string is empty.
+    bool compileName_(size_t& pos, const char* stops, String& name) const
+    {
+        if (pos < str_.size() && (str_[pos] == '"' || str_[pos] == '\''))
+        {
+            char quote = str_[pos++];
+            for (;;)
+            {
+                if (pos >= str_.size())
+                    invalid_();
+
+                char ch = str_[pos++];
+                if (ch == quote)
+                    break;
+
+                if (ch == '\\')
+                {
+                    if (pos >= str_.size())
+                        invalid_();
+                    ch = str_[pos++];
+                }
+
+                name.push_back(ch);
+            }
+
+            return pos >= str_.size() || std::strchr(stops, str_[pos]) != nullptr;
+        }
+
+        size_t beg = pos;
+        while (pos < str_.size() && std::strchr(stops, str_[pos]) == nullptr)
+        {
+            if (str_[pos] == '"' || str_[pos] == '\'' || str_[pos] == ']')
+                invalid_();
+            ++pos;
+        }
+
+        name = str_.substr(beg, pos - beg);
+        return !name.empty();
+    }
+
+    /// @brief Get the value of unquoted literal, the number if it is a number, else the string.
+    static Tag compileLiteral_(const String& literal)
+    {
+        char* end = nullptr;
+
+        Int64 integer = std::strtoll(literal.c_str(), &end, 10);
+        if (*end == '\0')
+            return gLong(integer);
+
+        Fp64 fp = std::strtod(literal.c_str(), &end);
+        if (*end == '\0')
+            return gDouble(fp);
+
+        return gString(literal);
+    }
+
+    // Evaluate functions.
+
+    /// @brief Check if the value is equal to the value of filter, the numbers of any type are compared by value.
+    static bool isMatched_(const Tag& tag, const Tag& value)
+    {
+        if (value.isString())
+            return tag.isString() && tag.getString() == value.getString();
+
+        if (!tag.isNum())
+            return false;
+
+        if (value.isInteger() && tag.isInteger())
+            return tag.getInteger() == value.getInteger();
+
+        Fp64 lhs = tag.isInteger() ? static_cast<Fp64>(tag.getInteger()) : tag.getFloatPoint();
+        Fp64 rhs = value.isInteger() ? static_cast<Fp64>(value.getInteger()) : value.getFloatPoint();
+        return lhs == rhs;
+    }
+
+    static bool isFilterMatched_(const Step_& step, const Tag& tag)
+    {
+        if (!tag.isCompound())
+            return false;
+
+        size_t idx = tag.indexOf(step.name, step.hint.load(std::memory_order_relaxed));
+        if (idx == tag.size())
+            return false;
+
+        step.hint.store(idx, std::memory_order_relaxed);
+        return isMatched_(tag.getTag(idx), step.value);
+    }
+
+    /// @brief Get the index of #ST_INDEX in the container of the size, #size if it is out of range.
+    static size_t resolveIndex_(const Step_& step, size_t size)
+    {
+        Int64 index = step.index < 0 ? static_cast<Int64>(size) + step.index : step.index;
+        return index >= 0 && static_cast<UInt64>(index) < size ? static_cast<size_t>(index) : size;
+    }
+
+    /// @tparam T The #Tag or const #Tag.
+    template <typename T>
+    void select_(T& tag, size_t i, Vec<T*>& rslt, bool isFirstOnly) const
+    {
+        if (i == steps_.size())
+        {
+            rslt.push_back(&tag);
+            return;
+        }
+
+        const Step_& step = steps_[i];
+        const Tag& view = tag;
+
+        switch (step.type)
+        {
+            case ST_MEMBER:
+            {
+                if (!tag.isCompound())
+                    return;
+
+                size_t idx = tag.indexOf(step.name, step.hint.load(std::memory_order_relaxed));
+                if (idx == tag.size())
+                    return;
+
+                step.hint.store(idx, std::memory_order_relaxed);
+                select_(tag.getTag(idx), i + 1, rslt, isFirstOnly);
+                return;
+            }
+            case ST_INDEX:
+            {
+                if (!tag.isContainer())
+                    return;
+
+                size_t idx = resolveIndex_(step, tag.size());
+                if (idx != tag.size())
+                    select_(tag.getTag(idx), i + 1, rslt, isFirstOnly);
+                return;
+            }
+            case ST_ANY_MEMBER:
+            case ST_ANY_ITEM:
+            case ST_FILTER:
+            {
+                if (step.type == ST_ANY_MEMBER ? !tag.isCompound() : !tag.isContainer())
+                    return;
+
+                // The items of the list of numbers are never matched.
+                if (step.type == ST_FILTER && tag.isList() && tag.listItemType() != TT_COMPOUND)
+                    return;
+
+                for (size_t j = 0; j < tag.size(); ++j)
+                {
+                    if (isFirstOnly && !rslt.empty())
+                        return;
+
+                    if (step.type != ST_FILTER || isFilterMatched_(step, view.getTag(j)))
+                        select_(tag.getTag(j), i + 1, rslt, isFirstOnly);
+                }
+                return;
+            }
+        }
+    }
+
+    /// @brief Check if the member or item of the encoded compound or list is matched by the step.
+    /// @param name     The name of member, nullptr if it is a list item.
+    /// @param src      The source at the value of the member or item, it is not moved.
+    bool isChildMatched_(const Step_& step, size_t idx, size_t targetIdx, const char* name, size_t len,
+                         TagType type, const BufferSource& src, Encoding enc) const
+    {
+        switch (step.type)
+        {
+            case ST_MEMBER:     return name && len == step.name.size() && std::memcmp(name, step.name.data(), len) == 0;
+            case ST_ANY_MEMBER: return name != nullptr;
+            case ST_INDEX:      return idx == targetIdx;
+            case ST_ANY_ITEM:   return true;
+            case ST_FILTER:     return type == TT_COMPOUND && isFilterMatched_(step, src, enc);
+        }
+
+        return false;
+    }
+
+    /// @brief Check if the encoded compound (after its type and name) is matched by the filter.
+    static bool isFilterMatched_(const Step_& step, BufferSource src, Encoding enc)
+    {
+        for (;;)
+        {
+            int type = src.get();
+            if (type == std::char_traits<char>::eof())
+                throw std::runtime_error("Unexpected end of data.");
+
+            if (type == TT_END)
+                return false;
+
+            size_t len = src.readStringLength(enc);
+            const char* name = src.take(len);
+            if (len == step.name.size() && std::memcmp(name, step.name.data(), len) == 0)
+            {
+                if (!isNum(static_cast<TagType>(type)) && type != TT_STRING)
+                    return false;
+
+                return isMatched_(Tag::valueFromSource(src, enc, static_cast<TagType>(type)), step.value);
+            }
+
+            _skipValue(src, static_cast<TagType>(type), enc, 1);
+        }
+    }
+
+    /// @brief Count the members of the encoded compound (after its type and name).
+    static size_t countMembers_(BufferSource src, Encoding enc)
+    {
+        size_t count = 0;
+        for (;;)
+        {
+            int type = src.get();
+            if (type == std::char_traits<char>::eof())
+                throw std::runtime_error("Unexpected end of data.");
+
+            if (type == TT_END)
+                return count;
+
+            src.skip(src.readStringLength(enc));
+            _skipValue(src, static_cast<TagType>(type), enc, 1);
+            ++count;
+        }
+    }
+
+    /// @brief Walk the encoded value of the type from the step #i, the source is moved over the value.
+    /// @param name The name of the value, nullptr if it is a list item.
+    void walk_(BufferSource& src, Encoding enc, TagType type, const char* name, size_t len, size_t i,
+               const ReadOptions& options, Vec<Tag>& rslt) const
+    {
+        if (i == steps_.size())
+        {
+            Tag tag = Tag::valueFromSource(src, enc, type, options);
+            if (name && len != 0)
+                tag.setName(String(name, len));
+
+            rslt.push_back(std::move(tag));
+            return;
+        }
+
+        const Step_& step = steps_[i];
+
+        if (type == TT_COMPOUND)
+        {
+            walkMembers_(src, enc, step, i, options, rslt);
+            return;
+        }
+
+        if (type != TT_LIST || step.type == ST_MEMBER || step.type == ST_ANY_MEMBER)
+        {
+            _skipValue(src, type, enc, i);
+            return;
+        }
+
+        TagType itemType = static_cast<TagType>(src.get());
+        size_t count = src.readSize(enc);
+        size_t targetIdx = step.type == ST_INDEX ? resolveIndex_(step, count) : count;
+
+        // The numbers are skipped at once.
+        if (isNum(itemType) && step.type != ST_ANY_ITEM)
+        {
+            if (targetIdx == count)
+            {
+                _skipNumbers(src, itemType, count, enc);
+                return;
+            }
+
+            _skipNumbers(src, itemType, targetIdx, enc);
+            walk_(src, enc, itemType, nullptr, 0, i + 1, options, rslt);
+            _skipNumbers(src, itemType, count - targetIdx - 1, enc);
+            return;
+        }
+
+        for (size_t j = 0; j < count; ++j)
+        {
+            if (isChildMatched_(step, j, targetIdx, nullptr, 0, itemType, src, enc))
+                walk_(src, enc, itemType, nullptr, 0, i + 1, options, rslt);
+            else
+                _skipValue(src, itemType, enc, i + 1);
+        }
+    }
+
+    /// @brief Walk the members of the encoded compound (after its type and name) by the step #i.
+    void walkMembers_(BufferSource& src, Encoding enc, const Step_& step, size_t i, const ReadOptions& options,
+                      Vec<Tag>& rslt) const
+    {
+        size_t targetIdx = static_cast<size_t>(-1);
+        if (step.type == ST_INDEX)
+        {
+            // The count of members is unknown before all of them are walked.
+            size_t count = step.index < 0 ? countMembers_(src, enc) : static_cast<size_t>(-1);
+            targetIdx = resolveIndex_(step, count);
+        }
+
+        for (size_t j = 0;; ++j)
+        {
+            int type = src.get();
+            if (type == std::char_traits<char>::eof())
+                throw std::runtime_error("Unexpected end of data.");
+
+            if (type == TT_END)
+                return;
+
+            size_t len = src.readStringLength(enc);
+            const char* name = src.take(len);
+            TagType memberType = static_cast<TagType>(type);
+
+            if (isChildMatched_(step, j, targetIdx, name, len, memberType, src, enc))
+                walk_(src, enc, memberType, name, len, i + 1, options, rslt);
+            else
+                _skipValue(src, memberType, enc, i + 1);
+        }
+    }
+
+    String str_;
+    Vec<Step_> steps_;
+};
+
+} // namespace nbt
+
+#endif // !MCNBT_PATH_HPP
@@ -0,0 +1,434 @@
+#ifndef MCNBT_PROFILE_HPP
+#define MCNBT_PROFILE_HPP
+
+#include <algorithm>    // sort()
+#include <utility>      // pair
+
+#include "mcnbt.hpp"
+
+namespace nbt
+{
+
+// The profile of the binary NBT by the paths of tags, i.e. where the bytes of files go.
+// The binary is walked without construct the tags, and the profiles of many documents (or of the profiles
+// made by many threads) are added together.
+//
+// The paths are in the syntax of #TagPath (see mcnbt/path.hpp), normalized so that the tags of same role have
+// same path:
+// - The items of lists are `[*]`.
+// - The members of compounds which names are numbers (e.g. the indices of `block_position_data`) are `*`.
+// e.g. `structure.palette.default.block_position_data.*.block_entity_data.Items[*]`.
+
+struct PathProfile
+{
+    TagType type            = TT_END;   ///< The type of tags, #TT_END if the types are different.
+    UInt64 count            = 0;        ///< The count of tags.
+    UInt64 bytes            = 0;        ///< The encoded bytes of tags, include the type, name and children.
+    UInt64 selfBytes        = 0;        ///< The encoded bytes of tags exclude the children.
+    UInt64 maxBytes         = 0;        ///< The max encoded bytes of a tag.
+    UInt64 maxSize          = 0;        ///< The max count of items, members or characters of a tag.
+    UInt64 compressedBytes  = 0;        ///< The Gzip compressed size of the #selfBytes of each document on their
+                                        // own (without the header and trailer of Gzip), 0 if not estimated.
+
+    void merge(const PathProfile& other)
+    {
+        if (other.count == 0)
+            return;
+
+        if (count == 0)
+            type = other.type;
+        else if (type != other.type)
+            type = TT_END;
+
+        count += other.count;
+        bytes += other.bytes;
+        selfBytes += other.selfBytes;
+        maxBytes = std::max(maxBytes, other.maxBytes);
+        maxSize = std::max(maxSize, other.maxSize);
+        compressedBytes += other.compressedBytes;
+    }
+};
+
+class Profile
+{
+public:
+    /// @param isCompressedEstimated If true, estimate the compressed size of each path.
+    // (See #PathProfile::compressedBytes)
+    /// @note The compressed size is not estimated if Gzip is disabled.
+    explicit Profile(bool isCompressedEstimated = false) : isCompressedEstimated_(isCompressedEstimated)
+    {
+        nodes_.push_back(Node_());
+    }
+
+    /// @brief Get the count of documents added.
+    UInt64 documentCount() const    { return documentCount_; }
+
+    /// @brief Get the bytes of (uncompressed) binary NBT of the documents, the sum of #PathProfile::selfBytes.
+    UInt64 bytes() const            { return bytes_; }
+
+    /// @brief Get the bytes of the files as they are stored (compressed or not), include the headers.
+    UInt64 fileBytes() const        { return fileBytes_; }
+
+    /// @brief Add the binary NBT (uncompressed and without header) of a document.
+    void addBinary(const char* data, size_t size, Encoding enc)
+    {
+        BufferSource src(data, size);
+
+        int type = src.get();
+        if (type == std::char_traits<char>::eof())
+            throw std::runtime_error("Unexpected end of data.");
+
+        if (type != TT_END)
+        {
+            src.skip(src.readStringLength(enc));
+            walk_(src, enc, static_cast<TagType>(type), 0, data, 0);
+        }
+
+        ++documentCount_;
+        bytes_ += src.pos();
+
+        estimate_();
+    }
+
+    /// @brief Add the document of the nbt file, which may be compressed.
+    /// @param headerSize The size of the header before the root tag. (See #Tag::fromFile())
+    void addFile(const String& filename, Encoding enc, size_t headerSize = 0)
+    {
+        _File file(filename);
+
+        Int64 size = file.size();
+        if (size < 0)
+        {
+            Vec<Byte> bin;
+            FileSource src(file.fd());
+            _readRemain(src, bin);
+            addContent_(bin.data(), bin.size(), enc, headerSize);
+            return;
+        }
+
+        if (static_cast<UInt64>(size) > static_cast<UInt64>(SIZE_MAX))
+            throw std::runtime_error("The file is too large: " + filename);
+
+        _FileContent content(file, static_cast<size_t>(size));
+        addContent_(content.data(), content.size(), enc, headerSize);
+    }
+
+    /// @brief Add the profile of the other documents, e.g. the profile made by other thread.
+    void merge(const Profile& other)
+    {
+        if (&other == this)
+            return;
+
+        documentCount_ += other.documentCount_;
+        bytes_ += other.bytes_;
+        fileBytes_ += other.fileBytes_;
+        mergeNode_(0, other, 0);
+    }
+
+    /// @brief Get the paths and their profiles, in the descending order of #PathProfile::selfBytes.
+    /// @note The path of root is empty.
+    Vec<std::pair<String, PathProfile>> paths() const
+    {
+        Vec<String> strs(nodes_.size());
+        Vec<std::pair<String, PathProfile>> rslt;
+        rslt.reserve(nodes_.size());
+
+        // The parents are always before their children.
+        for (size_t i = 0; i < nodes_.size(); ++i)
+        {
+            const Node_& node = nodes_[i];
+            if (i != 0)
+            {
+                strs[i] = strs[node.parent];
+                if (!strs[i].empty() && node.step[0] != '[')
+                    strs[i].push_back('.');
+                strs[i] += node.step;
+            }
+
+            if (node.profile.count != 0)
+                rslt.emplace_back(strs[i], node.profile);
+        }
+
+        std::sort(rslt.begin(), rslt.end(),
+                  [](const std::pair<String, PathProfile>& lhs, const std::pair<String, PathProfile>& rhs)
+        {
+            if (lhs.second.selfBytes != rhs.second.selfBytes)
+                return lhs.second.selfBytes > rhs.second.selfBytes;
+            return lhs.first < rhs.first;
+        });
+
+        return rslt;
+    }
+
+private:
+    struct Node_
+    {
+        String step;                    ///< The last step of the path, empty for root.
+        size_t parent = 0;
+        Map<String, size_t> children;   ///< The indices of children nodes, by the step.
+        PathProfile profile;
+        String pending;                 ///< The self bytes of the current document, for estimate the compressed size.
+    };
+
+    /// @brief Get the step of the member name, e.g. `name`, `"minecraft:name"` or `*` for the number.
+    static String memberStep_(const char* name, size_t len)
+    {
+        bool isNumber = len != 0;
+        bool isQuoted = len == 0;
+        for (size_t i = 0; i < len; ++i)
+        {
+            char ch = name[i];
+            isNumber = isNumber && ch >= '0' && ch <= '9';
+            isQuoted = isQuoted || ch == '.' || ch == '[' || ch == ']' || ch == '"' || ch == '\'' || ch == '*';
+        }
+
+        if (isNumber)
+            return "*";
+
+        if (!isQuoted)
+            return String(name, len);
+
+        String step = "\"";
+        for (size_t i = 0; i < len; ++i)
+        {
+            if (name[i] == '"' || name[i] == '\\')
+                step.push_back('\\');
+            step.push_back(name[i]);
+        }
+        step.push_back('"');
+
+        return step;
+    }
+
+    size_t child_(size_t node, const String& step)
+    {
+        auto it = nodes_[node].children.find(step);
+        if (it != nodes_[node].children.end())
+            return it->second;
+
+        size_t idx = nodes_.size();
+        nodes_.push_back(Node_());
+        nodes_.back().step = step;
+        nodes_.back().parent = node;
+        nodes_[node].children.emplace(step, idx);
+
+        return idx;
+    }
+
+    void addContent_(const char* data, size_t size, Encoding enc, size_t headerSize)
+    {
+        fileBytes_ += size;
+
+        Vec<Byte> bin;
+    #ifdef MCNBT_ENABLE_GZIP
+        if (gzip::isCompressed(data, size))
+        {
+            BufferSource src(data, size);
+            gzip::DecompressSource<BufferSource> dsrc(src);
+            _readRemain(dsrc, bin);
+
+            data = bin.data();
+            size = bin.size();
+        }
+    #endif // MCNBT_ENABLE_GZIP
+
+        if (headerSize > size)
+            throw std::runtime_error("Unexpected end of data.");
+
+        addBinary(data + headerSize, size - headerSize, enc);
+    }
+
+    /// @brief Record a tag of the path.
+    void record_(size_t node, TagType type, UInt64 bytes, UInt64 selfBytes, UInt64 size)
+    {
+        PathProfile one;
+        one.type = type;
+        one.count = 1;
+        one.bytes = bytes;
+        one.selfBytes = selfBytes;
+        one.maxBytes = bytes;
+        one.maxSize = size;
+
+        nodes_[node].profile.merge(one);
+    }
+
+    void keep_(size_t node, const char* data, size_t size)
+    {
+        if (isCompressedEstimated_)
+            nodes_[node].pending.append(data, size);
+    }
+
+    /// @brief Walk the value of the tag, which type and name (if any) begin at #begin.
+    /// @return The encoded bytes of the tag.
+    UInt64 walk_(BufferSource& src, Encoding enc, TagType type, size_t node, const char* begin, size_t depth)
+    {
+        if (depth > _MAX_NESTING_DEPTH)
+            throw std::runtime_error("The nesting depth of tag is too deep.");
+
+        const char* value = src.data();
+        UInt64 size = 0;
+        UInt64 childBytes = 0;
+
+        switch (type)
+        {
+            case TT_BYTE:
+            case TT_SHORT:
+            case TT_INT:
+            case TT_LONG:
+            case TT_FLOAT:
+            case TT_DOUBLE:
+                _skipNumbers(src, type, 1, enc);
+                break;
+            case TT_STRING:
+                size = src.readStringLength(enc);
+                src.skip(static_cast<size_t>(size));
+                break;
+            case TT_BYTE_ARRAY:
+                size = src.readSize(enc);
+                src.skip(static_cast<size_t>(size));
+                break;
+            case TT_INT_ARRAY:
+                size = src.readSize(enc);
+                _skipNumbers(src, TT_INT, static_cast<size_t>(size), enc);
+                break;
+            case TT_LONG_ARRAY:
+                size = src.readSize(enc);
+                _skipNumbers(src, TT_LONG, static_cast<size_t>(size), enc);
+                break;
+            case TT_LIST:
+            {
+                int itemType = src.get();
+                if (itemType == std::char_traits<char>::eof())
+                    throw std::runtime_error("Unexpected end of data.");
+
+                size = src.readSize(enc);
+                keep_(node, begin, static_cast<size_t>(src.data() - begin));
+                if (size == 0)
+                    break;
+
+                size_t item = child_(node, "[*]");
+                if (isNum(static_cast<TagType>(itemType)))
+                {
+                    childBytes = walkNumbers_(src, enc, static_cast<TagType>(itemType), item, size);
+                    break;
+                }
+
+                for (UInt64 i = 0; i < size; ++i)
+                    childBytes += walk_(src, enc, static_cast<TagType>(itemType), item, src.data(), depth + 1);
+
+                break;
+            }
+            case TT_COMPOUND:
+            {
+                keep_(node, begin, static_cast<size_t>(value - begin));
+                for (;;)
+                {
+                    const char* memberBegin = src.data();
+                    int memberType = src.get();
+                    if (memberType == std::char_traits<char>::eof())
+                        throw std::runtime_error("Unexpected end of data.");
+
+                    if (memberType == TT_END)
+                    {
+                        keep_(node, memberBegin, 1);
+                        break;
+                    }
+
+                    size_t len = src.readStringLength(enc);
+                    const char* name = src.take(len);
+                    size_t member = child_(node, memberStep_(name, len));
+                    childBytes += walk_(src, enc, static_cast<TagType>(memberType), member, memberBegin, depth + 1);
+                    ++size;
+                }
+
+                break;
+            }
+            default:
+                throw std::runtime_error("Invalid tag type.");
+        }
+
+        UInt64 bytes = static_cast<UInt64>(src.data() - begin);
+        if (type != TT_LIST && type != TT_COMPOUND)
+            keep_(node, begin, static_cast<size_t>(bytes));
+
+        record_(node, type, bytes, bytes - childBytes, size);
+
+        return bytes;
+    }
+
+    /// @brief Walk the items of the list of numbers, they are recorded at once.
+    /// @return The encoded bytes of the items.
+    UInt64 walkNumbers_(BufferSource& src, Encoding enc, TagType type, size_t node, UInt64 count)
+    {
+        const char* begin = src.data();
+        size_t width = _fixedWidth(type, enc);
+
+        PathProfile items;
+        items.type = type;
+        items.count = count;
+        items.maxBytes = width;
+
+        if (width != 0)
+        {
+            _skipNumbers(src, type, static_cast<size_t>(count), enc);
+        }
+        else
+        {
+            // The VarInt of network encoding.
+            for (UInt64 i = 0; i < count; ++i)
+            {
+                const char* item = src.data();
+                src.readVarInt(type == TT_INT ? 5 : 10);
+                items.maxBytes = std::max<UInt64>(items.maxBytes, static_cast<UInt64>(src.data() - item));
+            }
+        }
+
+        items.bytes = static_cast<UInt64>(src.data() - begin);
+        items.selfBytes = items.bytes;
+
+        nodes_[node].profile.merge(items);
+        keep_(node, begin, static_cast<size_t>(items.bytes));
+
+        return items.bytes;
+    }
+
+    /// @brief Add the compressed sizes of the self bytes of the current document.
+    void estimate_()
+    {
+        if (!isCompressedEstimated_)
+            return;
+
+        for (auto& node : nodes_)
+        {
+            if (node.pending.empty())
+                continue;
+
+        #ifdef MCNBT_ENABLE_GZIP
+            // The header and trailer of Gzip are 18 bytes.
+            size_t size = gzip::compress(node.pending).size();
+            node.profile.compressedBytes += size > 18 ? size - 18 : 0;
+        #endif // MCNBT_ENABLE_GZIP
+
+            node.pending.clear();
+        }
+    }
+
+    void mergeNode_(size_t node, const Profile& other, size_t otherNode)
+    {
+        const Node_& src = other.nodes_[otherNode];
+        nodes_[node].profile.merge(src.profile);
+
+        for (const auto& var : src.children)
+            mergeNode_(child_(node, var.first), other, var.second);
+    }
+
+    bool isCompressedEstimated_;
+    UInt64 documentCount_   = 0;
+    UInt64 bytes_           = 0;
+    UInt64 fileBytes_       = 0;
+    Vec<Node_> nodes_;          ///< The nodes of paths, the first one is root.
+};
+
+} // namespace nbt
+
+#endif // !MCNBT_PROFILE_HPP
@@ -0,0 +1,320 @@
+#ifndef MCNBT_STATS_HPP
+#define MCNBT_STATS_HPP
+
+#include <mcnbt/config.hpp>
+
+// The instrumentation of the reads, writes and Gzip compressions, only if #MCNBT_ENABLE_STATS is defined.
+// Each read, write, compress or decompress is a document, its stats are added to the totals of its kind, which
+// can be scraped by #getStatsText(), and passed to the callback if it is set by #setStatsCallback(). e.g.
+//
+// setStatsCallback([](StatsKind kind, const CodecStats& stats, void*) {
+//     if (kind == SK_READ && stats.ns > 1000000000)
+//         std::cerr << "Slow read: " << stats.bytes << " bytes, max depth " << stats.maxDepth << std::endl;
+// }, nullptr);
+//
+// The hooks are written as MCNBT_STATS(...), which is expanded to nothing if the stats are disabled.
+
+#ifdef MCNBT_ENABLE_STATS
+
+#include <cstdint>      // uint64_t
+#include <cstddef>      // size_t
+#include <cstdio>       // snprintf()
+#include <chrono>       // steady_clock
+#include <mutex>        // mutex, lock_guard
+#include <string>       // string, to_string()
+
+namespace nbt
+{
+
+/// @brief The stats of a document, or the totals of the documents of a kind.
+/// @note The allocations are counted only if the counting allocator is installed, else 0.
+// (See #MCNBT_DEFINE_COUNTING_ALLOCATOR in mcnbt/allocation.hpp)
+struct CodecStats
+{
+    uint64_t documents          = 0;    ///< The count of documents.
+    uint64_t tags[13]           = {};   ///< The count of tags read or written, by the tag type.
+    uint64_t maxDepth           = 0;    ///< The deepest nesting of the tags read, the root is 0.
+    uint64_t bytes              = 0;    ///< The bytes of the (uncompressed) binary NBT parsed or written.
+    uint64_t compressedBytes    = 0;    ///< The bytes of Gzip data inflated or deflated.
+    uint64_t uncompressedBytes  = 0;    ///< The bytes output by inflate or input to deflate.
+    uint64_t allocations        = 0;    ///< The count of heap allocations.
+    uint64_t allocatedBytes     = 0;    ///< The bytes of heap allocations.
+    uint64_t ns                 = 0;    ///< The total time in nanoseconds.
+    uint64_t gzipNs             = 0;    ///< The time of inflate or deflate in nanoseconds.
+    uint64_t allocNs            = 0;    ///< The time of heap allocations and deallocations in nanoseconds.
+
+    /// @brief Get the time of the rest, i.e. decode or encode (and the I/O of the source or sink).
+    uint64_t codecNs() const { return ns > gzipNs + allocNs ? ns - gzipNs - allocNs : 0; }
+
+    /// @brief Get the count of tags of all types.
+    uint64_t tagCount() const
+    {
+        uint64_t count = 0;
+        for (uint64_t var : tags)
+            count += var;
+        return count;
+    }
+
+    CodecStats& operator+=(const CodecStats& other)
+    {
+        documents += other.documents;
+        for (size_t i = 0; i < 13; ++i)
+            tags[i] += other.tags[i];
+        maxDepth = maxDepth > other.maxDepth ? maxDepth : other.maxDepth;
+        bytes += other.bytes;
+        compressedBytes += other.compressedBytes;
+        uncompressedBytes += other.uncompressedBytes;
+        allocations += other.allocations;
+        allocatedBytes += other.allocatedBytes;
+        ns += other.ns;
+        gzipNs += other.gzipNs;
+        allocNs += other.allocNs;
+
+        return *this;
+    }
+};
+
+enum StatsKind
+{
+    SK_READ,
+    SK_WRITE,
+    SK_COMPRESS,
+    SK_DECOMPRESS,
+    SK_COUNT
+};
+
+inline const char* getStatsKindName(StatsKind kind)
+{
+    switch (kind)
+    {
+        case SK_READ:       return "read";
+        case SK_WRITE:      return "write";
+        case SK_COMPRESS:   return "compress";
+        case SK_DECOMPRESS: return "decompress";
+        default:            return "unknown";
+    }
+}
+
+/// @brief The callback of each document, called in the thread of the document.
+/// @attention Must not throw, and the reads and writes in it are not counted.
+using StatsCallback = void (*)(StatsKind kind, const CodecStats& stats, void* userData);
+
+struct _StatsRegistry
+{
+    std::mutex mutex;
+    CodecStats totals[SK_COUNT];
+    StatsCallback callback = nullptr;
+    void* userData = nullptr;
+};
+
+inline _StatsRegistry& _statsRegistry()
+{
+    static _StatsRegistry registry;
+    return registry;
+}
+
+/// @brief The stats of the document being handled by the calling thread, null if none.
+inline CodecStats*& _currentStats()
+{
+    static thread_local CodecStats* stats = nullptr;
+    return stats;
+}
+
+inline uint64_t _statsNow()
+{
+    return static_cast<uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+/// @brief Set the callback of each document, null to unset.
+inline void setStatsCallback(StatsCallback callback, void* userData = nullptr)
+{
+    _StatsRegistry& registry = _statsRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    registry.callback = callback;
+    registry.userData = userData;
+}
+
+/// @brief Get the totals of the documents of the kind since the start or #resetStats().
+inline CodecStats getStats(StatsKind kind)
+{
+    _StatsRegistry& registry = _statsRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    return registry.totals[kind];
+}
+
+inline void resetStats()
+{
+    _StatsRegistry& registry = _statsRegistry();
+    std::lock_guard<std::mutex> lock(registry.mutex);
+    for (auto& var : registry.totals)
+        var = CodecStats();
+}
+
+/// @brief Get the totals in the Prometheus text exposition format, e.g. for the /metrics endpoint.
+inline std::string getStatsText()
+{
+    static const char* const tagTypeNames[13] = {
+        "end", "byte", "short", "int", "long", "float", "double",
+        "byte_array", "string", "list", "compound", "int_array", "long_array"
+    };
+
+    CodecStats totals[SK_COUNT];
+    for (int i = 0; i < SK_COUNT; ++i)
+        totals[i] = getStats(static_cast<StatsKind>(i));
+
+    std::string text;
+    auto metric = [&](const char* name, const char* type, const char* help, uint64_t CodecStats::* field)
+    {
+        text += std::string("# HELP ") + name + " " + help + "\n";
+        text += std::string("# TYPE ") + name + " " + type + "\n";
+        for (int i = 0; i < SK_COUNT; ++i)
+        {
+            text += std::string(name) + "{kind=\"" + getStatsKindName(static_cast<StatsKind>(i)) + "\"} ";
+            text += std::to_string(totals[i].*field) + "\n";
+        }
+    };
+    auto seconds = [&](const char* phase, int kind, uint64_t ns)
+    {
+        char value[32];
+        std::snprintf(value, sizeof(value), "%.9f", ns / 1e9);
+        text += std::string("mcnbt_seconds_total{kind=\"") + getStatsKindName(static_cast<StatsKind>(kind));
+        text += std::string("\",phase=\"") + phase + "\"} " + value + "\n";
+    };
+
+    metric("mcnbt_documents_total", "counter", "The count of documents.", &CodecStats::documents);
+    metric("mcnbt_bytes_total", "counter", "The bytes of binary NBT parsed or written.", &CodecStats::bytes);
+    metric("mcnbt_compressed_bytes_total", "counter", "The bytes of Gzip data inflated or deflated.",
+           &CodecStats::compressedBytes);
+    metric("mcnbt_uncompressed_bytes_total", "counter", "The bytes output by inflate or input to deflate.",
+           &CodecStats::uncompressedBytes);
+    metric("mcnbt_allocations_total", "counter", "The count of heap allocations.", &CodecStats::allocations);
+    metric("mcnbt_allocated_bytes_total", "counter", "The bytes of heap allocations.", &CodecStats::allocatedBytes);
+    metric("mcnbt_max_depth", "gauge", "The deepest nesting of the tags read.", &CodecStats::maxDepth);
+
+    text += "# HELP mcnbt_tags_total The count of tags read or written.\n";
+    text += "# TYPE mcnbt_tags_total counter\n";
+    for (int i = 0; i < SK_COUNT; ++i)
+    {
+        for (size_t type = 0; type < 13; ++type)
+        {
+            if (totals[i].tags[type] == 0)
+                continue;
+
+            text += std::string("mcnbt_tags_total{kind=\"") + getStatsKindName(static_cast<StatsKind>(i));
+            text += std::string("\",type=\"") + tagTypeNames[type] + "\"} ";
+            text += std::to_string(totals[i].tags[type]) + "\n";
+        }
+    }
+
+    text += "# HELP mcnbt_seconds_total The time of documents by the phase.\n";
+    text += "# TYPE mcnbt_seconds_total counter\n";
+    for (int i = 0; i < SK_COUNT; ++i)
+    {
+        seconds("gzip", i, totals[i].gzipNs);
+        seconds("alloc", i, totals[i].allocNs);
+        seconds("codec", i, totals[i].codecNs());
+    }
+
+    return text;
+}
+
+/// @brief The document being handled by the calling thread, from construction to destruction.
+// If the thread is handling a document already, e.g. decompress while read, the stats are added to it instead.
+class _StatsScope
+{
+public:
+    explicit _StatsScope(StatsKind kind) : kind_(kind), isOwner_(_currentStats() == nullptr)
+    {
+        if (!isOwner_)
+            return;
+
+        _currentStats() = &stats_;
+        begin_ = _statsNow();
+    }
+
+    ~_StatsScope()
+    {
+        if (!isOwner_)
+            return;
+
+        stats_.ns = _statsNow() - begin_;
+        stats_.documents = 1;
+
+        _StatsRegistry& registry = _statsRegistry();
+        StatsCallback callback = nullptr;
+        void* userData = nullptr;
+        {
+            std::lock_guard<std::mutex> lock(registry.mutex);
+            registry.totals[kind_] += stats_;
+            callback = registry.callback;
+            userData = registry.userData;
+        }
+
+        // The callback is called out of the document, so its reads and writes are not added to it.
+        _currentStats() = nullptr;
+        if (callback)
+        {
+            _currentStats() = &ignored_;
+            callback(kind_, stats_, userData);
+            _currentStats() = nullptr;
+        }
+    }
+
+    _StatsScope(const _StatsScope&) = delete;
+    _StatsScope& operator=(const _StatsScope&) = delete;
+
+    /// @brief Get the stats of the document.
+    CodecStats& stats() { return *_currentStats(); }
+
+private:
+    StatsKind kind_;
+    bool isOwner_;
+    uint64_t begin_ = 0;
+    CodecStats stats_;
+    CodecStats ignored_;
+};
+
+// Get the count of bytes read from the source or written to the sink, 0 if it has no member function pos().
+template <typename Stream>
+auto _statsPos(const Stream& stream, int) -> decltype(static_cast<uint64_t>(stream.pos()))
+{
+    return static_cast<uint64_t>(stream.pos());
+}
+
+template <typename Stream>
+uint64_t _statsPos(const Stream&, long) { return 0; }
+
+/// @brief Add the bytes read from the source or written to the sink from construction to destruction, to the
+/// current document.
+template <typename Stream>
+class _StatsBytes
+{
+public:
+    explicit _StatsBytes(const Stream& stream) : stream_(stream), begin_(_statsPos(stream, 0)) {}
+
+    ~_StatsBytes()
+    {
+        if (_currentStats())
+            _currentStats()->bytes += _statsPos(stream_, 0) - begin_;
+    }
+
+    _StatsBytes(const _StatsBytes&) = delete;
+    _StatsBytes& operator=(const _StatsBytes&) = delete;
+
+private:
+    const Stream& stream_;
+    uint64_t begin_;
+};
+
+} // namespace nbt
+
+#define MCNBT_STATS(...) __VA_ARGS__
+
+#else
+
+#define MCNBT_STATS(...)
+
+#endif // MCNBT_ENABLE_STATS
+
+#endif // !MCNBT_STATS_HPP
@@ -0,0 +1,470 @@
+#ifndef MCNBT_TRANSCODE_HPP
+#define MCNBT_TRANSCODE_HPP
+
+#include "mcnbt.hpp"
+
+namespace nbt
+{
+
+// Transcode the binary NBT between encodings (e.g. Java edition to Bedrock edition) by walk the binary layout once,
+// without build the tag tree.
+
+/// @brief Check whether the binary NBT of two encodings have same size, that is can be transcoded in place.
+inline bool isSameLayout(Encoding from, Encoding to)
+{ return from == to || (from != EC_NETWORK && to != EC_NETWORK); }
+
+/// @brief Reverse the bytes of the numeric fields and length prefixes in place.
+class _InPlaceTranscoder
+{
+public:
+    _InPlaceTranscoder(char* data, size_t size, Encoding from)
+        : data_(data), src_(data, size), isBigEndian_(from == EC_BIG_ENDIAN) {}
+
+    void run()
+    {
+        while (!src_.eof())
+        {
+            TagType type = static_cast<TagType>(src_.get());
+            if (type == TT_END)
+                continue;
+
+            src_.skip(swap<UInt16>());
+            payload(type, 0);
+        }
+    }
+
+private:
+    // Read the number with the original endianness and reverse its bytes.
+    template <typename T>
+    T swap()
+    {
+        char* p = data_ + src_.pos();
+        T num = src_.readNum<T>(isBigEndian_);
+        _reverseEach(p, p, 1, sizeof(T));
+        return num;
+    }
+
+    // Reverse the bytes of the array of fixed width numbers.
+    void swapArray(size_t count, size_t width)
+    {
+        if (count > src_.remain() / width)
+            throw std::runtime_error("Unexpected end of data.");
+
+        char* p = data_ + src_.pos();
+        src_.skip(count * width);
+        _reverseEach(p, p, count, width);
+    }
+
+    size_t swapSize()
+    {
+        Int32 size = swap<Int32>();
+        if (size < 0)
+            throw std::runtime_error("Invalid negative size.");
+
+        return static_cast<size_t>(size);
+    }
+
+    void payload(TagType type, size_t depth)
+    {
+        switch (type)
+        {
+            case TT_BYTE:           src_.skip(1);                           break;
+            case TT_SHORT:          swap<Int16>();                          break;
+            case TT_INT:            swap<Int32>();                          break;
+            case TT_LONG:           swap<Int64>();                          break;
+            case TT_FLOAT:          swap<Int32>();                          break;
+            case TT_DOUBLE:         swap<Int64>();                          break;
+            case TT_BYTE_ARRAY:     src_.skip(swapSize());                  break;
+            case TT_STRING:         src_.skip(swap<UInt16>());              break;
+            case TT_INT_ARRAY:      swapArray(swapSize(), sizeof(Int32));   break;
+            case TT_LONG_ARRAY:     swapArray(swapSize(), sizeof(Int64));   break;
+            case TT_LIST:
+            {
+                if (depth >= _MAX_NESTING_DEPTH)
+                    throw std::runtime_error("The nesting depth is too deep.");
+
+                TagType itemType = static_cast<TagType>(src_.get());
+                size_t size = swapSize();
+
+                // The list of fixed width numbers is same as an array.
+                if (itemType == TT_BYTE)
+                    src_.skip(size);
+                else if (itemType == TT_SHORT)
+                    swapArray(size, sizeof(Int16));
+                else if (itemType == TT_INT || itemType == TT_FLOAT)
+                    swapArray(size, sizeof(Int32));
+                else if (itemType == TT_LONG || itemType == TT_DOUBLE)
+                    swapArray(size, sizeof(Int64));
+                else
+                    for (size_t i = 0; i < size; ++i)
+                        payload(itemType, depth + 1);
+
+                break;
+            }
+            case TT_COMPOUND:
+            {
+                if (depth >= _MAX_NESTING_DEPTH)
+                    throw std::runtime_error("The nesting depth is too deep.");
+
+                while (true)
+                {
+                    int childType = src_.get();
+                    if (childType == std::char_traits<char>::eof())
+                        throw std::runtime_error("Unexpected end of data.");
+
+                    if (childType == TT_END)
+                        break;
+
+                    src_.skip(swap<UInt16>());
+                    payload(static_cast<TagType>(childType), depth + 1);
+                }
+
+                break;
+            }
+            case TT_END:
+                break;
+            default:
+                throw std::runtime_error("Invalid tag type.");
+        }
+    }
+
+    char* data_;
+    BufferSource src_;
+    bool isBigEndian_;
+};
+
+/// @brief Re-encode the binary NBT to a new buffer.
+class _Transcoder
+{
+public:
+    _Transcoder(const char* data, size_t size, Encoding from, Encoding to, String& dst)
+        : src_(data, size), dst_(dst), from_(from), to_(to),
+          isSwapped_((from == EC_BIG_ENDIAN) != (to == EC_BIG_ENDIAN)) {}
+
+    void run()
+    {
+        while (!src_.eof())
+        {
+            int type = src_.get();
+            dst_.push_back(static_cast<char>(type));
+            if (type == TT_END)
+                continue;
+
+            string();
+            payload(static_cast<TagType>(type), 0);
+        }
+    }
+
+private:
+    // Copy the array of fixed width numbers with converting the byte order if needed.
+    void fixed(size_t count, size_t width)
+    {
+        if (count > src_.remain() / width)
+            throw std::runtime_error("Unexpected end of data.");
+
+        size_t bytes = count * width;
+        size_t pos = dst_.size();
+        dst_.resize(pos + bytes);
+
+        if (isSwapped_)
+            _reverseEach(&dst_[pos], src_.take(bytes), count, width);
+        else
+            std::memcpy(&dst_[pos], src_.take(bytes), bytes);
+    }
+
+    void putVarInt(UInt64 num)
+    {
+        char buffer[10];
+        dst_.append(buffer, _encodeVarInt(num, buffer));
+    }
+
+    void putInt32(Int32 num)
+    {
+        if (to_ == EC_NETWORK)
+        {
+            putVarInt(_zigzagEncode32(num));
+        }
+        else
+        {
+            char buffer[sizeof(Int32)];
+            _storeNum<Int32>(num, buffer, to_ == EC_BIG_ENDIAN);
+            dst_.append(buffer, sizeof(Int32));
+        }
+    }
+
+    void putInt64(Int64 num)
+    {
+        if (to_ == EC_NETWORK)
+        {
+            putVarInt(_zigzagEncode64(num));
+        }
+        else
+        {
+            char buffer[sizeof(Int64)];
+            _storeNum<Int64>(num, buffer, to_ == EC_BIG_ENDIAN);
+            dst_.append(buffer, sizeof(Int64));
+        }
+    }
+
+    size_t size()
+    {
+        size_t size = src_.readSize(from_);
+        putInt32(static_cast<Int32>(size));
+        return size;
+    }
+
+    // Tag name or string value.
+    void string()
+    {
+        size_t len = src_.readStringLength(from_);
+
+        if (to_ == EC_NETWORK)
+        {
+            putVarInt(len);
+        }
+        else
+        {
+            if (len > 0xFFFF)
+                throw std::runtime_error("The string is too long for the encoding.");
+
+            char buffer[sizeof(UInt16)];
+            _storeNum<UInt16>(static_cast<UInt16>(len), buffer, to_ == EC_BIG_ENDIAN);
+            dst_.append(buffer, sizeof(UInt16));
+        }
+
+        dst_.append(src_.take(len), len);
+    }
+
+    // The item of the array or list of Int or Long.
+    void integers(size_t count, size_t width)
+    {
+        if (from_ != EC_NETWORK && to_ != EC_NETWORK)
+        {
+            fixed(count, width);
+            return;
+        }
+
+        for (size_t i = 0; i < count; ++i)
+        {
+            if (width == sizeof(Int32))
+                putInt32(src_.readInt32(from_));
+            else
+                putInt64(src_.readInt64(from_));
+        }
+    }
+
+    void payload(TagType type, size_t depth)
+    {
+        switch (type)
+        {
+            case TT_BYTE:           fixed(1, 1);                                break;
+            case TT_SHORT:          fixed(1, sizeof(Int16));                    break;
+            case TT_INT:            putInt32(src_.readInt32(from_));            break;
+            case TT_LONG:           putInt64(src_.readInt64(from_));            break;
+            case TT_FLOAT:          fixed(1, sizeof(Fp32));                     break;
+            case TT_DOUBLE:         fixed(1, sizeof(Fp64));                     break;
+            case TT_BYTE_ARRAY:     fixed(size(), 1);                           break;
+            case TT_STRING:         string();                                   break;
+            case TT_INT_ARRAY:      integers(size(), sizeof(Int32));            break;
+            case TT_LONG_ARRAY:     integers(size(), sizeof(Int64));            break;
+            case TT_LIST:
+            {
+                if (depth >= _MAX_NESTING_DEPTH)
+                    throw std::runtime_error("The nesting depth is too deep.");
+
+                TagType itemType = static_cast<TagType>(src_.get());
+                dst_.push_back(static_cast<char>(itemType));
+                size_t count = size();
+
+                if (itemType == TT_BYTE)
+                    fixed(count, 1);
+                else if (itemType == TT_SHORT)
+                    fixed(count, sizeof(Int16));
+                else if (itemType == TT_FLOAT)
+                    fixed(count, sizeof(Fp32));
+                else if (itemType == TT_DOUBLE)
+                    fixed(count, sizeof(Fp64));
+                else if (itemType == TT_INT)
+                    integers(count, sizeof(Int32));
+                else if (itemType == TT_LONG)
+                    integers(count, sizeof(Int64));
+                else
+                    for (size_t i = 0; i < count; ++i)
+                        payload(itemType, depth + 1);
+
+                break;
+            }
+            case TT_COMPOUND:
+            {
+                if (depth >= _MAX_NESTING_DEPTH)
+                    throw std::runtime_error("The nesting depth is too deep.");
+
+                while (true)
+                {
+                    int childType = src_.get();
+                    if (childType == std::char_traits<char>::eof())
+                        throw std::runtime_error("Unexpected end of data.");
+
+                    dst_.push_back(static_cast<char>(childType));
+                    if (childType == TT_END)
+                        break;
+
+                    string();
+                    payload(static_cast<TagType>(childType), depth + 1);
+                }
+
+                break;
+            }
+            case TT_END:
+                break;
+            default:
+                throw std::runtime_error("Invalid tag type.");
+        }
+    }
+
+    BufferSource src_;
+    String& dst_;
+    Encoding from_;
+    Encoding to_;
+    bool isSwapped_;
+};
+
+/// @brief Transcode the binary NBT in place.
+/// @note Only be used if #isSameLayout(from, to) is true, that is between big endian and little endian.
+inline void transcodeInPlace(char* data, size_t size, Encoding from, Encoding to)
+{
+    if (!isSameLayout(from, to))
+        throw std::logic_error("Can't transcode in place between encodings of different layout.");
+
+    if (from == to)
+        return;
+
+    _InPlaceTranscoder(data, size, from).run();
+}
+
+/// @overload
+inline void transcodeInPlace(String& data, Encoding from, Encoding to)
+{
+    if (!data.empty())
+        transcodeInPlace(&data[0], data.size(), from, to);
+}
+
+/// @brief Transcode the binary NBT to a new buffer.
+/// @note The data can contains multiple root tags one after another.
+inline String transcode(const char* data, size_t size, Encoding from, Encoding to)
+{
+    String dst;
+
+    // Copy all at memory bandwidth and then fix the fields in place.
+    if (isSameLayout(from, to))
+    {
+        dst.assign(data, size);
+        transcodeInPlace(dst, from, to);
+        return dst;
+    }
+
+    // The network encoding is usually smaller than the other, reserve for the worst case of common data.
+    dst.reserve(size + size / 4);
+    _Transcoder(data, size, from, to, dst).run();
+
+    return dst;
+}
+
+/// @overload
+inline String transcode(const String& data, Encoding from, Encoding to)
+{
+    return transcode(data.data(), data.size(), from, to);
+}
+
+/// @brief Transcode the content of a nbt file, the regular file is mapped to memory (or read to a buffer of exact
+// size) instead of copied through the streams. (See #transcodeFile())
+inline String _transcodeFileContent(const String& srcFile, Encoding from, Encoding to)
+{
+    _File file(srcFile);
+
+    Vec<Byte> buffer;
+    std::unique_ptr<_FileContent> mapped;
+    const char* data = nullptr;
+    size_t size = 0;
+
+    Int64 fileSize = file.size();
+    if (fileSize < 0)
+    {
+        FileSource src(file.fd());
+        _readRemain(src, buffer);
+        data = buffer.data();
+        size = buffer.size();
+    }
+    else
+    {
+        if (static_cast<UInt64>(fileSize) > static_cast<UInt64>(SIZE_MAX))
+            throw std::runtime_error("The file is too large: " + srcFile);
+
+        mapped.reset(new _FileContent(file, static_cast<size_t>(fileSize)));
+        data = mapped->data();
+        size = mapped->size();
+    }
+
+#ifdef MCNBT_ENABLE_GZIP
+    if (gzip::isCompressed(data, size))
+    {
+        String content = gzip::decompress(data, size);
+        if (isSameLayout(from, to))
+            transcodeInPlace(content, from, to);
+        else
+            content = transcode(content, from, to);
+
+        return content;
+    }
+#endif // MCNBT_ENABLE_GZIP
+
+    return transcode(data, size, from, to);
+}
+
+#ifdef MCNBT_ENABLE_GZIP
+/// @brief Transcode a nbt file to another file.
+/// @note The source file is decompressed automatically if it is compressed.
+inline void transcodeFile(const String& srcFile, const String& dstFile, Encoding from, Encoding to,
+                          bool isCompressed = false)
+{
+    String content = _transcodeFileContent(srcFile, from, to);
+
+    _File file(dstFile, false);
+    {
+        FileSink sink(file.fd());
+        if (isCompressed)
+        {
+            gzip::CompressSink<FileSink> csink(sink);
+            csink.write(content.data(), content.size());
+            csink.finish();
+        }
+        else
+        {
+            sink.write(content.data(), content.size());
+        }
+
+        sink.flush();
+    }
+
+    file.close();
+}
+#else
+/// @brief Transcode a nbt file to another file.
+inline void transcodeFile(const String& srcFile, const String& dstFile, Encoding from, Encoding to)
+{
+    String content = _transcodeFileContent(srcFile, from, to);
+
+    _File file(dstFile, false);
+    {
+        FileSink sink(file.fd());
+        sink.write(content.data(), content.size());
+        sink.flush();
+    }
+
+    file.close();
+}
+#endif // MCNBT_ENABLE_GZIP
+
+} // namespace nbt
+
+#endif // !MCNBT_TRANSCODE_HPP